@@ -0,0 +1,19 @@
+#pragma once
+#include <Async/Executor.hpp>
+#include <Async/Runtime.hpp>
+#include <benchmark/benchmark.h>
+#include <map>
+#include <memory>
+
+using MultiRuntime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+// one runtime per worker count for the whole run, starting threads is not what is measured
+inline auto GetRuntime(size_t workers) -> MultiRuntime&
+{
+  static auto runtimes = std::map<size_t, std::unique_ptr<MultiRuntime>> {};
+  auto& runtime = runtimes[workers];
+  if (runtime == nullptr) {
+    runtime = std::make_unique<MultiRuntime>(workers);
+  }
+  return *runtime;
+}
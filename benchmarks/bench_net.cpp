@@ -0,0 +1,59 @@
+#include "bench_common.hpp"
+#include <Async/Net.hpp>
+#include <vector>
+
+// one request of `size` bytes written to a loopback echo server and read back
+static void BM_TcpEcho(benchmark::State& state)
+{
+  auto& runtime = GetRuntime(2);
+  auto const size = static_cast<size_t>(state.range(0));
+  runtime.block([&runtime, &state, size]() -> async::Task<> {
+    auto listener = async::TcpListener::Bind(runtime.reactor(), async::SocketAddr::V4(INADDR_LOOPBACK, 0));
+    if (!listener) {
+      state.SkipWithError("bind failed");
+      co_return;
+    }
+    auto server = async::JoinHandle([](async::TcpListener& listener, size_t size) -> async::Task<> {
+      auto stream = co_await listener.accept();
+      if (!stream) {
+        co_return;
+      }
+      auto buf = std::vector<std::byte>(size);
+      while (true) {
+        auto n = co_await stream->read(buf);
+        if (!n || n.value() == 0 || !co_await stream->writeAll(std::span(buf).first(n.value()))) {
+          co_return;
+        }
+      }
+    }(*listener, size));
+    runtime.spawn(server);
+
+    auto client = co_await async::TcpStream::Connect(runtime.reactor(), listener->localAddr().value());
+    if (!client) {
+      state.SkipWithError("connect failed");
+      co_await server.join();
+      co_return;
+    }
+    static_cast<void>(client->setNoDelay(true));
+    auto request = std::vector<std::byte>(size, std::byte {42});
+    auto response = std::vector<std::byte>(size);
+    for (auto _ : state) {
+      if (!co_await client->writeAll(request)) {
+        state.SkipWithError("write failed");
+        break;
+      }
+      for (size_t got = 0; got < size;) {
+        auto n = co_await client->read(std::span(response).subspan(got));
+        if (!n || n.value() == 0) {
+          state.SkipWithError("read failed");
+          break;
+        }
+        got += n.value();
+      }
+    }
+    static_cast<void>(client->shutdown());
+    co_await server.join();
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(size) * 2);
+  }());
+}
+BENCHMARK(BM_TcpEcho)->Arg(64)->Arg(4096)->Arg(65536)->UseRealTime();
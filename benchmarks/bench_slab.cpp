@@ -0,0 +1,83 @@
+#include "Async/Slab.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// churns a slab the way the timer wheel does: a steady population with random removals and inserts, plus a full
+// sweep now and then
+struct Node {
+  uint64_t when;
+  size_t id;
+  void* handle;
+  size_t prev;
+  size_t next;
+  uint32_t level;
+  uint32_t slot;
+};
+
+template <typename S>
+auto Churn(char const* name, size_t population, size_t rounds) -> void
+{
+  auto slab = S {};
+  auto keys = std::vector<size_t> {};
+  auto rng = std::mt19937_64 {42};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < population; ++i) {
+    keys.push_back(slab.insert(Node {i, i, nullptr, 0, 0, 0, 0}));
+  }
+  auto sum = uint64_t {0};
+  for (size_t round = 0; round < rounds; ++round) {
+    auto& key = keys[rng() % keys.size()];
+    sum += slab.tryRemove(key)->when;
+    key = slab.insert(Node {round, round, nullptr, 0, 0, 0, 0});
+    if (round % population == 0) {
+      for (auto k : keys) {
+        sum += slab[k].id;
+      }
+    }
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-12s population %8zu: %6.1f ns/op (%llu)\n", name, population, elapsed / double(rounds),
+              static_cast<unsigned long long>(sum));
+}
+
+template <typename S>
+auto Sweep(char const* name, size_t population, size_t rounds) -> void
+{
+  auto slab = S {};
+  for (size_t i = 0; i < population; ++i) {
+    slab.insert(Node {i, i, nullptr, 0, 0, 0, 0});
+  }
+  for (size_t key = 0; key < population; key += 4) {
+    slab.tryRemove(key);
+  }
+  auto sum = uint64_t {0};
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < rounds; ++round) {
+    if constexpr (requires { slab.forEach([](size_t, Node&) {}); }) {
+      slab.forEach([&](size_t, Node& node) { sum += node.when; });
+    } else {
+      for (size_t key = 0; key < population; ++key) {
+        if (auto node = slab.get(key)) {
+          sum += node->when;
+        }
+      }
+    }
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-12s sweep %8zu: %6.2f ns/entry (%llu)\n", name, population,
+              elapsed / double(rounds * population * 3 / 4), static_cast<unsigned long long>(sum));
+}
+
+auto main() -> int
+{
+  for (auto population : {size_t {1} << 10, size_t {1} << 16, size_t {1} << 20}) {
+    Churn<Slab<Node>>("Slab", population, 4'000'000);
+    Churn<ChunkedSlab<Node>>("ChunkedSlab", population, 4'000'000);
+  }
+  for (auto population : {size_t {1} << 10, size_t {1} << 16, size_t {1} << 20}) {
+    Sweep<Slab<Node>>("Slab", population, (size_t {1} << 24) / population);
+    Sweep<ChunkedSlab<Node>>("ChunkedSlab", population, (size_t {1} << 24) / population);
+  }
+}
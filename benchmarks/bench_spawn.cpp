@@ -0,0 +1,34 @@
+#include "bench_common.hpp"
+
+// detached trivial tasks spawned from a worker, `block` returns once every one of them finished
+static void BM_SpawnDetach(benchmark::State& state)
+{
+  auto& runtime = GetRuntime(state.range(0));
+  auto const count = state.range(1);
+  for (auto _ : state) {
+    runtime.block([&runtime, count]() -> async::Task<> {
+      for (int64_t i = 0; i < count; ++i) {
+        runtime.spawnDetach([]() -> async::Task<> { co_return; }());
+      }
+      co_return;
+    }());
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SpawnDetach)->ArgsProduct({{1, 2, 4}, {10'000}})->UseRealTime();
+
+// spawn one task and wait for its result, the time from spawn to the joining coroutine running again
+static void BM_JoinRoundTrip(benchmark::State& state)
+{
+  auto& runtime = GetRuntime(state.range(0));
+  runtime.block([&runtime, &state]() -> async::Task<> {
+    auto sum = int64_t {0};
+    for (auto _ : state) {
+      auto join = async::JoinHandle([](int64_t v) -> async::Task<int64_t> { co_return v + 1; }(sum));
+      runtime.spawn(join);
+      sum = co_await join.join();
+    }
+    benchmark::DoNotOptimize(sum);
+  }());
+}
+BENCHMARK(BM_JoinRoundTrip)->Arg(1)->Arg(4)->UseRealTime();
@@ -0,0 +1,68 @@
+#include "bench_common.hpp"
+#include <Async/Primitives.hpp>
+
+// `coroutines` tasks taking the same mutex `ROUNDS` times each
+static void BM_MutexContention(benchmark::State& state)
+{
+  static constexpr int64_t ROUNDS = 1000;
+  auto& runtime = GetRuntime(4);
+  auto const coroutines = state.range(0);
+  auto mutex = async::Mutex {};
+  auto counter = int64_t {0};
+  for (auto _ : state) {
+    runtime.block([&]() -> async::Task<> {
+      for (int64_t i = 0; i < coroutines; ++i) {
+        runtime.spawnDetach([](async::Mutex& mutex, int64_t& counter) -> async::Task<> {
+          for (int64_t round = 0; round < ROUNDS; ++round) {
+            co_await mutex.lock();
+            counter += 1;
+            mutex.unlock();
+          }
+        }(mutex, counter));
+      }
+      co_return;
+    }());
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * coroutines * ROUNDS);
+}
+BENCHMARK(BM_MutexContention)->RangeMultiplier(4)->Range(1, 64)->UseRealTime();
+
+// goes to the back of the executor's queue, lets the other side of a ping-pong get to its wait on a single worker
+struct Requeue {
+  auto await_ready() const noexcept -> bool { return false; }
+  auto await_suspend(std::coroutine_handle<> handle) const -> void { async::ExecutorRef::Current().execute(handle); }
+  auto await_resume() const noexcept -> void {}
+};
+
+// two coroutines handing a turn back and forth through two condition variables, one item is a round trip
+static void BM_CondVarPingPong(benchmark::State& state)
+{
+  static constexpr int64_t ROUNDS = 10'000;
+  auto& runtime = GetRuntime(state.range(0));
+  for (auto _ : state) {
+    runtime.block([&runtime]() -> async::Task<> {
+      auto ping = async::CondVar {};
+      auto pong = async::CondVar {};
+      auto ponger = async::JoinHandle([](async::CondVar& ping, async::CondVar& pong) -> async::Task<> {
+        for (int64_t round = 0; round < ROUNDS; ++round) {
+          co_await ping.wait();
+          // a notify without a waiter is lost, retry until the pinger got to its wait
+          while (!pong.notify_one()) {
+            co_await Requeue {};
+          }
+        }
+      }(ping, pong));
+      runtime.spawn(ponger);
+      for (int64_t round = 0; round < ROUNDS; ++round) {
+        while (!ping.notify_one()) {
+          co_await Requeue {};
+        }
+        co_await pong.wait();
+      }
+      co_await ponger.join();
+    }());
+  }
+  state.SetItemsProcessed(state.iterations() * ROUNDS);
+}
+BENCHMARK(BM_CondVarPingPong)->Arg(1)->Arg(2)->UseRealTime();
@@ -0,0 +1,22 @@
+#include "bench_common.hpp"
+#include <chrono>
+
+// `timers` coroutines sleeping at once, their deadlines spread over a millisecond; one item is a timer inserted,
+// fired and its coroutine resumed
+static void BM_Sleep(benchmark::State& state)
+{
+  auto& runtime = GetRuntime(4);
+  auto const timers = state.range(0);
+  for (auto _ : state) {
+    runtime.block([&runtime, timers]() -> async::Task<> {
+      for (int64_t i = 0; i < timers; ++i) {
+        runtime.spawnDetach([](std::chrono::nanoseconds delay) -> async::Task<> {
+          co_await async::sleep(delay);
+        }(std::chrono::microseconds(1000 * i / timers)));
+      }
+      co_return;
+    }());
+  }
+  state.SetItemsProcessed(state.iterations() * timers);
+}
+BENCHMARK(BM_Sleep)->RangeMultiplier(10)->Range(10'000, 1'000'000)->Unit(benchmark::kMillisecond)->UseRealTime();
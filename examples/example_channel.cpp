@@ -0,0 +1,33 @@
+#include <Async/Channel.hpp>
+#include <Async/Executor.hpp>
+#include <cstdio>
+int main()
+{
+  using RT = async::Runtime<async::MultiThreadExecutor>;
+  RT::Init(4);
+
+  RT::Block([]() -> async::Task<> {
+    auto channel = std::make_shared<async::Channel<int>>(32);
+    auto done = std::make_shared<async::Latch>(1);
+    RT::SpawnDetach([](auto channel, auto done) -> async::Task<> {
+      auto batch = std::vector<int> {};
+      auto sum = 0L;
+      auto wakeups = 0;
+      while (co_await channel->recv_many(batch, 16) != 0) {
+        for (auto value : batch) {
+          sum += value;
+        }
+        batch.clear();
+        wakeups += 1;
+      }
+      printf("sum %ld in %d wakeups\n", sum, wakeups);
+      done->count_down();
+    }(channel, done));
+
+    for (auto i = 0; i < 10000; ++i) {
+      co_await channel->send(i); // suspends while the consumer is 32 values behind
+    }
+    channel->close();
+    co_await done->wait();
+  }());
+}
@@ -0,0 +1,55 @@
+#include <Async/Executor.hpp>
+#include <Async/Generator.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using RT = async::Runtime<async::MultiThreadExecutor>;
+using namespace std::chrono_literals;
+
+auto fibonacci(int count) -> async::Generator<long>
+{
+  auto a = 0L;
+  auto b = 1L;
+  for (auto i = 0; i < count; ++i) {
+    co_yield a;
+    a = std::exchange(b, a + b);
+  }
+}
+
+// one page at a time, as if each came from a remote fetch
+auto pages(int count) -> async::AsyncGenerator<std::vector<std::string>>
+{
+  for (auto page = 0; page < count; ++page) {
+    co_await RT::Sleep(1ms);
+    auto records = std::vector<std::string> {};
+    for (auto i = 0; i < 4; ++i) {
+      records.push_back("record " + std::to_string(page * 4 + i));
+    }
+    co_yield std::move(records);
+  }
+}
+
+int main()
+{
+  RT::Init(4);
+  for (auto value : fibonacci(10)) {
+    printf("%ld ", value);
+  }
+  printf("\n");
+
+  RT::Block([]() -> async::Task<> {
+    auto stream = pages(3);
+    while (auto page = co_await stream.next()) {
+      auto records = std::move(*page); // moved out of the generator frame
+      printf("page of %zu, first: %s\n", records.size(), records.front().c_str());
+    }
+    auto total = 0;
+    auto again = pages(2);
+    for (auto it = co_await again.begin(); it != again.end(); co_await ++it) {
+      total += static_cast<int>(it->size());
+    }
+    printf("%d records\n", total);
+  }());
+}
@@ -0,0 +1,37 @@
+#include <Async/Channel.hpp>
+#include <Async/Executor.hpp>
+#include <Async/utils/Metrics.hpp>
+#include <chrono>
+#include <cstdio>
+using namespace std::chrono_literals;
+
+// configure with -DAsyncTask_METRICS=ON, otherwise every number is zero
+int main()
+{
+  auto runtime = async::RuntimeInstance<async::MultiThreadExecutor>(4);
+  runtime.block([&runtime]() -> async::Task<> {
+    auto done = async::Channel<int>(1024);
+    for (int i = 0; i < 1000; ++i) {
+      runtime.spawnDetach([](async::Channel<int>& done, int i) -> async::Task<> {
+        co_await async::sleep(std::chrono::microseconds(i % 50));
+        co_await done.send(i);
+      }(done, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+      co_await done.recv();
+    }
+  }());
+
+  auto snapshot = async::Metrics::snapshot();
+  for (auto const& thread : snapshot.threads) {
+    if (thread.worker) {
+      printf("worker %zu: %lu tasks, %lu/%lu steals, %lu parks, %lu spurious wakeups\n", *thread.worker,
+             thread[async::Counter::Tasks], thread[async::Counter::Steals], thread[async::Counter::StealAttempts],
+             thread[async::Counter::Parks], thread[async::Counter::SpuriousWakeups]);
+    }
+  }
+  auto const& delay = snapshot.total[async::Histogram::ScheduleDelay];
+  printf("schedule delay p50 %luns p99 %luns max %luns over %lu samples\n", delay.percentile(0.5),
+         delay.percentile(0.99), delay.max, delay.count);
+  printf("%s", snapshot.toPrometheus().c_str());
+}
@@ -50,8 +50,9 @@ auto case2() -> void
   }());
   auto end = std::chrono::high_resolution_clock::now();
   printf("time: %ld\n", std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count());
+  // without the mutex increments can get lost, but nothing guarantees they do: children spawned from a worker stay on
+  // that worker unless another one steals them
   printf("cnt: %d\n", cnt);
-  assert(cnt != 1'000'000);
 }
 
 int main()
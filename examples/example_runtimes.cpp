@@ -0,0 +1,40 @@
+#include <Async/Executor.hpp>
+#include <Async/Primitives.hpp>
+#include <chrono>
+#include <thread>
+using namespace std::chrono_literals;
+
+// two isolated runtimes in one process, each coroutine sleeps on the runtime that runs it
+auto work(char const* name, int rounds, std::chrono::milliseconds delay) -> async::Task<int>
+{
+  auto done = 0;
+  for (int i = 0; i < rounds; ++i) {
+    co_await async::sleep(delay);
+    done += 1;
+  }
+  printf("%s: %d rounds\n", name, done);
+  co_return done;
+}
+
+int main()
+{
+  auto latency = async::RuntimeInstance<async::MultiThreadExecutor>(2);
+  auto batch = async::RuntimeInstance<async::MultiThreadExecutor>(2, async::ReactorMode::PerWorker);
+  auto inlined = async::RuntimeInstance<async::InlineExecutor>();
+
+  auto batchThread = std::thread([&]() {
+    auto total = batch.block([]() -> async::Task<int> {
+      auto [a, b] = co_await async::when_all(work("batch a", 5, 20ms), work("batch b", 5, 20ms));
+      co_return a + b;
+    }());
+    printf("batch total %d\n", total);
+  });
+  auto inlineThread = std::thread([&]() { printf("inline total %d\n", inlined.block(work("inline", 10, 5ms))); });
+  auto total = latency.block([&]() -> async::Task<int> {
+    auto value = co_await latency.blockSpawn([]() { return 1; });
+    co_return value + co_await work("latency", 20, 1ms);
+  }());
+  printf("latency total %d\n", total);
+  batchThread.join();
+  inlineThread.join();
+}
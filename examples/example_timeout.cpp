@@ -0,0 +1,24 @@
+#include <Async/Executor.hpp>
+#include <Async/Select.hpp>
+#include <chrono>
+using namespace std::chrono_literals;
+int main()
+{
+  using RT = async::Runtime<async::MultiThreadExecutor>;
+  RT::Init(4);
+
+  RT::Block([]() -> async::Task<> {
+    auto work = [](std::chrono::milliseconds delay, int value) -> async::Task<int> {
+      co_await RT::Sleep(delay);
+      co_return value;
+    };
+    auto fast = co_await RT::Timeout(200ms, work(10ms, 1));
+    printf("fast: %s\n", fast ? "finished" : "timed out");
+    auto slow = co_await RT::Timeout(50ms, work(1s, 2));
+    printf("slow: %s\n", slow ? "finished" : "timed out");
+
+    auto winner = co_await async::select(work(300ms, 1), work(20ms, 2));
+    printf("select winner index %zu value %d\n", winner.index(), std::get<1>(winner));
+    co_await RT::Sleep(10ms); // the losers were stopped, they only have to unwind
+  }());
+}
@@ -0,0 +1,277 @@
+#pragma once
+#include "Async/Primitives.hpp"
+#include "Async/Reactor.hpp"
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace async {
+class BufferPool;
+
+// A buffer borrowed from a `BufferPool`, it goes back when dropped or released. Move only and not synchronized, one
+// owner at a time.
+class PooledBuffer {
+public:
+  PooledBuffer() = default;
+  PooledBuffer(PooledBuffer const&) = delete;
+  PooledBuffer(PooledBuffer&& other) noexcept
+      : mPool(std::exchange(other.mPool, nullptr)), mId(other.mId), mBid(other.mBid),
+        mSize(std::exchange(other.mSize, 0))
+  {
+  }
+  PooledBuffer& operator=(PooledBuffer const&) = delete;
+  PooledBuffer& operator=(PooledBuffer&& other) noexcept
+  {
+    if (this != &other) {
+      release();
+      mPool = std::exchange(other.mPool, nullptr);
+      mId = other.mId;
+      mBid = other.mBid;
+      mSize = std::exchange(other.mSize, 0);
+    }
+    return *this;
+  }
+  ~PooledBuffer() { release(); }
+
+  explicit operator bool() const noexcept { return mPool != nullptr; }
+  auto data() const noexcept -> std::byte*;
+  auto capacity() const noexcept -> size_t;
+  // bytes filled in, set by the read that borrowed it
+  auto size() const noexcept -> size_t { return mSize; }
+  auto setSize(size_t size) noexcept -> void
+  {
+    assert(size <= capacity());
+    mSize = size;
+  }
+  // the filled part
+  auto bytes() const noexcept -> std::span<std::byte> { return {data(), mSize}; }
+  // the whole buffer
+  auto buffer() const noexcept -> std::span<std::byte> { return {data(), capacity()}; }
+  // hand it back now, the handle is empty afterwards
+  auto release() noexcept -> void;
+
+private:
+  friend class BufferPool;
+  PooledBuffer(BufferPool* pool, uint32_t id, int32_t bid) noexcept : mPool(pool), mId(id), mBid(bid) {}
+
+  BufferPool* mPool = nullptr;
+  uint32_t mId = 0;
+  int32_t mBid = -1; // id in the provided group it goes back to, -1 for the free list
+  size_t mSize = 0;
+};
+
+// Fixed-size read buffers shared by many connections, so memory follows the traffic and not the connection count.
+// Buffers are carved from page aligned chunks allocated on first use and kept until the pool goes. The free list is
+// a tagged Treiber stack like the source registry's: it hands out the most recently returned, still warm buffer
+// first. A borrower that finds every buffer taken waits in `acquire` until one comes back.
+//
+// `provide` hands part of the pool to a reactor's io_uring as a provided buffer group: `TcpStream::read(pool)` then
+// leaves the recv to the kernel, which only picks a buffer once data arrived, and a dropped buffer is provided again
+// by a submission nobody waits for.
+class BufferPool {
+  using Waiter = detail::Waiter;
+  static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+public:
+  static constexpr size_t DEFAULT_BUFFER_SIZE = 16 * 1024;
+  static constexpr size_t CHUNK_BUFFERS = 64;     // buffers allocated at once
+  static constexpr size_t MAX_PROVIDED = 65536;    // the buffer ids the kernel reports are 16 bit
+
+  // `bufferSize` is rounded up to a multiple of 64, `maxBuffers` to one of CHUNK_BUFFERS
+  explicit BufferPool(size_t bufferSize = DEFAULT_BUFFER_SIZE, size_t maxBuffers = 4096);
+  BufferPool(BufferPool const&) = delete;
+  BufferPool& operator=(BufferPool const&) = delete;
+  // every buffer must be back, no recv may be pending on the provided group and its reactor must still live
+  ~BufferPool();
+
+  struct AcquireAwaiter {
+    struct BufferWaiter : Waiter {
+      uint32_t id = NONE;
+    };
+    BufferPool& pool;
+    BufferWaiter waiter {{nullptr, nullptr, {}}};
+
+    auto await_ready() noexcept -> bool
+    {
+      waiter.id = pool.pop();
+      return waiter.id != NONE;
+    }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      waiter.prepare(handle);
+      pool.mLock.lock();
+      pool.mWaiting.fetch_add(1, std::memory_order_seq_cst);
+      pool.mWaiters.push(&waiter);
+      // pairs with the fence in `giveBack`: either it sees us waiting or we see its buffer
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto id = pool.pop();
+      if (id == NONE) {
+        pool.mLock.unlock();
+        return true;
+      }
+      // the buffer belongs to the oldest waiter
+      auto first = static_cast<BufferWaiter*>(pool.mWaiters.pop());
+      pool.mWaiting.fetch_sub(1, std::memory_order_relaxed);
+      pool.mLock.unlock();
+      first->id = id;
+      if (first == &waiter) {
+        return false;
+      }
+      first->resume();
+      return true;
+    }
+    auto await_resume() noexcept -> PooledBuffer { return pool.wrap(waiter.id, -1); }
+  };
+
+  auto bufferSize() const noexcept -> size_t { return mBufferSize; }
+  auto maxBuffers() const noexcept -> size_t { return mMaxBuffers; }
+  // buffers borrowed right now, from the free list or the provided group
+  auto inUse() const noexcept -> size_t { return mInUse.load(std::memory_order_relaxed); }
+  // bytes of buffer memory allocated so far, the high water mark of the pool
+  auto reserved() const noexcept -> size_t
+  {
+    return mChunkCount.load(std::memory_order_relaxed) * CHUNK_BUFFERS * mBufferSize;
+  }
+
+  // empty when every buffer is borrowed
+  [[nodiscard]] auto tryAcquire() noexcept -> PooledBuffer
+  {
+    auto id = pop();
+    return id == NONE ? PooledBuffer {} : wrap(id, -1);
+  }
+  // suspends until a buffer comes back when every one is borrowed, waiters are served in order; not cancellable
+  [[nodiscard]] auto acquire() noexcept -> AcquireAwaiter { return AcquireAwaiter {*this}; }
+
+  // Hands `count` buffers, at most MAX_PROVIDED, to `reactor`'s io_uring as a provided buffer group. Once per pool
+  // and finished before reads use it; fails with `function_not_supported` without io_uring and with the kernel's
+  // error before 5.7, reads then stay readiness based.
+  [[nodiscard]] auto provide(Reactor& reactor, size_t count) -> Task<StdResult<void>>;
+  // the buffer group to recv with on `reactor`, none when the pool was not provided to it
+  auto providedGroup(Reactor const& reactor) const noexcept -> std::optional<uint16_t>
+  {
+    if (mProvided == nullptr || mProvided->reactor != &reactor) {
+      return std::nullopt;
+    }
+    return mProvided->group;
+  }
+  // takes over the buffer a provided recv completed with, `flags` are its cqe flags; empty when it picked none
+  [[nodiscard]] auto fromCompletion(uint32_t flags, size_t size) noexcept -> PooledBuffer;
+
+private:
+  friend class PooledBuffer;
+  struct Chunk {
+    std::byte* memory = nullptr;
+    std::array<std::atomic_uint32_t, CHUNK_BUFFERS> nextFree {};
+  };
+  struct Provided {
+    Reactor* reactor = nullptr;
+    uint16_t group = 0;
+    std::vector<uint32_t> ids; // pool buffer of each buffer id the kernel reports
+  };
+
+  auto dataOf(uint32_t id) const noexcept -> std::byte*
+  {
+    auto chunk = mChunks[id / CHUNK_BUFFERS].load(std::memory_order_acquire);
+    return chunk->memory + (id % CHUNK_BUFFERS) * mBufferSize;
+  }
+  auto wrap(uint32_t id, int32_t bid) noexcept -> PooledBuffer
+  {
+    mInUse.fetch_add(1, std::memory_order_relaxed);
+    return PooledBuffer {this, id, bid};
+  }
+  auto giveBack(uint32_t id, int32_t bid) noexcept -> void
+  {
+    mInUse.fetch_sub(1, std::memory_order_relaxed);
+    if (bid >= 0 && reprovide(static_cast<uint16_t>(bid))) {
+      return;
+    }
+    push(id);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mWaiting.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    auto woken = detail::WaiterQueue {};
+    mLock.lock();
+    while (!mWaiters.empty()) {
+      auto next = pop();
+      if (next == NONE) {
+        break;
+      }
+      auto waiter = static_cast<AcquireAwaiter::BufferWaiter*>(mWaiters.pop());
+      waiter->id = next;
+      mWaiting.fetch_sub(1, std::memory_order_relaxed);
+      woken.push(waiter);
+    }
+    mLock.unlock();
+    detail::ResumeAll(woken.take());
+  }
+
+  // allocates it on first use
+  auto chunkAt(uint32_t id) -> Chunk&;
+  auto pop() noexcept -> uint32_t
+  {
+    auto head = mFree.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != NONE) {
+      auto id = static_cast<uint32_t>(head);
+      auto next = chunkAt(id).nextFree[id % CHUNK_BUFFERS].load(std::memory_order_relaxed);
+      if (mFree.compare_exchange_weak(head, Tagged(next, head), std::memory_order_acq_rel)) {
+        return id;
+      }
+    }
+    // never handed out yet
+    auto top = mTop.load(std::memory_order_relaxed);
+    while (top < mMaxBuffers) {
+      if (mTop.compare_exchange_weak(top, top + 1, std::memory_order_relaxed)) {
+        chunkAt(top);
+        return top;
+      }
+    }
+    return NONE;
+  }
+  auto push(uint32_t id) noexcept -> void
+  {
+    auto& next = chunkAt(id).nextFree[id % CHUNK_BUFFERS];
+    auto head = mFree.load(std::memory_order_relaxed);
+    do {
+      next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    } while (!mFree.compare_exchange_weak(head, Tagged(id, head), std::memory_order_release));
+  }
+  static auto Tagged(uint32_t id, uint64_t previous) noexcept -> uint64_t
+  {
+    return (((previous >> 32) + 1) << 32) | id;
+  }
+  // hands buffer `bid` back to the kernel, false when that could not be submitted
+  auto reprovide(uint16_t bid) noexcept -> bool;
+
+  size_t mBufferSize;
+  uint32_t mMaxBuffers;
+  std::unique_ptr<std::atomic<Chunk*>[]> mChunks;
+  std::atomic_size_t mChunkCount = 0;
+  std::atomic_uint64_t mFree = NONE;
+  std::atomic_uint32_t mTop = 0; // buffers past this were never handed out
+  std::atomic_size_t mInUse = 0;
+
+  std::atomic_int64_t mWaiting = 0;
+  detail::SpinLock mLock;
+  detail::WaiterQueue mWaiters; // guarded by mLock
+
+  std::unique_ptr<Provided> mProvided; // set once by `provide`
+};
+
+inline auto PooledBuffer::data() const noexcept -> std::byte* { return mPool->dataOf(mId); }
+inline auto PooledBuffer::capacity() const noexcept -> size_t { return mPool->mBufferSize; }
+inline auto PooledBuffer::release() noexcept -> void
+{
+  if (auto pool = std::exchange(mPool, nullptr)) {
+    mSize = 0;
+    pool->giveBack(mId, mBid);
+  }
+}
+} // namespace async
@@ -0,0 +1,378 @@
+#pragma once
+#include "Async/Primitives.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <new>
+#include <optional>
+#include <vector>
+
+namespace async {
+enum class ChannelMode {
+  Mpmc,
+  Spsc, // one sending and one receiving coroutine at a time
+};
+
+namespace detail {
+// bounded Vyukov ring for any movable T, values are only moved out of the caller on success
+template <typename T>
+class MpmcRing {
+public:
+  explicit MpmcRing(size_t capacity) : mMask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), mCells(mMask + 1)
+  {
+    for (size_t i = 0; i <= mMask; ++i) {
+      mCells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~MpmcRing()
+  {
+    while (tryPop()) {}
+  }
+
+  auto tryPush(T& value) -> bool
+  {
+    auto pos = mTail.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &mCells[pos & mMask];
+      auto diff = static_cast<intptr_t>(cell->seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mTail.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (cell->storage) T(std::move(value));
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+  auto tryPop() -> std::optional<T>
+  {
+    auto pos = mHead.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &mCells[pos & mMask];
+      auto diff = static_cast<intptr_t>(cell->seq.load(std::memory_order_acquire)) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = mHead.load(std::memory_order_relaxed);
+      }
+    }
+    auto slot = std::launder(reinterpret_cast<T*>(cell->storage));
+    auto value = std::optional<T>(std::move(*slot));
+    slot->~T();
+    cell->seq.store(pos + mMask + 1, std::memory_order_release);
+    return value;
+  }
+  [[nodiscard]] auto capacity() const -> size_t { return mMask + 1; }
+
+private:
+  struct Cell {
+    std::atomic_size_t seq;
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+  size_t const mMask;
+  std::vector<Cell> mCells;
+  alignas(64) std::atomic_size_t mHead {0};
+  alignas(64) std::atomic_size_t mTail {0};
+};
+
+// Lamport ring; each side caches the other's index so it only touches the shared line when it looks full/empty
+template <typename T>
+class SpscRing {
+public:
+  explicit SpscRing(size_t capacity)
+      : mMask(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), mSlots(std::make_unique<Slot[]>(mMask + 1))
+  {
+  }
+  ~SpscRing()
+  {
+    while (tryPop()) {}
+  }
+
+  auto tryPush(T& value) -> bool
+  {
+    auto tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mHeadCache > mMask) {
+      mHeadCache = mHead.load(std::memory_order_acquire);
+      if (tail - mHeadCache > mMask) {
+        return false;
+      }
+    }
+    ::new (mSlots[tail & mMask].storage) T(std::move(value));
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+  auto tryPop() -> std::optional<T>
+  {
+    auto head = mHead.load(std::memory_order_relaxed);
+    if (head == mTailCache) {
+      mTailCache = mTail.load(std::memory_order_acquire);
+      if (head == mTailCache) {
+        return std::nullopt;
+      }
+    }
+    auto slot = std::launder(reinterpret_cast<T*>(mSlots[head & mMask].storage));
+    auto value = std::optional<T>(std::move(*slot));
+    slot->~T();
+    mHead.store(head + 1, std::memory_order_release);
+    return value;
+  }
+  [[nodiscard]] auto capacity() const -> size_t { return mMask + 1; }
+
+private:
+  struct Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+  size_t const mMask;
+  std::unique_ptr<Slot[]> mSlots;
+  alignas(64) std::atomic_size_t mHead {0};
+  size_t mTailCache {0}; // consumer side
+  alignas(64) std::atomic_size_t mTail {0};
+  size_t mHeadCache {0}; // producer side
+};
+} // namespace detail
+
+// Bounded channel. Sends suspend while the ring is full and receives while it is empty; the fast paths are plain
+// ring operations. Suspended sides are served by whoever makes progress possible: a send hands its value to a
+// waiting receiver's awaiter, a receive moves a waiting sender's value into the ring.
+template <typename T, ChannelMode Mode = ChannelMode::Mpmc>
+class Channel {
+  using Ring = std::conditional_t<Mode == ChannelMode::Mpmc, detail::MpmcRing<T>, detail::SpscRing<T>>;
+
+  struct RecvWaiter : detail::Waiter {
+    std::optional<T> value;
+  };
+  struct SendWaiter : detail::Waiter {
+    T* value;
+    bool sent;
+  };
+
+public:
+  explicit Channel(size_t capacity) : mRing(capacity) {}
+  Channel(Channel const&) = delete;
+  Channel& operator=(Channel const&) = delete;
+
+  // the value is left untouched when it fails
+  [[nodiscard]] auto try_send(T&& value) -> bool
+  {
+    if (mClosed.load(std::memory_order_acquire) || !mRing.tryPush(value)) {
+      return false;
+    }
+    afterPush();
+    return true;
+  }
+  [[nodiscard]] auto try_recv() -> std::optional<T>
+  {
+    auto value = mRing.tryPop();
+    if (value) {
+      afterPop();
+    }
+    return value;
+  }
+
+  struct SendAwaiter {
+    Channel& channel;
+    T value;
+    SendWaiter waiter {};
+    auto await_ready() -> bool
+    {
+      waiter.sent = channel.try_send(std::move(value));
+      return waiter.sent || channel.isClosed();
+    }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      waiter.prepare(handle);
+      waiter.value = &value;
+      return channel.parkSender(&waiter);
+    }
+    // false once the channel is closed, the value is then dropped
+    auto await_resume() const noexcept -> bool { return waiter.sent; }
+  };
+  struct RecvAwaiter {
+    Channel& channel;
+    RecvWaiter waiter {};
+    auto await_ready() -> bool
+    {
+      waiter.value = channel.try_recv();
+      return waiter.value.has_value() || channel.isClosed();
+    }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      waiter.prepare(handle);
+      return channel.parkReceiver(&waiter);
+    }
+    // empty once the channel is closed and drained
+    auto await_resume() -> std::optional<T>
+    {
+      if (!waiter.value) {
+        return channel.try_recv(); // closed: whatever is still buffered
+      }
+      return std::move(waiter.value);
+    }
+  };
+  struct RecvManyAwaiter {
+    RecvAwaiter first;
+    std::vector<T>& out;
+    size_t max;
+    auto await_ready() -> bool { return first.await_ready(); }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool { return first.await_suspend(handle); }
+    // appends up to `max` values, 0 only when the channel is closed and drained
+    auto await_resume() -> size_t
+    {
+      auto value = first.await_resume();
+      if (!value) {
+        return 0;
+      }
+      out.push_back(std::move(*value));
+      auto count = size_t {1};
+      for (; count < max; ++count) {
+        auto next = first.channel.try_recv();
+        if (!next) {
+          break;
+        }
+        out.push_back(std::move(*next));
+      }
+      return count;
+    }
+  };
+
+  // resumes with false when the channel was closed before the value got in
+  [[nodiscard]] auto send(T value) -> SendAwaiter { return SendAwaiter {*this, std::move(value)}; }
+  [[nodiscard]] auto recv() -> RecvAwaiter { return RecvAwaiter {*this}; }
+  // suspends only while nothing is buffered, then drains up to `max` values in one wakeup
+  [[nodiscard]] auto recv_many(std::vector<T>& out, size_t max) -> RecvManyAwaiter
+  {
+    assert(max > 0);
+    return RecvManyAwaiter {RecvAwaiter {*this}, out, max};
+  }
+
+  // pending senders fail, receivers drain what is buffered and then get nullopt
+  auto close() -> void
+  {
+    mLock.lock();
+    mClosed.store(true, std::memory_order_release);
+    auto receivers = mReceivers.take();
+    auto senders = mSenders.take();
+    mRecvWaiting.store(0, std::memory_order_relaxed);
+    mSendWaiting.store(0, std::memory_order_relaxed);
+    mLock.unlock();
+    detail::ResumeAll(receivers);
+    detail::ResumeAll(senders);
+  }
+  [[nodiscard]] auto isClosed() const -> bool { return mClosed.load(std::memory_order_acquire); }
+  [[nodiscard]] auto capacity() const -> size_t { return mRing.capacity(); }
+
+private:
+  // registering bumps the waiting count before the last ring attempt, a push or pop bumps the ring before reading
+  // the count; with the fences in between one of the two sides always sees the other
+  auto afterPush() -> void
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mRecvWaiting.load(std::memory_order_relaxed) > 0) {
+      pump();
+    }
+  }
+  auto afterPop() -> void
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSendWaiting.load(std::memory_order_relaxed) > 0) {
+      pump();
+    }
+  }
+
+  auto parkReceiver(RecvWaiter* waiter) -> bool
+  {
+    mLock.lock();
+    mRecvWaiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!mClosed.load(std::memory_order_relaxed)) {
+      waiter->value = mRing.tryPop();
+      if (!waiter->value) {
+        mReceivers.push(waiter);
+        mLock.unlock();
+        return true;
+      }
+    }
+    mRecvWaiting.fetch_sub(1, std::memory_order_relaxed);
+    mLock.unlock();
+    afterPop();
+    return false;
+  }
+  auto parkSender(SendWaiter* waiter) -> bool
+  {
+    mLock.lock();
+    mSendWaiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!mClosed.load(std::memory_order_relaxed)) {
+      if (!mRing.tryPush(*waiter->value)) {
+        mSenders.push(waiter);
+        mLock.unlock();
+        return true;
+      }
+      waiter->sent = true;
+    }
+    mSendWaiting.fetch_sub(1, std::memory_order_relaxed);
+    mLock.unlock();
+    afterPush();
+    return false;
+  }
+
+  // serve parked receivers from the ring and move parked senders' values into it until neither progresses
+  auto pump() -> void
+  {
+    auto woken = detail::WaiterQueue {};
+    mLock.lock();
+    auto progress = true;
+    while (progress) {
+      progress = false;
+      while (!mReceivers.empty()) {
+        auto value = mRing.tryPop();
+        if (!value) {
+          break;
+        }
+        auto receiver = static_cast<RecvWaiter*>(mReceivers.pop());
+        receiver->value = std::move(value);
+        mRecvWaiting.fetch_sub(1, std::memory_order_relaxed);
+        woken.push(receiver);
+        progress = true;
+      }
+      while (!mSenders.empty()) {
+        auto sender = static_cast<SendWaiter*>(mSenders.head);
+        if (!mRing.tryPush(*sender->value)) {
+          break;
+        }
+        sender->sent = true;
+        mSenders.pop();
+        mSendWaiting.fetch_sub(1, std::memory_order_relaxed);
+        woken.push(sender);
+        progress = true;
+      }
+    }
+    mLock.unlock();
+    detail::ResumeAll(woken.take());
+  }
+
+  Ring mRing;
+  std::atomic_bool mClosed = false;
+  std::atomic_size_t mRecvWaiting = 0;
+  std::atomic_size_t mSendWaiting = 0;
+  detail::SpinLock mLock;
+  detail::WaiterQueue mReceivers; // guarded by mLock
+  detail::WaiterQueue mSenders;   // guarded by mLock
+};
+
+template <typename T>
+using SpscChannel = Channel<T, ChannelMode::Spsc>;
+} // namespace async
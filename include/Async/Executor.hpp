@@ -4,217 +4,335 @@
 #include "Async/Slab.hpp"
 #include "Async/ThreadPool.hpp"
 #include "Async/concepts.hpp"
-#include <future>
+#include <variant>
 namespace async {
 
+namespace detail {
+// the awaiter is the pool job, no frame is allocated; the caller resumes on its own executor once `fn` returned
+template <typename Fn>
+struct BlockingAwaiter : BlockingJob {
+  using Result = std::invoke_result_t<Fn&>;
+  using ValueTy = std::conditional_t<std::is_void_v<Result>, std::monostate, Result>;
+
+  BlockingThreadPool& pool;
+  Fn fn;
+  std::optional<ValueTy> value = std::nullopt;
+  std::exception_ptr exception = nullptr;
+  std::coroutine_handle<> handle = nullptr;
+  ExecutorRef executor {};
+
+  BlockingAwaiter(BlockingThreadPool& pool, Fn fn) : pool(pool), fn(std::move(fn)) {}
+  BlockingAwaiter(BlockingAwaiter const&) = delete;
+  BlockingAwaiter(BlockingAwaiter&&) = default;
+
+  auto await_ready() const noexcept -> bool { return false; }
+  auto await_suspend(std::coroutine_handle<> in) -> void
+  {
+    handle = in;
+    executor = ExecutorRef::Current();
+    run = &Run;
+    pool.submit(this);
+  }
+  auto await_resume() -> Result
+  {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+    if constexpr (!std::is_void_v<Result>) {
+      return std::move(value).value();
+    }
+  }
+
+  static auto Run(BlockingJob* job) -> void
+  {
+    auto& self = *static_cast<BlockingAwaiter*>(job);
+    try {
+      if constexpr (std::is_void_v<Result>) {
+        std::invoke(self.fn);
+        self.value.emplace();
+      } else {
+        self.value.emplace(std::invoke(self.fn));
+      }
+    } catch (...) {
+      self.exception = std::current_exception();
+    }
+    // the awaiter is gone once the caller runs
+    auto executor = self.executor;
+    executor.execute(self.handle);
+  }
+};
+} // namespace detail
+
 template <typename ExecutorType>
 class BlockingExecutor {
 public:
-  template <std::invocable Fn, typename... Args>
+  explicit BlockingExecutor(BlockingPoolConfig config = {}) : mConfig(config) {}
+
+  template <typename Fn, typename... Args>
+    requires std::invocable<Fn, Args...>
   auto blockSpawn(Fn&& fn, Args&&... args)
   {
-    std::call_once(mBlockingPoolFlag, [this]() { mBlockingPool = std::make_unique<BlockingThreadPool>(500); });
-    using Result = std::invoke_result_t<Fn, Args...>;
     auto function = std::bind_front(std::forward<Fn>(fn), std::forward<Args>(args)...);
-    if constexpr (std::is_void_v<Result>) {
-      struct Awaiter {
-        BlockingExecutor<ExecutorType>& e;
-        decltype(function) fn;
-        auto await_ready() -> bool { return false; }
-        auto await_suspend(std::coroutine_handle<> in) -> void
-        {
-          auto task = [](std::invocable auto&& fn) -> ContinueTask {
-            fn();
-            co_return;
-          }(std::move(fn));
-          e.execute(task.setContinue(in).handle);
-        }
-        auto await_resume() -> Result { return; }
-      };
-      return Awaiter {*this, std::move(function)};
-    } else {
-      struct Awaiter {
-        BlockingExecutor<ExecutorType>& e;
-        decltype(function) fn;
-        std::optional<Result> result;
-        auto await_ready() -> bool { return false; }
-        auto await_suspend(std::coroutine_handle<> in) -> void
-        {
-          auto task = [](std::invocable auto&& fn, Awaiter *awaiter) -> ContinueTask {
-            awaiter->result = std::invoke(fn);
-            co_return;
-          }(std::move(fn), this);
-          e.execute(task.setContinue(in).handle);
-        }
-        auto await_resume() -> Result
-        {
-          assert(result.has_value());
-          return std::move(result).value();
-        }
-      };
-      return Awaiter {*this, std::move(function)};
-    }
+    return detail::BlockingAwaiter<decltype(function)> {pool(), std::move(function)};
+  }
+  auto execute(std::coroutine_handle<> handle) -> void { pool().execute(handle); }
+  // started on first use
+  auto pool() -> BlockingThreadPool&
+  {
+    std::call_once(mBlockingPoolFlag, [this]() { mBlockingPool = std::make_unique<BlockingThreadPool>(mConfig); });
+    return *mBlockingPool;
   }
-  auto execute(std::coroutine_handle<> handle) -> void { mBlockingPool->execute(handle); }
 
 protected:
+  BlockingPoolConfig mConfig;
   std::once_flag mBlockingPoolFlag;
   std::unique_ptr<BlockingThreadPool> mBlockingPool {nullptr};
 };
 
+namespace detail {
+template <typename T>
+auto TaskHandleOf(std::coroutine_handle<> self) -> typename Task<T>::coroutine_handle_type
+{
+  return Task<T>::coroutine_handle_type::from_address(self.address());
+}
+
+// result of a `block`ed task, lives on the blocking thread's stack
+template <typename T, typename WakeFn>
+struct BlockState {
+  using ValueTy = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+  WakeFn wake;
+  std::atomic_bool done = false;
+  std::optional<ValueTy> value = std::nullopt;
+  std::exception_ptr exception = nullptr;
+
+  static auto OnComplete(void* ctx, std::coroutine_handle<> self) noexcept -> std::coroutine_handle<>
+  {
+    auto& state = *static_cast<BlockState*>(ctx);
+    auto handle = TaskHandleOf<T>(self);
+    if (handle.promise().exceptionPtr) {
+      state.exception = handle.promise().exceptionPtr;
+    } else if constexpr (std::is_void_v<T>) {
+      state.value.emplace();
+    } else {
+      state.value.emplace(std::move(handle.promise()).result());
+    }
+    handle.destroy();
+    state.done.store(true, std::memory_order_release);
+    state.wake();
+    return nullptr;
+  }
+  auto get() -> T
+  {
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+    if constexpr (!std::is_void_v<T>) {
+      return std::move(value).value();
+    }
+  }
+};
+} // namespace detail
+
 template <typename T>
 struct JoinHandle {
   std::atomic<void*> handle = 0; // 0 : not done, 1 : done, else : handle
   std::optional<T> result = std::nullopt;
+  std::exception_ptr exception = nullptr;
   typename Task<T>::coroutine_handle_type const spawnHandle;
   JoinHandle(Task<T> in) : spawnHandle(in.take()) {}
   ~JoinHandle() { assert(handle.load() != reinterpret_cast<void*>(0) && "Handle not joined"); }
-  auto done() -> bool { return handle.load() == reinterpret_cast<void*>(1) && spawnHandle.done(); }
+  auto done() -> bool { return handle.load() == reinterpret_cast<void*>(1); }
+  // hand `spawnHandle` to an executor after this, the frame is destroyed when the task finishes
+  auto prepare() -> std::coroutine_handle<>
+  {
+    spawnHandle.promise().setCompletion(&OnComplete, this);
+    return spawnHandle;
+  }
   [[nodiscard]] auto join()
   {
     struct JoinAwaiter {
       JoinHandle& handle;
-      auto await_ready()
-      {
-        if (handle.handle.load() == reinterpret_cast<void*>(0)) {
-          return false;
-        }
-        if (handle.handle.load() == reinterpret_cast<void*>(1)) {
-          return true;
-        }
-        assert(0);
-      }
+      auto await_ready() -> bool { return handle.handle.load(std::memory_order_acquire) == reinterpret_cast<void*>(1); }
       auto await_suspend(std::coroutine_handle<> in) -> bool
       {
         auto expected = reinterpret_cast<void*>(0);
-        if (handle.handle.compare_exchange_strong(expected, in.address())) {
-          return true; // pending and set handle address
-        } else {
-          auto success = handle.handle.load() == reinterpret_cast<void*>(1);
-          assert(success);
-          return false; // already done
+        // false: finished in the meantime
+        return handle.handle.compare_exchange_strong(expected, in.address(), std::memory_order_acq_rel);
+      }
+      auto await_resume() -> T
+      {
+        if (handle.exception) {
+          std::rethrow_exception(handle.exception);
         }
+        return std::move(handle.result.value());
       }
-      auto await_resume() -> T { return std::move(handle.result.value()); }
     };
     return JoinAwaiter {*this};
   }
+
+private:
+  // the joiner, when already waiting, is resumed right away on the finishing thread
+  static auto OnComplete(void* ctx, std::coroutine_handle<> self) noexcept -> std::coroutine_handle<>
+  {
+    auto& join = *static_cast<JoinHandle*>(ctx);
+    auto task = detail::TaskHandleOf<T>(self);
+    if (task.promise().exceptionPtr) {
+      join.exception = task.promise().exceptionPtr;
+    } else {
+      join.result.emplace(std::move(task.promise()).result());
+    }
+    task.destroy();
+    auto waiter = join.handle.exchange(reinterpret_cast<void*>(1), std::memory_order_acq_rel);
+    return waiter != nullptr ? std::coroutine_handle<>::from_address(waiter) : nullptr;
+  }
 };
 
 template <>
 struct JoinHandle<void> {
   std::atomic<void*> handle = 0; // 0 : not done, 1 : done, else : handle
+  std::exception_ptr exception = nullptr;
   typename Task<>::coroutine_handle_type const spawnHandle;
   JoinHandle(Task<> in) : spawnHandle(in.take()) {}
-  auto done() -> bool { return handle.load() == reinterpret_cast<void*>(1) && spawnHandle.done(); }
+  auto done() -> bool { return handle.load() == reinterpret_cast<void*>(1); }
+  auto prepare() -> std::coroutine_handle<>
+  {
+    spawnHandle.promise().setCompletion(&OnComplete, this);
+    return spawnHandle;
+  }
   [[nodiscard]] auto join()
   {
     struct JoinAwaiter {
       JoinHandle& handle;
-      auto await_ready()
-      {
-        if (handle.handle.load() == reinterpret_cast<void*>(0)) {
-          return false;
-        }
-        if (handle.handle.load() == reinterpret_cast<void*>(1)) {
-          return true;
-        }
-        assert(0);
-      }
+      auto await_ready() -> bool { return handle.handle.load(std::memory_order_acquire) == reinterpret_cast<void*>(1); }
       auto await_suspend(std::coroutine_handle<> in) -> bool
       {
         auto expected = reinterpret_cast<void*>(0);
-        if (handle.handle.compare_exchange_strong(expected, in.address())) {
-          return true; // pending and set handle address
-        } else {
-          auto success = handle.handle.load() == reinterpret_cast<void*>(1);
-          assert(success);
-          return false; // already done
+        return handle.handle.compare_exchange_strong(expected, in.address(), std::memory_order_acq_rel);
+      }
+      auto await_resume() -> void
+      {
+        if (handle.exception) {
+          std::rethrow_exception(handle.exception);
         }
       }
-      auto await_resume() -> void {}
     };
     return JoinAwaiter {*this};
   }
+
+private:
+  static auto OnComplete(void* ctx, std::coroutine_handle<> self) noexcept -> std::coroutine_handle<>
+  {
+    auto& join = *static_cast<JoinHandle*>(ctx);
+    auto task = detail::TaskHandleOf<void>(self);
+    join.exception = task.promise().exceptionPtr;
+    task.destroy();
+    auto waiter = join.handle.exchange(reinterpret_cast<void*>(1), std::memory_order_acq_rel);
+    return waiter != nullptr ? std::coroutine_handle<>::from_address(waiter) : nullptr;
+  }
+};
+
+enum class ReactorMode {
+  Shared,    // one reactor, driven by the thread inside `block`
+  PerWorker, // every worker owns a reactor, io and timers created on a worker stay on it
+};
+
+enum class WorkerAffinity {
+  None,   // workers float, steal in ring order
+  Pinned, // a core each, node by node, stealing from SMT siblings, the same cache, the same node and then the rest
+};
+
+// runs one reactor per pool worker, a parked worker sleeps in its own epoll_wait
+class WorkerReactors final : public WorkerDriver {
+public:
+  explicit WorkerReactors(size_t n) : mReactors(n) {}
+  auto start(StealingThreadPool&, size_t id) -> void override { Reactor::SetCurrent(&mReactors[id]); }
+  auto stop(StealingThreadPool&, size_t) -> void override { Reactor::SetCurrent(nullptr); }
+  auto poll(StealingThreadPool& pool, size_t id) -> void override
+  {
+    using namespace std::chrono_literals;
+    [[maybe_unused]] auto r = mReactors[id].lock().react(0ns, pool);
+    assert(r || r.error() == std::errc::interrupted);
+  }
+  auto park(StealingThreadPool& pool, size_t id) -> bool override
+  {
+    [[maybe_unused]] auto r = mReactors[id].lock().react(std::nullopt, pool);
+    assert(r || r.error() == std::errc::interrupted);
+    return true;
+  }
+  auto unpark(size_t id) -> void override { mReactors[id].notify(); }
+
+private:
+  std::deque<Reactor> mReactors;
+};
+
+// idle workers drive the shared reactor themselves, so readiness is dispatched into the polling worker's queue
+// instead of hopping through the thread inside `block`
+class SharedReactor final : public WorkerDriver {
+public:
+  static constexpr auto NONE = std::numeric_limits<size_t>::max();
+
+  explicit SharedReactor(Reactor& reactor) : mReactor(reactor) {}
+  auto start(StealingThreadPool&, size_t) -> void override { Reactor::SetCurrent(&mReactor); }
+  auto stop(StealingThreadPool&, size_t) -> void override { Reactor::SetCurrent(nullptr); }
+  auto poll(StealingThreadPool& pool, size_t) -> void override;
+  // the first worker to park blocks in the reactor, the others sleep on their futex
+  auto park(StealingThreadPool& pool, size_t id) -> bool override;
+  auto unpark(size_t id) -> void override;
+
+private:
+  Reactor& mReactor;
+  std::atomic_size_t mPolling {NONE}; // worker blocked in the reactor
 };
 
 class MultiThreadExecutor {
 public:
-  MultiThreadExecutor(size_t n) : mPool(n) {}
+  // `reactor` is the main one, shared by all workers or, with one reactor per worker, driven inside `block`
+  MultiThreadExecutor(Reactor& reactor, size_t n, ReactorMode mode = ReactorMode::Shared,
+                      WorkerAffinity affinity = WorkerAffinity::None, BlockingPoolConfig blocking = {})
+      : mReactor(reactor), mBlockingExecutor(blocking), mShared(reactor),
+        mReactors(mode == ReactorMode::PerWorker ? std::make_unique<WorkerReactors>(n) : nullptr),
+        mPool(n, mReactors != nullptr ? static_cast<WorkerDriver*>(mReactors.get()) : &mShared,
+              affinity == WorkerAffinity::Pinned ? Topology::Detect().place(n) : std::vector<CpuInfo> {})
+  {
+  }
 
-  auto spawnDetach(Task<> in) -> void
+  // the task and everything it awaits inline stay on the `priority` lane
+  auto spawnDetach(Task<> in, Priority priority = Priority::Normal) -> void
   {
     mSpawnCount.fetch_add(1, std::memory_order_acquire);
-    auto afterDoneFn = [this]() {
-      mSpawnCount.fetch_sub(1, std::memory_order_release);
-      Runtime<MultiThreadExecutor>::GetReactor().notify();
-    };
-    auto handle = [](Task<> task)
-        -> DetachTask<void> { co_return co_await task; }(std::move(in)).afterDestroy(afterDoneFn).handle;
-    mPool.execute(handle);
+    auto handle = in.take();
+    handle.promise().setCompletion(&OnDetachDone, this);
+    mPool.execute(handle, priority);
   }
   template <typename T>
-  auto spawn(JoinHandle<T>& join) -> void
+  auto spawn(JoinHandle<T>& join, Priority priority = Priority::Normal) -> void
   {
-    if constexpr (!std::is_void_v<T>) {
-      auto afterDoneFn = [this, &join](auto&& value) {
-        auto expected = reinterpret_cast<void*>(0);
-        if (!join.handle.compare_exchange_strong(expected, reinterpret_cast<void*>(1))) {
-          join.result.emplace(std::forward<T>(value));
-          execute(std::coroutine_handle<>::from_address(join.handle.load()));
-        }
-      };
-      auto handle = [](Task<T> task)
-          -> DetachTask<T> { co_return co_await task; }(Task<T>(join.spawnHandle)).afterDestroy(afterDoneFn).handle;
-      mPool.execute(handle);
-    } else {
-      auto afterDoneFn = [this, &join]() {
-        auto expected = reinterpret_cast<void*>(0);
-        if (!join.handle.compare_exchange_strong(expected, reinterpret_cast<void*>(1))) {
-          execute(std::coroutine_handle<>::from_address(join.handle.load()));
-        }
-      };
-      auto handle = [](Task<T> task)
-          -> DetachTask<T> { co_return co_await task; }(Task<T>(join.spawnHandle)).afterDestroy(afterDoneFn).handle;
-      mPool.execute(handle);
-    }
+    mPool.execute(join.prepare(), priority);
   }
   template <typename T>
   [[nodiscard]] auto block(Task<T> in) -> T
   {
-    auto promise = std::make_shared<std::promise<T>>();
-    auto future = promise->get_future();
-
-    if constexpr (std::is_void_v<T>) { // return void
-      auto afterDoneFn = [this, promise]() {
-        promise->set_value();
-        Runtime<MultiThreadExecutor>::GetReactor().notify();
-      };
-      auto handle = [](Task<T> task)
-          -> DetachTask<T> { co_return co_await task; }(std::move(in)).afterDestroy(std::move(afterDoneFn)).handle;
-      execute(handle);
-    } else {
-      auto afterDoneFn = [promise](auto&& value) {
-        promise->set_value(std::forward<T>(value));
-        Runtime<MultiThreadExecutor>::GetReactor().notify();
-      };
-      auto newTask = [](Task<T> task) -> DetachTask<T> {
-        auto value = co_await task;
-        co_return value;
-      }(std::move(in));
-      execute(newTask.afterDestroy(std::move(afterDoneFn)).handle);
-    }
+    auto wake = [this]() { wakeBlocker(); };
+    auto state = detail::BlockState<T, decltype(wake)> {wake};
+    auto handle = in.take();
+    handle.promise().setCompletion(&decltype(state)::OnComplete, &state);
+    execute(handle);
 
-    using namespace std::chrono_literals;
     while (true) {
-      if (future.wait_for(0s) == std::future_status::ready) {
+      auto epoch = mBlockEpoch.load(std::memory_order_acquire);
+      if (state.done.load(std::memory_order_acquire)) {
         if (mSpawnCount.load(std::memory_order_acquire) == 0) {
           break;
         }
       }
-      Runtime<MultiThreadExecutor>::GetReactor().lock().react(std::nullopt, mPool);
+      if (mReactors != nullptr) {
+        // nobody else polls the main reactor in per-worker mode
+        mReactor.lock().react(std::nullopt, mPool);
+      } else {
+        mBlockEpoch.wait(epoch, std::memory_order_acquire);
+      }
     }
-    return future.get();
+    return state.get();
   }
 
   template <typename... Args>
@@ -222,69 +340,106 @@ public:
   {
     return mBlockingExecutor.blockSpawn(std::forward<Args>(args)...);
   }
-  auto execute(std::coroutine_handle<> handle) -> void { mPool.execute(handle); }
+  [[nodiscard]] auto blockingStats() -> BlockingPoolStats { return mBlockingExecutor.pool().stats(); }
+  [[nodiscard]] auto blockingPool() -> BlockingThreadPool& { return mBlockingExecutor.pool(); }
+  // cpu of every worker, empty unless pinned
+  [[nodiscard]] auto placement() const -> std::vector<CpuInfo> const& { return mPool.placement(); }
+  auto execute(std::coroutine_handle<> handle, Priority priority = Priority::Normal) -> void
+  {
+    mPool.execute(handle, priority);
+  }
 
 private:
+  static auto OnDetachDone(void* ctx, std::coroutine_handle<> self) noexcept -> std::coroutine_handle<>
+  {
+    auto executor = static_cast<MultiThreadExecutor*>(ctx);
+    self.destroy();
+    executor->mSpawnCount.fetch_sub(1, std::memory_order_release);
+    executor->wakeBlocker();
+    return nullptr;
+  }
+  auto wakeBlocker() -> void
+  {
+    if (mReactors != nullptr) {
+      mReactor.notify();
+      return;
+    }
+    mBlockEpoch.fetch_add(1, std::memory_order_release);
+    mBlockEpoch.notify_all();
+  }
+
+  Reactor& mReactor;
   BlockingExecutor<MultiThreadExecutor> mBlockingExecutor;
 
   std::atomic_size_t mSpawnCount;
+  std::atomic_uint32_t mBlockEpoch {0}; // bumped whenever `block` may be done, in shared mode
+  SharedReactor mShared;
+  std::unique_ptr<WorkerReactors> mReactors; // outlives the pool's workers
   StealingThreadPool mPool;
 };
 
+inline auto SharedReactor::poll(StealingThreadPool& pool, size_t) -> void
+{
+  using namespace std::chrono_literals;
+  if (auto lk = mReactor.tryLock()) {
+    [[maybe_unused]] auto r = lk->react(0ns, pool);
+    assert(r || r.error() == std::errc::interrupted);
+  }
+}
+
+inline auto SharedReactor::park(StealingThreadPool& pool, size_t id) -> bool
+{
+  auto lk = mReactor.tryLock();
+  if (!lk) {
+    return false;
+  }
+  mPolling.store(id, std::memory_order_seq_cst);
+  // pairs with `unpark`: either it sees us polling and notifies, or we see the wakeup here
+  if (!pool.unparked(id)) {
+    [[maybe_unused]] auto r = lk->react(std::nullopt, pool);
+    assert(r || r.error() == std::errc::interrupted);
+  }
+  mPolling.store(NONE, std::memory_order_seq_cst);
+  return true;
+}
+
+inline auto SharedReactor::unpark(size_t id) -> void
+{
+  if (mPolling.load(std::memory_order_seq_cst) == id) {
+    mReactor.notify();
+  }
+}
+
 class InlineExecutor final {
 public:
-  InlineExecutor() : mQueue(), mSpawnCount(0) {}
+  explicit InlineExecutor(Reactor& reactor, BlockingPoolConfig blocking = {})
+      : mReactor(reactor), mBlockingExecutor(blocking), mQueue(), mSpawnCount(0)
+  {
+  }
 
   auto spawnDetach(Task<> task) -> void
   {
     mSpawnCount += 1;
-    auto afterDestroyFn = [this]() {
-      mSpawnCount -= 1;
-      Runtime<InlineExecutor>::GetReactor().notify();
-    };
-    auto handle = [](Task<> task) -> DetachTask<void> { co_return co_await task; }(std::move(task))
-                                         .afterDestroy(std::move(afterDestroyFn))
-                                         .handle;
+    auto handle = task.take();
+    handle.promise().setCompletion(&OnDetachDone, this);
     mQueue.push(handle);
   }
 
   template <typename T>
   auto spawn(JoinHandle<T>& join) -> void
   {
-    if constexpr (!std::is_void_v<T>) {
-      auto afterDoneFn = [this, &join](auto&& value) {
-        auto expected = reinterpret_cast<void*>(0);
-        if (!join.handle.compare_exchange_strong(expected, reinterpret_cast<void*>(1))) {
-          join.result.emplace(std::forward<T>(value));
-          execute(std::coroutine_handle<>::from_address(join.handle.load()));
-        }
-      };
-      auto handle = [](Task<T> task)
-          -> DetachTask<T> { co_return co_await task; }(Task<T>(join.spawnHandle)).afterDestroy(afterDoneFn).handle;
-      execute(handle);
-    } else {
-      auto afterDoneFn = [this, &join]() {
-        auto expected = reinterpret_cast<void*>(0);
-        if (!join.handle.compare_exchange_strong(expected, reinterpret_cast<void*>(1))) {
-          execute(std::coroutine_handle<>::from_address(join.handle.load()));
-        }
-      };
-      auto handle = [](Task<T> task)
-          -> DetachTask<T> { co_return co_await task; }(Task<T>(join.spawnHandle)).afterDestroy(afterDoneFn).handle;
-      execute(handle);
-    }
+    execute(join.prepare());
   }
   template <typename T>
-    requires(not std::is_void_v<T>)
   auto block(Task<T> task) -> T
   {
-    auto returnValue = std::optional<T>(std::nullopt);
-    auto afterDestroyFn = [&returnValue](T&& value) {
-      returnValue.emplace(std::move(value));
-      Runtime<InlineExecutor>::GetReactor().notify();
-    };
-    auto handle = [this](Task<T> task)
-        -> DetachTask<T> { co_return co_await task; }(std::move(task)).afterDestroy(std::move(afterDestroyFn)).handle;
+    // completions may come from a blocking pool thread, wake the reactor in case it is waiting
+    auto wake = [this]() { mReactor.notify(); };
+    auto state = detail::BlockState<T, decltype(wake)> {wake};
+    auto handle = task.take();
+    handle.promise().setCompletion(&decltype(state)::OnComplete, &state);
+    auto previous = ExecutorRef::SetCurrent(*this);
+    auto previousReactor = Reactor::SetCurrent(&mReactor);
     handle.resume();
 
     while (true) {
@@ -293,36 +448,14 @@ public:
         mQueue.pop();
         handle.resume();
       }
-      if (mSpawnCount == 0 && returnValue.has_value() && mQueue.empty()) {
+      if (mSpawnCount == 0 && state.done.load(std::memory_order_acquire) && mQueue.empty()) {
         break;
       }
-      Runtime<InlineExecutor>::GetReactor().lock().react(std::nullopt, *this);
-    }
-
-    return std::move(returnValue.value());
-  }
-  auto block(Task<> task) -> void
-  {
-    auto hasValue = false;
-    auto afterDestroyFn = [&hasValue]() {
-      hasValue = true;
-      Runtime<InlineExecutor>::GetReactor().notify();
-    };
-    auto handle = [](Task<> task) -> DetachTask<void> { co_return co_await task; }(std::move(task))
-                                         .afterDestroy(std::move(afterDestroyFn))
-                                         .handle;
-    handle.resume();
-    while (true) {
-      while (!mQueue.empty()) {
-        auto handle = mQueue.front();
-        mQueue.pop();
-        handle.resume();
-      }
-      if (mSpawnCount == 0 && hasValue && mQueue.empty()) {
-        break;
-      }
-      Runtime<InlineExecutor>::GetReactor().lock().react(std::nullopt, *this);
+      mReactor.lock().react(std::nullopt, *this);
     }
+    Reactor::SetCurrent(previousReactor);
+    ExecutorRef::SetCurrent(previous);
+    return state.get();
   }
 
   template <typename... Args>
@@ -330,12 +463,27 @@ public:
   {
     return mBlockingExecutor.blockSpawn(std::forward<Args>(args)...);
   }
+  [[nodiscard]] auto blockingStats() -> BlockingPoolStats { return mBlockingExecutor.pool().stats(); }
+  [[nodiscard]] auto blockingPool() -> BlockingThreadPool& { return mBlockingExecutor.pool(); }
   auto execute(std::coroutine_handle<> handle) -> void { handle.resume(); }
 
 private:
+  static auto OnDetachDone(void* ctx, std::coroutine_handle<> self) noexcept -> std::coroutine_handle<>
+  {
+    auto executor = static_cast<InlineExecutor*>(ctx);
+    self.destroy();
+    executor->mSpawnCount -= 1;
+    executor->mReactor.notify();
+    return nullptr;
+  }
+
+  Reactor& mReactor;
   BlockingExecutor<InlineExecutor> mBlockingExecutor;
 
   std::queue<std::coroutine_handle<>> mQueue;
   size_t mSpawnCount;
 };
+
+static_assert(ExecutorCpt<MultiThreadExecutor>);
+static_assert(ExecutorCpt<InlineExecutor>);
 } // namespace async
@@ -0,0 +1,45 @@
+#pragma once
+#include <coroutine>
+#include <type_traits>
+#include <utility>
+
+namespace async {
+// Non-owning, type-erased reference to anything with `execute(std::coroutine_handle<>)`. Executors install
+// themselves as `Current()` on the threads they run coroutines on, so primitives can resume a waiter where it
+// came from without naming the executor type.
+class ExecutorRef {
+public:
+  ExecutorRef() noexcept = default;
+  template <typename E>
+    requires(!std::is_same_v<std::remove_cvref_t<E>, ExecutorRef>)
+  ExecutorRef(E& executor) noexcept
+      : mExecutor(&executor),
+        mExecute([](void* self, std::coroutine_handle<> handle) { static_cast<E*>(self)->execute(handle); })
+  {
+  }
+
+  explicit operator bool() const noexcept { return mExecutor != nullptr; }
+  auto operator==(ExecutorRef const& other) const noexcept -> bool { return mExecutor == other.mExecutor; }
+  // an empty reference resumes inline
+  auto execute(std::coroutine_handle<> handle) const -> void
+  {
+    if (mExecutor != nullptr) {
+      mExecute(mExecutor, handle);
+    } else {
+      handle.resume();
+    }
+  }
+
+  [[nodiscard]] static auto Current() noexcept -> ExecutorRef { return tCurrent; }
+  // returns the previous one
+  static auto SetCurrent(ExecutorRef executor) noexcept -> ExecutorRef { return std::exchange(tCurrent, executor); }
+
+private:
+  void* mExecutor = nullptr;
+  void (*mExecute)(void*, std::coroutine_handle<>) = nullptr;
+
+  static thread_local ExecutorRef tCurrent;
+};
+
+inline thread_local ExecutorRef ExecutorRef::tCurrent {};
+} // namespace async
@@ -0,0 +1,122 @@
+#pragma once
+#include "Async/Executor.hpp"
+#include "Async/Reactor.hpp"
+#include <fcntl.h>
+#include <optional>
+#include <span>
+#include <string>
+#include <unistd.h>
+
+namespace async {
+// Regular files are always "ready" for epoll, so reads and writes go through the reactor's completion poller
+// when it is available. The pread/pwrite fallback runs on `blocking` when set, on the calling thread otherwise.
+template <typename CompletionTy, typename FallbackFn>
+struct FileAwaiter {
+  CompletionTy completion;
+  FallbackFn fallback;
+  uint64_t* cursor; // advanced by the transferred length, null for positional io
+  bool useCompletion;
+  BlockingThreadPool* blocking;
+  StdResult<size_t> result {};
+  std::optional<detail::BlockingAwaiter<FallbackFn>> offload {};
+
+  auto await_ready() -> bool
+  {
+    if (useCompletion) {
+      return false;
+    }
+    if (blocking != nullptr) {
+      offload.emplace(*blocking, fallback);
+      return false;
+    }
+    result = fallback();
+    return true;
+  }
+  auto await_suspend(std::coroutine_handle<> handle) -> bool
+  {
+    if (offload) {
+      offload->await_suspend(handle);
+      return true;
+    }
+    return completion.await_suspend(handle);
+  }
+  auto await_resume() -> StdResult<size_t>
+  {
+    if (offload) {
+      result = offload->await_resume();
+    } else if (useCompletion) {
+      result = completion.await_resume();
+    }
+    if (result && cursor != nullptr) {
+      *cursor += result.value();
+    }
+    return result;
+  }
+};
+
+class File {
+public:
+  File() = default;
+  File(File const&) = delete;
+  File(File&& other) noexcept
+      : mReactor(std::exchange(other.mReactor, nullptr)), mBlocking(std::exchange(other.mBlocking, nullptr)),
+        mFd(std::exchange(other.mFd, -1)), mCursor(std::exchange(other.mCursor, 0))
+  {
+  }
+  File& operator=(File const&) = delete;
+  File& operator=(File&& other) noexcept
+  {
+    if (this != &other) {
+      close();
+      mReactor = std::exchange(other.mReactor, nullptr);
+      mBlocking = std::exchange(other.mBlocking, nullptr);
+      mFd = std::exchange(other.mFd, -1);
+      mCursor = std::exchange(other.mCursor, 0);
+    }
+    return *this;
+  }
+  ~File() { close(); }
+
+  static auto Open(Reactor& reactor, std::string const& path, int flags = O_RDONLY, mode_t mode = 0644)
+      -> StdResult<File>;
+
+  // Without a completion poller every read and write is a blocking pread/pwrite on the calling thread, which may be
+  // the one driving the reactor. Set a pool, e.g. the executor's `blockingPool()`, to run them there instead.
+  auto setBlockingPool(BlockingThreadPool* pool) -> void { mBlocking = pool; }
+
+  // positional io, file cursor is untouched
+  [[nodiscard]] auto readAt(std::span<std::byte> buf, uint64_t offset, uint64_t* cursor = nullptr)
+  {
+    auto fallback = [fd = mFd, buf, offset]() -> StdResult<size_t> {
+      return SysCall(::pread, fd, buf.data(), buf.size(), offset).map([](auto n) { return static_cast<size_t>(n); });
+    };
+    return FileAwaiter<decltype(mReactor->read(mFd, buf, offset)), decltype(fallback)> {
+        mReactor->read(mFd, buf, offset), fallback, cursor, mReactor->supportCompletion(), mBlocking};
+  }
+  [[nodiscard]] auto writeAt(std::span<std::byte const> buf, uint64_t offset, uint64_t* cursor = nullptr)
+  {
+    auto fallback = [fd = mFd, buf, offset]() -> StdResult<size_t> {
+      return SysCall(::pwrite, fd, buf.data(), buf.size(), offset).map([](auto n) { return static_cast<size_t>(n); });
+    };
+    return FileAwaiter<decltype(mReactor->write(mFd, buf, offset)), decltype(fallback)> {
+        mReactor->write(mFd, buf, offset), fallback, cursor, mReactor->supportCompletion(), mBlocking};
+  }
+  // sequential io, advance the file cursor
+  [[nodiscard]] auto read(std::span<std::byte> buf) { return readAt(buf, mCursor, &mCursor); }
+  [[nodiscard]] auto write(std::span<std::byte const> buf) { return writeAt(buf, mCursor, &mCursor); }
+
+  auto size() const -> StdResult<size_t>;
+  auto seek(uint64_t offset) -> void { mCursor = offset; }
+  auto fd() const -> int { return mFd; }
+  auto isValid() const -> bool { return mFd != -1; }
+  auto close() -> void;
+
+private:
+  File(Reactor& reactor, int fd) : mReactor(&reactor), mFd(fd), mCursor(0) {}
+
+  Reactor* mReactor {nullptr};
+  BlockingThreadPool* mBlocking {nullptr}; // runs the fallback, see `setBlockingPool`
+  int mFd {-1};
+  uint64_t mCursor {0};
+};
+} // namespace async
@@ -0,0 +1,288 @@
+#pragma once
+#include "Async/Task.hpp"
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace async {
+namespace detail {
+// a yielded lvalue or temporary stays alive in the generator frame while it is suspended, only its address is kept;
+// a const lvalue can't be moved from and is copied into the promise instead
+template <typename T>
+struct YieldSlot {
+  static_assert(!std::is_reference_v<T> && !std::is_const_v<T>, "yield plain value types");
+  T* value = nullptr;
+  std::optional<T> copy = std::nullopt;
+
+  auto set(T& in) noexcept -> void { value = std::addressof(in); }
+  auto set(T const& in) -> void
+  {
+    copy.emplace(in);
+    value = std::addressof(*copy);
+  }
+  auto reset() noexcept -> void
+  {
+    value = nullptr;
+    copy.reset();
+  }
+};
+} // namespace detail
+
+template <typename T>
+class Generator;
+
+// Synchronous generator, values are produced one at a time by `co_yield` while the caller iterates. It can't
+// `co_await`, see `AsyncGenerator` for that.
+template <typename T>
+class Generator {
+public:
+  struct promise_type : PooledFrame {
+    detail::YieldSlot<T> slot;
+    std::exception_ptr exceptionPtr;
+
+    auto get_return_object() noexcept -> Generator
+    {
+      return Generator {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+    auto final_suspend() noexcept -> std::suspend_always { return {}; }
+    // a temporary (also one converted to T) lives until the generator is resumed
+    auto yield_value(T&& value) noexcept -> std::suspend_always
+    {
+      slot.set(value);
+      return {};
+    }
+    auto yield_value(T& value) noexcept -> std::suspend_always
+    {
+      slot.set(value);
+      return {};
+    }
+    auto yield_value(T const& value) -> std::suspend_always
+    {
+      slot.set(value);
+      return {};
+    }
+    auto return_void() noexcept -> void {}
+    auto unhandled_exception() noexcept -> void { exceptionPtr = std::current_exception(); }
+    template <typename U>
+    auto await_transform(U&&) -> std::suspend_never = delete;
+
+    auto advance(std::coroutine_handle<promise_type> self) -> void
+    {
+      slot.reset();
+      self.resume();
+      if (exceptionPtr) {
+        std::rethrow_exception(std::exchange(exceptionPtr, nullptr));
+      }
+    }
+  };
+
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cvref_t<T>;
+
+    Iterator() noexcept = default;
+    explicit Iterator(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
+
+    // the yielded object itself, it may be moved from
+    auto operator*() const noexcept -> T& { return *mHandle.promise().slot.value; }
+    auto operator->() const noexcept -> T* { return mHandle.promise().slot.value; }
+    auto operator++() -> Iterator&
+    {
+      mHandle.promise().advance(mHandle);
+      return *this;
+    }
+    auto operator++(int) -> void { ++*this; }
+    friend auto operator==(Iterator const& it, std::default_sentinel_t) noexcept -> bool
+    {
+      return it.mHandle == nullptr || it.mHandle.done();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> mHandle {nullptr};
+  };
+
+  Generator() noexcept = default;
+  Generator(Generator const&) = delete;
+  Generator(Generator&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+  Generator& operator=(Generator const&) = delete;
+  Generator& operator=(Generator&& other) noexcept
+  {
+    if (this != &other) {
+      destroy();
+      mHandle = std::exchange(other.mHandle, nullptr);
+    }
+    return *this;
+  }
+  // may be dropped at any `co_yield`, the frame unwinds from there
+  ~Generator() { destroy(); }
+
+  // runs up to the first `co_yield`, only once
+  auto begin() -> Iterator
+  {
+    if (mHandle) {
+      mHandle.promise().advance(mHandle);
+    }
+    return Iterator {mHandle};
+  }
+  auto end() const noexcept -> std::default_sentinel_t { return {}; }
+
+private:
+  explicit Generator(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
+  auto destroy() noexcept -> void
+  {
+    if (mHandle) {
+      std::exchange(mHandle, nullptr).destroy();
+    }
+  }
+
+  std::coroutine_handle<promise_type> mHandle {nullptr};
+};
+
+// Generator that may `co_await` inside, e.g. reactor IO between values. Each `next()` resumes it until the following
+// `co_yield` (or its end) and the consumer continues from there by symmetric transfer, on whichever executor thread
+// the generator was last resumed by. The consumer's stop token is handed down like to an awaited `Task`.
+template <typename T>
+class AsyncGenerator {
+public:
+  struct promise_type : PromiseBase {
+    detail::YieldSlot<T> slot;
+
+    struct YieldAwaiter {
+      auto await_ready() const noexcept -> bool { return false; }
+      auto await_suspend(std::coroutine_handle<promise_type> self) noexcept -> std::coroutine_handle<>
+      {
+        return self.promise().continueHandle;
+      }
+      auto await_resume() const noexcept -> void {}
+    };
+
+    auto get_return_object() noexcept -> AsyncGenerator
+    {
+      return AsyncGenerator {std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+    // a temporary (also one converted to T) lives until the generator is resumed
+    auto yield_value(T&& value) noexcept -> YieldAwaiter
+    {
+      slot.set(value);
+      return {};
+    }
+    auto yield_value(T& value) noexcept -> YieldAwaiter
+    {
+      slot.set(value);
+      return {};
+    }
+    auto yield_value(T const& value) -> YieldAwaiter
+    {
+      slot.set(value);
+      return {};
+    }
+    auto return_void() noexcept -> void {}
+  };
+
+  struct NextAwaiter {
+    std::coroutine_handle<promise_type> generator;
+
+    auto await_ready() const noexcept -> bool { return generator == nullptr || generator.done(); }
+    template <typename P>
+    auto await_suspend(std::coroutine_handle<P> consumer) noexcept -> std::coroutine_handle<>
+    {
+      auto& promise = generator.promise();
+      promise.slot.reset();
+      promise.setContinue(consumer);
+      InheritStop(promise, consumer);
+      return generator;
+    }
+    // the yielded object, valid until the generator is resumed again; null once it finished
+    auto await_resume() -> T*
+    {
+      if (generator == nullptr) {
+        return nullptr;
+      }
+      auto& promise = generator.promise();
+      if (promise.exceptionPtr) {
+        std::rethrow_exception(std::exchange(promise.exceptionPtr, nullptr));
+      }
+      return generator.done() ? nullptr : promise.slot.value;
+    }
+  };
+
+  class Iterator {
+  public:
+    Iterator() noexcept = default;
+    explicit Iterator(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
+
+    auto operator*() const noexcept -> T& { return *mHandle.promise().slot.value; }
+    auto operator->() const noexcept -> T* { return mHandle.promise().slot.value; }
+    // `co_await ++it`
+    [[nodiscard]] auto operator++() noexcept
+    {
+      struct Awaiter : NextAwaiter {
+        Iterator& it;
+        auto await_resume() -> Iterator&
+        {
+          NextAwaiter::await_resume();
+          return it;
+        }
+      };
+      return Awaiter {{mHandle}, *this};
+    }
+    friend auto operator==(Iterator const& it, std::default_sentinel_t) noexcept -> bool
+    {
+      return it.mHandle == nullptr || it.mHandle.done();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> mHandle {nullptr};
+  };
+
+  AsyncGenerator() noexcept = default;
+  AsyncGenerator(AsyncGenerator const&) = delete;
+  AsyncGenerator(AsyncGenerator&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+  AsyncGenerator& operator=(AsyncGenerator const&) = delete;
+  AsyncGenerator& operator=(AsyncGenerator&& other) noexcept
+  {
+    if (this != &other) {
+      destroy();
+      mHandle = std::exchange(other.mHandle, nullptr);
+    }
+    return *this;
+  }
+  // may be dropped while suspended at a `co_yield`, never while a `next()` is pending
+  ~AsyncGenerator() { destroy(); }
+
+  // `while (auto value = co_await gen.next())`, the value may be moved from
+  [[nodiscard]] auto next() noexcept -> NextAwaiter { return NextAwaiter {mHandle}; }
+  // `for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it)`
+  [[nodiscard]] auto begin() noexcept
+  {
+    struct Awaiter : NextAwaiter {
+      auto await_resume() -> Iterator
+      {
+        NextAwaiter::await_resume();
+        return Iterator {this->generator};
+      }
+    };
+    return Awaiter {{mHandle}};
+  }
+  auto end() const noexcept -> std::default_sentinel_t { return {}; }
+
+private:
+  explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
+  auto destroy() noexcept -> void
+  {
+    if (mHandle) {
+      std::exchange(mHandle, nullptr).destroy();
+    }
+  }
+
+  std::coroutine_handle<promise_type> mHandle {nullptr};
+};
+} // namespace async
@@ -0,0 +1,237 @@
+#pragma once
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+#include <memory>
+#include <optional>
+#include <stop_token>
+
+namespace async {
+template <typename Op>
+struct IoAwaiter;
+
+enum class Interest {
+  Read,
+  Write,
+};
+
+// Owns a non-blocking fd and its registration in the reactor.
+class IoHandle {
+public:
+  // sets O_NONBLOCK, see `Reactor::insertIo` for `mode`
+  static auto Create(Reactor& reactor, int fd, PollMode mode = PollMode::Edge) -> StdResult<IoHandle>;
+  IoHandle() = default;
+  IoHandle(IoHandle const&) = delete;
+  IoHandle(IoHandle&& other) noexcept
+      : mReactor(std::exchange(other.mReactor, nullptr)), mSource(std::exchange(other.mSource, nullptr)),
+        mFd(std::exchange(other.mFd, -1))
+  {
+  }
+  IoHandle& operator=(IoHandle const&) = delete;
+  IoHandle& operator=(IoHandle&& other) noexcept
+  {
+    if (this != &other) {
+      close();
+      mReactor = std::exchange(other.mReactor, nullptr);
+      mSource = std::exchange(other.mSource, nullptr);
+      mFd = std::exchange(other.mFd, -1);
+    }
+    return *this;
+  }
+  ~IoHandle() { close(); }
+
+  auto fd() const -> int { return mFd; }
+  auto reactor() const -> Reactor& { return *mReactor; }
+  auto isValid() const -> bool { return mFd != -1; }
+  // deregister and close fd, pending operations must be finished
+  auto close() -> void;
+
+  // suspend until the fd is readable or writable
+  [[nodiscard]] auto readable() { return ReadyAwaiter {*this, Interest::Read}; }
+  [[nodiscard]] auto writable() { return ReadyAwaiter {*this, Interest::Write}; }
+
+  // Run `op` right away, only when it reports EAGAIN the interest is registered and `op` is retried after
+  // readiness, so a ready fd never touches the poller. The wait lives in the awaiter, nothing is allocated.
+  template <typename Op>
+  [[nodiscard]] auto io(Interest interest, Op op);
+
+private:
+  template <typename Op>
+  friend struct IoAwaiter;
+
+  IoHandle(Reactor& reactor, Source* source, int fd) : mReactor(&reactor), mSource(source), mFd(fd)
+  {
+  }
+
+  struct ReadyAwaiter {
+    // takes the registration back and resumes the waiter early, nothing happens once readiness won
+    struct Canceller {
+      ReadyAwaiter* self;
+      auto operator()() noexcept -> void { self->cancel(); }
+    };
+    IoHandle& io;
+    Interest interest;
+    SourceWaker* waker = nullptr; // retries the operation before resuming, see `IoAwaiter`
+    std::errc error {};
+    ExecutorRef executor;
+    std::stop_token const* stop = nullptr;
+    std::optional<std::stop_callback<Canceller>> onStop;
+
+    auto await_ready() const noexcept -> bool { return false; }
+    template <typename P>
+    auto await_suspend(std::coroutine_handle<P> handle) -> bool
+    {
+      auto token = StopTokenOf(handle);
+      if (token != nullptr && token->stop_possible()) {
+        stop = token;
+        executor = ExecutorRef::Current();
+        onStop.emplace(*token, Canceller {this});
+      }
+      return arm(handle);
+    }
+    // register on the source, true once suspended; false to go on right away, with `error` set when that failed
+    auto arm(std::coroutine_handle<> handle) -> bool
+    {
+      // a stop request may resume us once the handle is set, only locals from here on
+      auto& source = *io.mSource;
+      auto reactor = io.mReactor;
+      auto read = interest == Interest::Read;
+      auto set = StdResult<bool> {};
+      if (waker != nullptr) {
+        waker->handle = handle;
+        set = read ? source.setReadable(*waker, stop) : source.setWritable(*waker, stop);
+      } else {
+        set = read ? source.setReadable(handle, stop) : source.setWritable(handle, stop);
+      }
+      if (!set) {
+        error = set.error();
+        return false;
+      }
+      if (!set.value()) {
+        return false; // an edge arrived since the last wait
+      }
+      if (auto r = reactor->updateIo(source); !r) {
+        if (!(read ? source.takeReadable() : source.takeWritable())) {
+          return true; // the stop request got it first
+        }
+        error = r.error();
+        return false;
+      }
+      return true;
+    }
+    auto await_resume() const -> StdResult<void>
+    {
+      if (error != std::errc {}) {
+        return make_unexpected(error);
+      }
+      return {};
+    }
+
+    auto cancel() -> void
+    {
+      auto& source = *io.mSource;
+      Source::AfterStop();
+      if (auto handle = interest == Interest::Read ? source.takeReadable() : source.takeWritable()) {
+        error = std::errc::operation_canceled;
+        (void)io.mReactor->updateIo(*io.mSource);
+        executor.execute(handle);
+      }
+    }
+  };
+
+  Reactor* mReactor {nullptr};
+  Source* mSource {nullptr}; // owned by the reactor's registry until `close`
+  int mFd {-1};
+};
+
+// Retries `op` on the reactor thread when readiness comes in, a stale wakeup waits on the source again so the
+// caller is only resumed with a result that is not EAGAIN.
+template <typename Op>
+struct IoAwaiter : SourceWaker {
+  using Result = std::invoke_result_t<Op&>;
+  IoHandle& io;
+  Interest interest;
+  Op op;
+  Result result {};
+  std::optional<IoHandle::ReadyAwaiter> wait {}; // set while suspended on the source
+
+  IoAwaiter(IoHandle& io, Interest interest, Op op)
+      : SourceWaker {&IoAwaiter::Wake, nullptr}, io(io), interest(interest), op(std::move(op))
+  {
+  }
+
+  static auto WouldBlock(Result const& r) -> bool
+  {
+    return !r && r.error() == std::errc::resource_unavailable_try_again;
+  }
+
+  auto await_ready() -> bool
+  {
+    result = op();
+    return !WouldBlock(result);
+  }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> handle) -> bool
+  {
+    if (wait.emplace(io, interest, this).await_suspend(handle)) {
+      return true;
+    }
+    return retry();
+  }
+  auto await_resume() -> Result
+  {
+    if (wait) {
+      auto ready = wait->await_resume();
+      wait.reset();
+      if (!ready) {
+        return make_unexpected(ready.error());
+      }
+    }
+    return std::move(result);
+  }
+
+private:
+  // `wait` just told to go on: run `op` and register again while it would block, true once suspended
+  auto retry() -> bool
+  {
+    while (true) {
+      if (wait->error != std::errc {}) {
+        return false;
+      }
+      result = op();
+      if (!WouldBlock(result)) {
+        return false;
+      }
+      if (wait->arm(handle)) {
+        return true; // may be resumed already, hands off
+      }
+    }
+  }
+  static auto Wake(SourceWaker* self) noexcept -> std::coroutine_handle<>
+  {
+    auto& awaiter = static_cast<IoAwaiter&>(*self);
+    auto handle = awaiter.handle;
+    return awaiter.retry() ? nullptr : handle;
+  }
+};
+
+// transform the result of `inner` with `fn` when resumed
+template <typename Awaiter, typename Fn>
+struct MapAwaiter {
+  Awaiter inner;
+  Fn fn;
+
+  auto await_ready() -> bool { return inner.await_ready(); }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> handle)
+  {
+    return inner.await_suspend(handle);
+  }
+  auto await_resume() { return fn(inner.await_resume()); }
+};
+
+template <typename Op>
+inline auto IoHandle::io(Interest interest, Op op)
+{
+  return IoAwaiter<Op> {*this, interest, std::move(op)};
+}
+} // namespace async
@@ -0,0 +1,199 @@
+#pragma once
+#include "Async/BufferPool.hpp"
+#include "Async/Io.hpp"
+#include <netinet/in.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+namespace async {
+class SocketAddr {
+public:
+  SocketAddr() : mStorage(), mLen(0) {}
+  SocketAddr(sockaddr const* addr, socklen_t len);
+  // "127.0.0.1:8080" or "[::1]:8080"
+  static auto Parse(std::string_view addr) -> StdResult<SocketAddr>;
+  static auto V4(uint32_t ip, uint16_t port) -> SocketAddr;
+  static auto V6(in6_addr const& ip, uint16_t port) -> SocketAddr;
+
+  auto family() const -> int { return mStorage.ss_family; }
+  auto port() const -> uint16_t;
+  auto toString() const -> std::string;
+
+  auto data() const -> sockaddr const* { return reinterpret_cast<sockaddr const*>(&mStorage); }
+  auto data() -> sockaddr* { return reinterpret_cast<sockaddr*>(&mStorage); }
+  auto len() const -> socklen_t { return mLen; }
+  auto len() -> socklen_t& { return mLen; }
+  static constexpr auto capacity() -> socklen_t { return sizeof(sockaddr_storage); }
+
+private:
+  sockaddr_storage mStorage;
+  socklen_t mLen;
+};
+
+class TcpStream {
+public:
+  TcpStream() = default;
+  explicit TcpStream(IoHandle io) : mIo(std::move(io)) {}
+  // fd must be a connected stream socket
+  static auto FromFd(Reactor& reactor, int fd) -> StdResult<TcpStream>;
+  [[nodiscard]] static auto Connect(Reactor& reactor, SocketAddr addr) -> Task<StdResult<TcpStream>>;
+
+  [[nodiscard]] auto read(std::span<std::byte> buf)
+  {
+    return mIo.io(Interest::Read, [fd = mIo.fd(), buf]() -> StdResult<size_t> {
+      return SysCall(::recv, fd, buf.data(), buf.size(), 0).map([](auto n) { return static_cast<size_t>(n); });
+    });
+  }
+  // Borrows a buffer from `pool` only for a read that finds data, so an idle stream holds none; when the pool is
+  // exhausted it waits for readiness before queueing for a buffer. With the pool provided to this stream's reactor
+  // the kernel picks the buffer once data arrived, falling back to the free list when all of those are taken.
+  // Resumes with the filled buffer, an empty handle at the end of the stream.
+  [[nodiscard]] auto read(BufferPool& pool) -> Task<StdResult<PooledBuffer>>;
+  [[nodiscard]] auto write(std::span<std::byte const> buf)
+  {
+    return mIo.io(Interest::Write, [fd = mIo.fd(), buf]() -> StdResult<size_t> {
+      return SysCall(::send, fd, buf.data(), buf.size(), MSG_NOSIGNAL).map([](auto n) {
+        return static_cast<size_t>(n);
+      });
+    });
+  }
+  // keep writing until the whole buffer is sent
+  [[nodiscard]] auto writeAll(std::span<std::byte const> buf) -> Task<StdResult<void>>;
+
+  // scatter/gather, one syscall for all the buffers; the iovecs must stay alive until resumed
+  [[nodiscard]] auto readv(std::span<iovec const> bufs)
+  {
+    return mIo.io(Interest::Read, [fd = mIo.fd(), bufs]() -> StdResult<size_t> {
+      return SysCall(::readv, fd, bufs.data(), static_cast<int>(bufs.size())).map([](auto n) {
+        return static_cast<size_t>(n);
+      });
+    });
+  }
+  [[nodiscard]] auto writev(std::span<iovec const> bufs)
+  {
+    return mIo.io(Interest::Write, [fd = mIo.fd(), bufs]() -> StdResult<size_t> {
+      auto msg = msghdr {};
+      msg.msg_iov = const_cast<iovec*>(bufs.data());
+      msg.msg_iovlen = bufs.size();
+      return SysCall(::sendmsg, fd, &msg, MSG_NOSIGNAL).map([](auto n) { return static_cast<size_t>(n); });
+    });
+  }
+  // keep writing until every buffer is sent, `bufs` is consumed: the iovecs are advanced past what went out
+  [[nodiscard]] auto writevAll(std::span<iovec> bufs) -> Task<StdResult<void>>;
+
+  // `count` bytes of `fd` from `offset` on, copied by the kernel; `fd` must support mmap-like reads, e.g. a
+  // regular file. Resumes with the bytes sent by one sendfile call, 0 at the end of the file.
+  [[nodiscard]] auto sendFile(int fd, uint64_t offset, size_t count)
+  {
+    return mIo.io(Interest::Write, [out = mIo.fd(), fd, offset, count]() { return SendFile(out, fd, offset, count); });
+  }
+  // keep sending until `count` bytes went out or the file ended, resumes with the bytes sent
+  [[nodiscard]] auto sendFileAll(int fd, uint64_t offset, size_t count) -> Task<StdResult<size_t>>;
+  // like `sendFileAll` but moved page by page through a pipe with splice, `fd` may be anything splice reads from
+  // without blocking
+  [[nodiscard]] auto spliceFrom(int fd, uint64_t offset, size_t count) -> Task<StdResult<size_t>>;
+
+  // MSG_ZEROCOPY: the kernel sends straight from `buf` instead of copying it, so `buf` must stay untouched until
+  // resumed. Resumes once everything is sent and the completion notification of every part came back through the
+  // error queue, `zeroCopyFallbacks` counts the parts the kernel copied anyway, e.g. over loopback.
+  [[nodiscard]] auto sendZeroCopy(std::span<std::byte const> buf) -> Task<StdResult<void>>;
+  [[nodiscard]] auto zeroCopyFallbacks() const -> size_t { return mZeroCopyCopied; }
+
+  auto shutdown(int how = SHUT_WR) -> StdResult<void>;
+  auto setNoDelay(bool enable) -> StdResult<void>;
+  auto localAddr() const -> StdResult<SocketAddr>;
+  auto peerAddr() const -> StdResult<SocketAddr>;
+  auto handle() -> IoHandle& { return mIo; }
+  auto fd() const -> int { return mIo.fd(); }
+  auto close() -> void { mIo.close(); }
+
+private:
+  static auto SendFile(int out, int fd, uint64_t offset, size_t count) -> StdResult<size_t>;
+  // drain the completion notifications queued so far, false when there were none
+  auto reapZeroCopy() -> StdResult<bool>;
+
+  IoHandle mIo;
+  bool mZeroCopy = false;      // SO_ZEROCOPY set
+  size_t mZeroCopyPending = 0; // MSG_ZEROCOPY sends without a completion notification yet
+  size_t mZeroCopyCopied = 0;
+};
+
+class TcpListener {
+public:
+  TcpListener() = default;
+  static auto Bind(Reactor& reactor, SocketAddr const& addr, int backlog = SOMAXCONN) -> StdResult<TcpListener>;
+
+  [[nodiscard]] auto accept()
+  {
+    auto op = [fd = mIo.fd()]() -> StdResult<int> {
+      return SysCall(::accept4, fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    };
+    auto map = [&reactor = mIo.reactor()](StdResult<int> fd) -> StdResult<TcpStream> {
+      if (!fd) {
+        return make_unexpected(fd.error());
+      }
+      return TcpStream::FromFd(reactor, fd.value());
+    };
+    return MapAwaiter<IoAwaiter<decltype(op)>, decltype(map)> {mIo.io(Interest::Read, op), map};
+  }
+
+  auto localAddr() const -> StdResult<SocketAddr>;
+  auto handle() -> IoHandle& { return mIo; }
+  auto fd() const -> int { return mIo.fd(); }
+  auto close() -> void { mIo.close(); }
+
+private:
+  explicit TcpListener(IoHandle io) : mIo(std::move(io)) {}
+  IoHandle mIo;
+};
+
+class UdpSocket {
+public:
+  UdpSocket() = default;
+  static auto Bind(Reactor& reactor, SocketAddr const& addr) -> StdResult<UdpSocket>;
+  // set default peer for `send` and `recv`
+  auto connect(SocketAddr const& addr) -> StdResult<void>;
+
+  [[nodiscard]] auto send(std::span<std::byte const> buf)
+  {
+    return mIo.io(Interest::Write, [fd = mIo.fd(), buf]() -> StdResult<size_t> {
+      return SysCall(::send, fd, buf.data(), buf.size(), 0).map([](auto n) { return static_cast<size_t>(n); });
+    });
+  }
+  [[nodiscard]] auto recv(std::span<std::byte> buf)
+  {
+    return mIo.io(Interest::Read, [fd = mIo.fd(), buf]() -> StdResult<size_t> {
+      return SysCall(::recv, fd, buf.data(), buf.size(), 0).map([](auto n) { return static_cast<size_t>(n); });
+    });
+  }
+  [[nodiscard]] auto sendTo(std::span<std::byte const> buf, SocketAddr const& addr)
+  {
+    return mIo.io(Interest::Write, [fd = mIo.fd(), buf, &addr]() -> StdResult<size_t> {
+      return SysCall(::sendto, fd, buf.data(), buf.size(), 0, addr.data(), addr.len()).map([](auto n) {
+        return static_cast<size_t>(n);
+      });
+    });
+  }
+  [[nodiscard]] auto recvFrom(std::span<std::byte> buf, SocketAddr& from)
+  {
+    return mIo.io(Interest::Read, [fd = mIo.fd(), buf, &from]() -> StdResult<size_t> {
+      from.len() = SocketAddr::capacity();
+      return SysCall(::recvfrom, fd, buf.data(), buf.size(), 0, from.data(), &from.len()).map([](auto n) {
+        return static_cast<size_t>(n);
+      });
+    });
+  }
+
+  auto localAddr() const -> StdResult<SocketAddr>;
+  auto handle() -> IoHandle& { return mIo; }
+  auto fd() const -> int { return mIo.fd(); }
+  auto close() -> void { mIo.close(); }
+
+private:
+  explicit UdpSocket(IoHandle io) : mIo(std::move(io)) {}
+  IoHandle mIo;
+};
+} // namespace async
@@ -1,85 +1,720 @@
 #pragma once
-#include "Runtime.hpp"
-#include "Task.hpp"
-#include "ThreadSafe.hpp"
+#include "ExecutorRef.hpp"
+#include "Async/Task.hpp"
+#include "Async/utils/predefined.hpp"
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
 namespace async {
+namespace detail {
+// every primitive parks the awaiter itself, no allocation
+struct Waiter {
+  Waiter* next;
+  std::coroutine_handle<> handle;
+  ExecutorRef executor; // where the waiter was running, it is resumed there
+  // set on waiters that can be cancelled: claims the node for resumption, false when it was cancelled and has to
+  // be skipped; either way the node must not be touched by the primitive afterwards
+  bool (*tryClaim)(Waiter*) noexcept = nullptr;
 
+  auto prepare(std::coroutine_handle<> in) noexcept -> void
+  {
+    handle = in;
+    executor = ExecutorRef::Current();
+  }
+  auto resume() const -> void { executor.execute(handle); }
+};
+
+// LIFO stack (as pushed by CAS) to FIFO
+inline auto Reverse(Waiter* stack) noexcept -> Waiter*
+{
+  auto reversed = static_cast<Waiter*>(nullptr);
+  while (stack != nullptr) {
+    auto next = stack->next;
+    stack->next = reversed;
+    reversed = stack;
+    stack = next;
+  }
+  return reversed;
+}
+
+// resume a list taken out of a primitive, nodes must not be touched once resumed
+inline auto ResumeAll(Waiter* list) -> void
+{
+  while (list != nullptr) {
+    auto next = list->next;
+    list->resume();
+    list = next;
+  }
+}
+
+// intrusive FIFO, synchronized by its owner
+struct WaiterQueue {
+  Waiter* head = nullptr;
+  Waiter* tail = nullptr;
+
+  [[nodiscard]] auto empty() const noexcept -> bool { return head == nullptr; }
+  auto push(Waiter* waiter) noexcept -> void
+  {
+    waiter->next = nullptr;
+    append(waiter, waiter);
+  }
+  // `first` .. `last` already linked
+  auto append(Waiter* first, Waiter* last) noexcept -> void
+  {
+    if (tail != nullptr) {
+      tail->next = first;
+    } else {
+      head = first;
+    }
+    tail = last;
+  }
+  auto pop() noexcept -> Waiter*
+  {
+    auto waiter = head;
+    if (waiter != nullptr) {
+      head = waiter->next;
+      if (head == nullptr) {
+        tail = nullptr;
+      }
+    }
+    return waiter;
+  }
+  auto take() noexcept -> Waiter*
+  {
+    tail = nullptr;
+    return std::exchange(head, nullptr);
+  }
+};
+
+// guards slow paths that only move a few pointers, never held across a resume
+class SpinLock {
+public:
+  auto lock() noexcept -> void
+  {
+    while (mFlag.test_and_set(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+  auto unlock() noexcept -> void { mFlag.clear(std::memory_order_release); }
+
+private:
+  std::atomic_flag mFlag = ATOMIC_FLAG_INIT;
+};
+} // namespace detail
+
+// cppcoro style async mutex: the awaiter is the list node, one atomic word holds the state
+//   NOT_LOCKED | nullptr (locked, no waiters) | head of a LIFO stack of new waiters
+// the lock holder owns `mWaiters`, the FIFO rebuilt from that stack, so unlock needs no further synchronization
 class Mutex {
+  using Waiter = detail::Waiter;
+  struct CancellableWaiter;
+
 public:
   Mutex() = default;
-  [[nodiscard]] auto lock() -> Task<void>
-  {
-    bool expected = false;
-    if (mLocked.compare_exchange_strong(expected, true)) { // locked
-      co_return;                                           // held the lock
-    } else {
-      struct PendingAwaiter {
-        Mutex& mThis;
-        auto await_ready() const noexcept { return false; }
-        auto await_suspend(std::coroutine_handle<> h) noexcept { mThis.mPending.push(std::move(h)); }
-        auto await_resume() const noexcept {}
-      };
-      co_await PendingAwaiter {*this};
-      auto success = mLocked.compare_exchange_strong(expected, true);
-      assert(success);
+  Mutex(Mutex const&) = delete;
+  Mutex& operator=(Mutex const&) = delete;
+  ~Mutex() { assert(mState.load(std::memory_order_relaxed) == NOT_LOCKED && "Mutex destroyed while locked"); }
+
+  struct LockAwaiter {
+    struct Canceller {
+      CancellableWaiter* node;
+      auto operator()() noexcept -> void { node->cancel(); }
+    };
+    Mutex& mutex;
+    Waiter waiter {nullptr, nullptr, {}};
+    CancellableWaiter* node = nullptr;
+    bool cancelled = false;
+    std::optional<std::stop_callback<Canceller>> onStop;
+
+    LockAwaiter(Mutex& mutex) noexcept : mutex(mutex) {}
+    LockAwaiter(LockAwaiter const&) = delete;
+    LockAwaiter& operator=(LockAwaiter const&) = delete;
+    ~LockAwaiter()
+    {
+      onStop.reset();
+      if (node != nullptr) {
+        node->unref();
+      }
+    }
+
+    auto await_ready() const noexcept -> bool { return false; }
+    template <typename P>
+    auto await_suspend(std::coroutine_handle<P> handle) -> bool
+    {
+      auto stop = StopTokenOf(handle);
+      if (stop == nullptr || !stop->stop_possible()) {
+        waiter.prepare(handle);
+        return mutex.enqueue(&waiter);
+      }
+      if (mutex.try_lock()) {
+        return false;
+      }
+      if (stop->stop_requested()) {
+        cancelled = true;
+        return false;
+      }
+      // a stop request must be able to outlive us with the node still queued, so it goes on the heap
+      auto local = node = new CancellableWaiter {};
+      local->prepare(handle);
+      local->tryClaim = &CancellableWaiter::TryClaim;
+      onStop.emplace(*stop, Canceller {local});
+      if (!mutex.enqueue(local)) {
+        local->state.store(CancellableWaiter::CLAIMED, std::memory_order_relaxed);
+        local->refs.fetch_sub(2, std::memory_order_relaxed); // never queued
+        return false;
+      }
+      // resumable by an unlock or a stop request from here on, only `local` may be touched
+      auto expected = CancellableWaiter::INIT;
+      auto published = local->state.compare_exchange_strong(expected, CancellableWaiter::WAITING,
+                                                            std::memory_order_acq_rel);
+      local->unref();
+      // cancelled before it got published: nobody resumes it, it stays queued for the holder to skip
+      return published || expected == CancellableWaiter::CLAIMED;
     }
+    // canceled, without holding the lock, when stop was requested before it was handed over
+    auto await_resume() const noexcept -> StdResult<void>
+    {
+      if (cancelled ||
+          (node != nullptr && node->state.load(std::memory_order_acquire) == CancellableWaiter::CANCELLED)) {
+        return make_unexpected(std::errc::operation_canceled);
+      }
+      return {};
+    }
+  };
+
+  // resumes holding the lock, the lock is handed over to waiters in FIFO order
+  [[nodiscard]] auto lock() noexcept -> LockAwaiter { return LockAwaiter {*this}; }
+  [[nodiscard]] auto try_lock() noexcept -> bool
+  {
+    auto expected = NOT_LOCKED;
+    return mState.compare_exchange_strong(expected, nullptr, std::memory_order_acquire, std::memory_order_relaxed);
   }
+  struct HandoffAwaiter {
+    Mutex& mutex;
+    Waiter* next = nullptr;
+    auto await_ready() noexcept -> bool
+    {
+      next = mutex.release();
+      return next == nullptr;
+    }
+    auto await_suspend(std::coroutine_handle<> handle) -> std::coroutine_handle<>
+    {
+      auto target = next->handle;
+      auto current = ExecutorRef::Current();
+      if (!current || next->executor != current) {
+        // the waiter belongs to another executor, leave it there
+        next->resume();
+        return handle;
+      }
+      // `handle` may be resumed elsewhere as soon as it is queued, don't touch `this` afterwards
+      current.execute(handle);
+      return target;
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+
   auto unlock() -> void
   {
-    auto value = mPending.pop();
-    if (value.has_value()) {
-      Runtime<MultiThreadExecutor>::GetExecutor().execute(value.value());
-    } else {
-      mLocked = false;
+    if (auto next = release()) {
+      next->resume();
     }
   }
-  [[nodiscard]] auto try_lock() -> bool
+  // unlock, and when someone is waiting switch to it right away by symmetric transfer, the caller is queued on its
+  // executor (the local next slot on pool workers) instead of the other way round
+  [[nodiscard]] auto handoff() noexcept -> HandoffAwaiter { return HandoffAwaiter {*this}; }
+
+private:
+  // Queued by waiters with a stop token. It is shared by the awaiter, the queue and, while publishing, the
+  // suspending call: a cancelled node stays queued until the lock holder skips it.
+  struct CancellableWaiter : Waiter {
+    static constexpr int INIT = 0; // queued, `await_suspend` has not returned yet
+    static constexpr int WAITING = 1;
+    static constexpr int CLAIMED = 2;
+    static constexpr int CANCELLED = 3;
+    std::atomic_int state = INIT;
+    std::atomic_int refs = 3;
+
+    auto unref() noexcept -> void
+    {
+      if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+      }
+    }
+    static auto TryClaim(Waiter* waiter) noexcept -> bool
+    {
+      auto self = static_cast<CancellableWaiter*>(waiter);
+      auto current = self->state.load(std::memory_order_acquire);
+      while (current == INIT || current == WAITING) {
+        if (self->state.compare_exchange_weak(current, CLAIMED, std::memory_order_acq_rel)) {
+          break;
+        }
+      }
+      self->unref(); // the awaiter keeps it alive until resumed
+      return current != CANCELLED;
+    }
+    // only a published node is resumed here, an unpublished one is noticed by `await_suspend`
+    auto cancel() noexcept -> void
+    {
+      auto current = state.load(std::memory_order_acquire);
+      while (current == INIT || current == WAITING) {
+        if (state.compare_exchange_weak(current, CANCELLED, std::memory_order_acq_rel)) {
+          if (current == WAITING) {
+            resume();
+          }
+          return;
+        }
+      }
+    }
+  };
+
+  // false when the lock was free and is now held, otherwise `waiter` is queued
+  auto enqueue(Waiter* waiter) noexcept -> bool
   {
-    bool expected = false;
-    if (mLocked.compare_exchange_strong(expected, true)) {
-      return true;
-    } else {
-      return false;
+    auto state = mState.load(std::memory_order_acquire);
+    while (true) {
+      if (state == NOT_LOCKED) {
+        if (mState.compare_exchange_weak(state, nullptr, std::memory_order_acquire)) {
+          return false;
+        }
+      } else {
+        waiter->next = static_cast<Waiter*>(state);
+        if (mState.compare_exchange_weak(state, waiter, std::memory_order_release, std::memory_order_acquire)) {
+          return true;
+        }
+      }
     }
   }
 
-private:
-  mpmc::Queue<std::coroutine_handle<>> mPending; // TODO: use atomic linked list
-  std::atomic<bool> mLocked = false;
+  // unlocks, or passes the lock to the returned waiter; cancelled waiters are dropped on the way
+  auto release() -> Waiter*
+  {
+    while (true) {
+      if (mWaiters == nullptr) {
+        auto expected = static_cast<void*>(nullptr);
+        if (mState.compare_exchange_strong(expected, NOT_LOCKED, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+          return nullptr;
+        }
+        // new waiters arrived, take them all and reverse into FIFO order
+        auto stack = static_cast<Waiter*>(mState.exchange(nullptr, std::memory_order_acquire));
+        assert(stack != nullptr && stack != NOT_LOCKED);
+        mWaiters = detail::Reverse(stack);
+      }
+      auto next = mWaiters;
+      mWaiters = next->next;
+      if (next->tryClaim == nullptr || next->tryClaim(next)) {
+        return next;
+      }
+    }
+  }
+
+  static inline auto const NOT_LOCKED = reinterpret_cast<void*>(1);
+  std::atomic<void*> mState = NOT_LOCKED;
+  Waiter* mWaiters = nullptr; // only touched by the lock holder
 };
 
+// Waiters push themselves onto a lock-free LIFO stack, notifiers drain it into a FIFO. Notifiers are serialized by
+// a flag held for a few pointer moves only, waiting never blocks.
 class CondVar {
+  using Waiter = detail::Waiter;
+
 public:
   CondVar() = default;
-  [[nodiscard]] auto wait() -> Task<void>
-  {
-    struct PendingAwaiter {
-      CondVar& mThis;
-      auto await_ready() const noexcept { return false; }
-      auto await_suspend(std::coroutine_handle<> h) noexcept { mThis.mPending.push(std::move(h)); }
-      auto await_resume() const noexcept {}
-    };
-    co_await PendingAwaiter {*this};
-  }
+  CondVar(CondVar const&) = delete;
+  CondVar& operator=(CondVar const&) = delete;
+
+  struct WaitAwaiter {
+    CondVar& condVar;
+    Waiter waiter {nullptr, nullptr, {}};
+    auto await_ready() const noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> void
+    {
+      waiter.prepare(handle);
+      waiter.next = condVar.mPushed.load(std::memory_order_relaxed);
+      while (!condVar.mPushed.compare_exchange_weak(waiter.next, &waiter, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {}
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+
+  [[nodiscard]] auto wait() noexcept -> WaitAwaiter { return WaitAwaiter {*this}; }
   auto notify_one() -> bool
   {
-    auto value = mPending.pop();
-    if (value.has_value()) {
-      Runtime<MultiThreadExecutor>::GetExecutor().execute(value.value());
-      return true;
-    } else {
+    if (idle()) {
       return false;
     }
+    mNotifying.lock();
+    if (mWaiters.empty()) {
+      drain();
+    }
+    auto waiter = mWaiters.pop();
+    if (mWaiters.empty()) {
+      mQueued.store(false, std::memory_order_relaxed);
+    }
+    mNotifying.unlock();
+    if (waiter == nullptr) {
+      return false;
+    }
+    waiter->resume();
+    return true;
   }
   auto notify_all() -> void
   {
-    while (auto value = mPending.pop()) {
-      Runtime<MultiThreadExecutor>::GetExecutor().execute(value.value());
+    if (idle()) {
+      return;
+    }
+    mNotifying.lock();
+    drain();
+    auto waiters = mWaiters.take();
+    mQueued.store(false, std::memory_order_relaxed);
+    mNotifying.unlock();
+    detail::ResumeAll(waiters);
+  }
+
+private:
+  // Nobody to wake, without taking the lock. A notifier that sees the stack emptied by a drain also sees the flag that
+  // drain raised before, so waiters moved to `mWaiters` are not missed.
+  auto idle() const noexcept -> bool
+  {
+    return mPushed.load(std::memory_order_acquire) == nullptr && !mQueued.load(std::memory_order_relaxed);
+  }
+  // append the pushed stack to `mWaiters` in arrival order, notify lock held
+  auto drain() -> void
+  {
+    mQueued.store(true, std::memory_order_relaxed);
+    auto stack = mPushed.exchange(nullptr, std::memory_order_acq_rel);
+    if (stack != nullptr) {
+      mWaiters.append(detail::Reverse(stack), stack);
+    }
+  }
+
+  std::atomic<Waiter*> mPushed = nullptr;
+  detail::SpinLock mNotifying;
+  detail::WaiterQueue mWaiters; // guarded by mNotifying
+  std::atomic_bool mQueued = false; // `mWaiters` may be non-empty, written under mNotifying
+};
+
+// Writer-preferring read/write lock. One atomic word holds the reader count and the writer/waiting bits, so
+// uncontended lock and unlock of either kind are a single atomic operation. Once a writer waits new readers queue
+// behind it, and when the last writer leaves every queued reader is admitted in one batch.
+class RwLock {
+  using Waiter = detail::Waiter;
+  static constexpr uint64_t WRITER = uint64_t(1) << 60;
+  static constexpr uint64_t WRITERS_WAITING = uint64_t(1) << 61;
+  static constexpr uint64_t READERS_WAITING = uint64_t(1) << 62;
+  static constexpr uint64_t READER_MASK = WRITER - 1;
+
+public:
+  RwLock() = default;
+  RwLock(RwLock const&) = delete;
+  RwLock& operator=(RwLock const&) = delete;
+  ~RwLock() { assert(mState.load(std::memory_order_relaxed) == 0 && "RwLock destroyed while locked"); }
+
+  struct SharedAwaiter {
+    RwLock& rw;
+    Waiter waiter {nullptr, nullptr, {}};
+    auto await_ready() noexcept -> bool { return rw.try_lock_shared(); }
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> bool
+    {
+      waiter.prepare(handle);
+      auto lock = std::lock_guard(rw.mLock);
+      auto state = rw.mState.load(std::memory_order_acquire);
+      while (true) {
+        if ((state & (WRITER | WRITERS_WAITING)) == 0) {
+          if (rw.mState.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+            return false;
+          }
+        } else if (rw.mState.compare_exchange_weak(state, state | READERS_WAITING, std::memory_order_relaxed)) {
+          // from exactly the state we looked at: an unlock racing with us has to take the slow path
+          rw.mReaders.push(&waiter);
+          return true;
+        }
+      }
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+  struct UniqueAwaiter {
+    RwLock& rw;
+    Waiter waiter {nullptr, nullptr, {}};
+    auto await_ready() noexcept -> bool { return rw.try_lock(); }
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> bool
+    {
+      waiter.prepare(handle);
+      auto lock = std::lock_guard(rw.mLock);
+      auto state = rw.mState.load(std::memory_order_acquire);
+      while (true) {
+        if ((state & (READER_MASK | WRITER | WRITERS_WAITING)) == 0) {
+          if (rw.mState.compare_exchange_weak(state, state | WRITER, std::memory_order_acquire)) {
+            return false;
+          }
+        } else if (rw.mState.compare_exchange_weak(state, state | WRITERS_WAITING, std::memory_order_relaxed)) {
+          rw.mWriters.push(&waiter);
+          return true;
+        }
+      }
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+
+  [[nodiscard]] auto lock_shared() noexcept -> SharedAwaiter { return SharedAwaiter {*this}; }
+  [[nodiscard]] auto lock() noexcept -> UniqueAwaiter { return UniqueAwaiter {*this}; }
+  [[nodiscard]] auto try_lock_shared() noexcept -> bool
+  {
+    auto state = mState.load(std::memory_order_relaxed);
+    while ((state & (WRITER | WRITERS_WAITING)) == 0) {
+      if (mState.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  [[nodiscard]] auto try_lock() noexcept -> bool
+  {
+    auto expected = uint64_t(0);
+    return mState.compare_exchange_strong(expected, WRITER, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+  auto unlock_shared() -> void
+  {
+    auto state = mState.fetch_sub(1, std::memory_order_release);
+    assert((state & READER_MASK) != 0);
+    if ((state & READER_MASK) != 1 || (state & WRITERS_WAITING) == 0) {
+      return;
+    }
+    // last reader out with a writer waiting: no one can take the lock meanwhile, hand it over
+    mLock.lock();
+    state = mState.load(std::memory_order_relaxed); // queued readers may have set their bit meanwhile
+    assert((state & (READER_MASK | WRITER)) == 0);
+    auto writer = mWriters.pop();
+    state |= WRITER;
+    mState.store(mWriters.empty() ? state & ~WRITERS_WAITING : state, std::memory_order_release);
+    mLock.unlock();
+    writer->resume();
+  }
+  auto unlock() -> void
+  {
+    auto expected = WRITER;
+    if (mState.compare_exchange_strong(expected, 0, std::memory_order_release, std::memory_order_relaxed)) {
+      return;
+    }
+    mLock.lock();
+    auto state = mState.load(std::memory_order_relaxed);
+    assert((state & WRITER) != 0 && (state & READER_MASK) == 0);
+    if (auto writer = mWriters.pop()) {
+      mState.store(mWriters.empty() ? state & ~WRITERS_WAITING : state, std::memory_order_release);
+      mLock.unlock();
+      writer->resume();
+      return;
+    }
+    auto readers = mReaders.take();
+    auto count = uint64_t(0);
+    for (auto reader = readers; reader != nullptr; reader = reader->next) {
+      ++count;
+    }
+    mState.store(count, std::memory_order_release);
+    mLock.unlock();
+    detail::ResumeAll(readers);
+  }
+
+private:
+  // readers, WRITER and the waiting bits; the waiting bits mirror the queues and only change under mLock
+  std::atomic_uint64_t mState = 0;
+  detail::SpinLock mLock;
+  detail::WaiterQueue mReaders;
+  detail::WaiterQueue mWriters;
+};
+
+// Counting semaphore with FIFO waiters. `acquire` is one CAS while permits are left, `release` one fetch_add and a
+// load while nobody waits; the waiter queue is only locked on the slow paths.
+class Semaphore {
+  using Waiter = detail::Waiter;
+
+public:
+  explicit Semaphore(int64_t permits) : mPermits(permits) { assert(permits >= 0); }
+  Semaphore(Semaphore const&) = delete;
+  Semaphore& operator=(Semaphore const&) = delete;
+
+  struct AcquireAwaiter {
+    Semaphore& sem;
+    Waiter waiter {nullptr, nullptr, {}};
+    auto await_ready() noexcept -> bool { return sem.try_acquire(); }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      waiter.prepare(handle);
+      sem.mLock.lock();
+      sem.mWaiting.fetch_add(1, std::memory_order_seq_cst);
+      sem.mWaiters.push(&waiter);
+      // pairs with the fence in `release`: either it sees us waiting or we see its permit
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      // a permit released before we registered is not lost, but it belongs to the oldest waiter
+      if (!sem.try_acquire()) {
+        sem.mLock.unlock();
+        return true;
+      }
+      auto first = sem.mWaiters.pop();
+      sem.mWaiting.fetch_sub(1, std::memory_order_relaxed);
+      sem.mLock.unlock();
+      if (first == &waiter) {
+        return false;
+      }
+      first->resume();
+      return true;
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+
+  [[nodiscard]] auto acquire() noexcept -> AcquireAwaiter { return AcquireAwaiter {*this}; }
+  [[nodiscard]] auto try_acquire() noexcept -> bool
+  {
+    auto permits = mPermits.load(std::memory_order_relaxed);
+    while (permits > 0) {
+      if (mPermits.compare_exchange_weak(permits, permits - 1, std::memory_order_acquire,
+                                         std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  auto release(int64_t n = 1) -> void
+  {
+    mPermits.fetch_add(n, std::memory_order_release);
+    // pairs with the fence a waiter issues between registering and its last try_acquire
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mWaiting.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    auto woken = detail::WaiterQueue {};
+    mLock.lock();
+    while (!mWaiters.empty() && try_acquire()) {
+      woken.push(mWaiters.pop());
+      mWaiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+    mLock.unlock();
+    detail::ResumeAll(woken.take());
+  }
+  [[nodiscard]] auto available() const noexcept -> int64_t { return mPermits.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic_int64_t mPermits;
+  std::atomic_int64_t mWaiting = 0;
+  detail::SpinLock mLock;
+  detail::WaiterQueue mWaiters; // guarded by mLock
+};
+
+// Single-use countdown. Waiters push onto a lock-free stack that the final count_down swaps for DONE.
+class Latch {
+  using Waiter = detail::Waiter;
+
+public:
+  explicit Latch(int64_t count) : mCount(count) { assert(count >= 0); }
+  Latch(Latch const&) = delete;
+  Latch& operator=(Latch const&) = delete;
+
+  struct WaitAwaiter {
+    Latch& latch;
+    Waiter waiter {nullptr, nullptr, {}};
+    auto await_ready() const noexcept -> bool { return latch.try_wait(); }
+    auto await_suspend(std::coroutine_handle<> handle) noexcept -> bool
+    {
+      waiter.prepare(handle);
+      auto head = latch.mWaiters.load(std::memory_order_acquire);
+      do {
+        if (head == DONE) {
+          return false;
+        }
+        waiter.next = static_cast<Waiter*>(head);
+      } while (!latch.mWaiters.compare_exchange_weak(head, &waiter, std::memory_order_release,
+                                                     std::memory_order_acquire));
+      return true;
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+
+  auto count_down(int64_t n = 1) -> void
+  {
+    auto before = mCount.fetch_sub(n, std::memory_order_acq_rel);
+    assert(before >= n && "Latch counted below zero");
+    if (before == n) {
+      auto stack = mWaiters.exchange(DONE, std::memory_order_acq_rel);
+      detail::ResumeAll(detail::Reverse(static_cast<Waiter*>(stack)));
     }
   }
+  [[nodiscard]] auto try_wait() const noexcept -> bool { return mCount.load(std::memory_order_acquire) == 0; }
+  [[nodiscard]] auto wait() noexcept -> WaitAwaiter { return WaitAwaiter {*this}; }
+  [[nodiscard]] auto arrive_and_wait(int64_t n = 1) -> WaitAwaiter
+  {
+    count_down(n);
+    return wait();
+  }
 
 private:
-  mpmc::Queue<std::coroutine_handle<>> mPending;
+  static inline auto const DONE = reinterpret_cast<void*>(1);
+  std::atomic_int64_t mCount;
+  std::atomic<void*> mWaiters = nullptr; // stack of waiters, DONE once released
+};
+
+// Reusable barrier: every phase completes when `expected` participants have arrived, the last one to arrive
+// continues without suspending and resumes the others.
+class Barrier {
+  using Waiter = detail::Waiter;
+
+public:
+  explicit Barrier(int64_t expected) : mExpected(expected), mRemaining(expected) { assert(expected > 0); }
+  Barrier(Barrier const&) = delete;
+  Barrier& operator=(Barrier const&) = delete;
+
+  struct ArriveAwaiter {
+    Barrier& barrier;
+    Waiter waiter {nullptr, nullptr, {}};
+    auto await_ready() const noexcept -> bool { return false; }
+    auto await_suspend(std::coroutine_handle<> handle) -> bool
+    {
+      waiter.prepare(handle);
+      barrier.mLock.lock();
+      if (auto waiters = barrier.arrive(0)) {
+        barrier.mLock.unlock();
+        detail::ResumeAll(*waiters);
+        return false;
+      }
+      barrier.mWaiters.push(&waiter);
+      barrier.mLock.unlock();
+      return true;
+    }
+    auto await_resume() const noexcept -> void {}
+  };
+
+  [[nodiscard]] auto arrive_and_wait() noexcept -> ArriveAwaiter { return ArriveAwaiter {*this}; }
+  // leave for good: counts as an arrival in this phase and lowers `expected` for the following ones
+  auto arrive_and_drop() -> void
+  {
+    mLock.lock();
+    auto waiters = arrive(1);
+    mLock.unlock();
+    if (waiters) {
+      detail::ResumeAll(*waiters);
+    }
+  }
+
+private:
+  // lock held, the waiters of the completed phase if this arrival completed it
+  auto arrive(int64_t drop) -> std::optional<Waiter*>
+  {
+    assert(mRemaining > 0);
+    mExpected -= drop;
+    if (--mRemaining != 0) {
+      return std::nullopt;
+    }
+    mRemaining = mExpected;
+    return mWaiters.take();
+  }
+
+  detail::SpinLock mLock;
+  int64_t mExpected;  // guarded by mLock
+  int64_t mRemaining; // guarded by mLock
+  detail::WaiterQueue mWaiters;
 };
-} // namespace async
\ No newline at end of file
+} // namespace async
@@ -1,95 +1,361 @@
 #pragma once
-#include "Async/Slab.hpp"
+#include "Async/ExecutorRef.hpp"
+#include "Async/Task.hpp"
+#include "Async/Timer.hpp"
 #include "Async/sys/Event.hpp"
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <coroutine>
-#include <map>
+#include <limits>
 #include <mutex>
+#include <optional>
 #include <queue>
 #include <span>
+#include <stop_token>
+#include <sys/socket.h>
 
 namespace async {
-using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
+// Runs on the reactor thread in place of resuming a waiter once its direction turns ready, so the waiter's operation
+// is retried before anybody is resumed. Returns the coroutine to resume, or null after registering again.
+struct SourceWaker {
+  using WakeFn = std::coroutine_handle<> (*)(SourceWaker* self) noexcept;
+  WakeFn wakeFn = nullptr;
+  std::coroutine_handle<> handle; // the waiting coroutine
+};
 
+// Readiness state of one registered fd. A oneshot source is re-armed with the current interest by `updateIo` for
+// every wait. An edge triggered one is registered once for both directions, an edge that arrives while nobody waits
+// is cached in the direction and consumed by the next wait instead of suspending.
 struct Source {
+  // one word per direction: empty, a cached edge, the waiting coroutine's frame address or its tagged waker
   class Direction {
     friend struct Source;
-    // size_t tick;
-    std::coroutine_handle<> handle {nullptr};
+    static constexpr uintptr_t EMPTY = 0;
+    static constexpr uintptr_t READY = 1; // edge mode only, frames are never at odd addresses
+    static constexpr uintptr_t WAKER = 2; // tags a `SourceWaker`, which is pointer aligned
 
-    auto takeHandle() -> std::coroutine_handle<> { return std::exchange(handle, nullptr); }
-    auto isEmpty() const -> bool { return handle == nullptr; }
-  };
+    std::atomic<uintptr_t> state {EMPTY};
+
+    static auto Word(std::coroutine_handle<> handle) noexcept -> uintptr_t
+    {
+      return reinterpret_cast<uintptr_t>(handle.address());
+    }
+    static auto Word(SourceWaker& waker) noexcept -> uintptr_t { return reinterpret_cast<uintptr_t>(&waker) | WAKER; }
+    static auto Waker(uintptr_t word) noexcept -> SourceWaker*
+    {
+      return (word & WAKER) != 0 ? reinterpret_cast<SourceWaker*>(word & ~WAKER) : nullptr;
+    }
 
-  struct State {
-    Direction read;
-    Direction write;
+    auto takeWord() noexcept -> uintptr_t
+    {
+      auto current = state.load(std::memory_order_acquire);
+      while (current > READY) {
+        if (state.compare_exchange_weak(current, EMPTY, std::memory_order_acq_rel)) {
+          return current;
+        }
+      }
+      return EMPTY;
+    }
+    // the waiting coroutine without running its waker
+    auto take() noexcept -> std::coroutine_handle<>
+    {
+      auto word = takeWord();
+      if (word == EMPTY) {
+        return nullptr;
+      }
+      if (auto waker = Waker(word)) {
+        return waker->handle;
+      }
+      return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(word));
+    }
+    auto waiting() const noexcept -> bool { return state.load(std::memory_order_acquire) > READY; }
   };
 
-  Source(int fd, size_t key) : fd(fd), key(key) {}
-  int const fd;
-  size_t key;
+  int fd = -1;
+  size_t key = 0;
+  // atomic only because a late event for a removed source may still look at a reused slot
+  std::atomic_bool edge = false;
+  Direction read;
+  Direction write;
+
+  auto reset(int newFd, size_t newKey, PollMode mode) noexcept -> void
+  {
+    fd = newFd;
+    key = newKey;
+    edge.store(mode == PollMode::Edge, std::memory_order_relaxed);
+    read.state.store(Direction::EMPTY, std::memory_order_relaxed);
+    write.state.store(Direction::EMPTY, std::memory_order_relaxed);
+  }
+  [[nodiscard]] auto isEdge() const noexcept -> bool { return edge.load(std::memory_order_relaxed); }
 
-  std::mutex stateLock;
-  State state;
-  auto setReadable(std::coroutine_handle<> handle) -> bool
+  // true when `handle` was registered, false when a cached edge was consumed instead and the caller should go on;
+  // busy when another coroutine waits on this direction, canceled when `stop` was requested
+  auto setReadable(std::coroutine_handle<> handle, std::stop_token const* stop = nullptr) -> StdResult<bool>
+  {
+    return set(read, Direction::Word(handle), stop);
+  }
+  auto setWritable(std::coroutine_handle<> handle, std::stop_token const* stop = nullptr) -> StdResult<bool>
+  {
+    return set(write, Direction::Word(handle), stop);
+  }
+  // same, but readiness runs `waker` instead of queueing `waker.handle`
+  auto setReadable(SourceWaker& waker, std::stop_token const* stop = nullptr) -> StdResult<bool>
+  {
+    return set(read, Direction::Word(waker), stop);
+  }
+  auto setWritable(SourceWaker& waker, std::stop_token const* stop = nullptr) -> StdResult<bool>
   {
-    auto lk = std::scoped_lock {stateLock};
-    if (state.read.isEmpty()) {
-      state.read.handle = handle;
-      return true;
+    return set(write, Direction::Word(waker), stop);
+  }
+  auto takeReadable() noexcept -> std::coroutine_handle<> { return read.take(); }
+  auto takeWritable() noexcept -> std::coroutine_handle<> { return write.take(); }
+  // to be called by a stop callback before it takes a handle back
+  static auto AfterStop() noexcept -> void { std::atomic_thread_fence(std::memory_order_seq_cst); }
+  // called by the reactor for a readiness event, queues the waiters or caches the edge
+  auto wake(bool readable, bool writable, std::vector<std::coroutine_handle<>>& handles) -> void
+  {
+    if (readable) {
+      wake(read, handles);
     }
-    return false;
+    if (writable) {
+      wake(write, handles);
+    }
+  }
+  auto getEvent() const -> Event
+  {
+    auto event = Event::None(key);
+    event.readable = read.waiting();
+    event.writable = write.waiting();
+    return event;
   }
-  auto setWritable(std::coroutine_handle<> handle) -> bool
+
+private:
+  auto set(Direction& direction, uintptr_t word, std::stop_token const* stop) -> StdResult<bool>
   {
-    auto lk = std::scoped_lock {stateLock};
-    if (state.write.isEmpty()) {
-      state.write.handle = handle;
-      return true;
+    auto current = direction.state.load(std::memory_order_acquire);
+    while (true) {
+      if (current > Direction::READY) {
+        return make_unexpected(std::errc::device_or_resource_busy);
+      }
+      if (stop != nullptr && stop->stop_requested()) {
+        return make_unexpected(std::errc::operation_canceled);
+      }
+      auto next = current == Direction::READY ? Direction::EMPTY : word;
+      if (direction.state.compare_exchange_weak(current, next, std::memory_order_acq_rel)) {
+        if (current == Direction::READY) {
+          return false;
+        }
+        break;
+      }
+    }
+    if (stop != nullptr) {
+      // pairs with the fence in `AfterStop`: either the stop callback finds the handle or this sees the request
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (stop->stop_requested() && direction.take()) {
+        return make_unexpected(std::errc::operation_canceled);
+      }
+    }
+    return true;
+  }
+  auto wake(Direction& direction, std::vector<std::coroutine_handle<>>& handles) -> void
+  {
+    if (auto word = direction.takeWord(); word != Direction::EMPTY) {
+      if (auto waker = Direction::Waker(word)) {
+        if (auto handle = waker->wakeFn(waker)) {
+          handles.push_back(handle);
+        }
+      } else {
+        handles.push_back(std::coroutine_handle<>::from_address(reinterpret_cast<void*>(word)));
+      }
+    } else if (isEdge()) {
+      auto expected = Direction::EMPTY;
+      direction.state.compare_exchange_strong(expected, Direction::READY, std::memory_order_acq_rel);
+      if (expected > Direction::READY) {
+        wake(direction, handles); // a waiter came in between
+      }
+    }
+  }
+};
+
+// Sources live inline in fixed pages that are never moved or freed while the registry lives. A key is the slot index
+// with the slot's generation in the high half, it goes to the poller as the event's user data. Looking it up is a
+// page load and a generation compare without any lock, so an event for a removed source is dropped; one racing with
+// the removal may still reach the reused slot, which only costs its new owner a spurious wakeup.
+class SourceRegistry {
+public:
+  static constexpr size_t PAGE_BITS = 10;
+  static constexpr size_t PAGE_SIZE = size_t {1} << PAGE_BITS;
+  static constexpr size_t MAX_PAGES = 4096; // 4M sources per reactor
+
+  SourceRegistry() = default;
+  SourceRegistry(SourceRegistry const&) = delete;
+  SourceRegistry& operator=(SourceRegistry const&) = delete;
+  ~SourceRegistry()
+  {
+    for (auto& page : mPages) {
+      delete[] page.load(std::memory_order_relaxed);
     }
-    return false;
   }
 
-  auto takeReadable() -> std::coroutine_handle<>
+  // null once every slot is taken
+  auto insert(int fd, PollMode mode) -> Source*
   {
-    auto lk = std::scoped_lock {stateLock};
-    return state.read.takeHandle();
+    auto index = popFree();
+    if (index == NONE) {
+      index = mNext.fetch_add(1, std::memory_order_relaxed);
+      if (index >= MAX_PAGES * PAGE_SIZE) {
+        return nullptr;
+      }
+    }
+    auto& slot = slotAt(index);
+    auto generation = slot.generation.load(std::memory_order_relaxed);
+    slot.source.reset(fd, (static_cast<uint64_t>(generation) << 32) | index, mode);
+    return &slot.source;
   }
-  auto takeWritable() -> std::coroutine_handle<>
+  // the source must be out of the poller already
+  auto remove(Source& source) -> void
   {
-    auto lk = std::scoped_lock {stateLock};
-    return state.write.takeHandle();
+    auto index = static_cast<uint32_t>(source.key);
+    auto& slot = slotAt(index);
+    slot.generation.fetch_add(1, std::memory_order_release);
+    pushFree(index);
   }
-  auto getEvent() -> Event
+  auto find(uint64_t key) const noexcept -> Source*
   {
-    auto lk = std::scoped_lock {stateLock};
-    auto event = Event::None(key);
-    if (!state.read.isEmpty()) {
-      event.readable = true;
+    auto index = static_cast<uint32_t>(key);
+    if ((index >> PAGE_BITS) >= MAX_PAGES) {
+      return nullptr;
     }
-    if (!state.write.isEmpty()) {
-      event.writable = true;
+    auto page = mPages[index >> PAGE_BITS].load(std::memory_order_acquire);
+    if (page == nullptr) {
+      return nullptr;
     }
-    return event;
+    auto& slot = page[index & (PAGE_SIZE - 1)];
+    if (slot.generation.load(std::memory_order_acquire) != static_cast<uint32_t>(key >> 32)) {
+      return nullptr;
+    }
+    return &slot.source;
+  }
+
+private:
+  static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+  struct Slot {
+    Source source;
+    std::atomic_uint32_t generation = 0;
+    std::atomic_uint32_t nextFree = NONE;
+  };
+
+  auto slotAt(uint32_t index) -> Slot&
+  {
+    auto& entry = mPages[index >> PAGE_BITS];
+    auto page = entry.load(std::memory_order_acquire);
+    if (page == nullptr) {
+      auto fresh = new Slot[PAGE_SIZE];
+      if (entry.compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+        page = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    return page[index & (PAGE_SIZE - 1)];
+  }
+  // Treiber stack of free slots, the head carries a tag against ABA
+  auto popFree() -> uint32_t
+  {
+    auto head = mFree.load(std::memory_order_acquire);
+    while (static_cast<uint32_t>(head) != NONE) {
+      auto index = static_cast<uint32_t>(head);
+      auto next = slotAt(index).nextFree.load(std::memory_order_relaxed);
+      if (mFree.compare_exchange_weak(head, Tagged(next, head), std::memory_order_acq_rel)) {
+        return index;
+      }
+    }
+    return NONE;
+  }
+  auto pushFree(uint32_t index) -> void
+  {
+    auto& slot = slotAt(index);
+    auto head = mFree.load(std::memory_order_relaxed);
+    do {
+      slot.nextFree.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    } while (!mFree.compare_exchange_weak(head, Tagged(index, head), std::memory_order_release));
+  }
+  static auto Tagged(uint32_t index, uint64_t previous) -> uint64_t
+  {
+    return (((previous >> 32) + 1) << 32) | index;
   }
+
+  std::array<std::atomic<Slot*>, MAX_PAGES> mPages {};
+  std::atomic_uint64_t mFree = NONE;
+  std::atomic_uint32_t mNext = 0;
 };
 
 struct TimerOp {
-  struct Insert {
-    size_t key;
-    TimePoint when;
-    std::coroutine_handle<> handle;
-  };
-  struct Remove {
-    size_t key;
-    TimePoint when;
-  };
-  std::variant<Insert, Remove> op;
+  size_t key;
+  TimePoint when;
+  std::coroutine_handle<> handle;
+};
+
+// state of one operation submitted to the completion poller, lives in the awaiter
+struct CompletionOp {
+  std::coroutine_handle<> handle {nullptr};
+  int32_t result {0};
+  uint32_t flags {0};
 };
 
 class Reactor;
 
+template <typename ResultTy, typename PrepFn>
+struct CompletionAwaiter {
+  Reactor* reactor;
+  PrepFn prep;
+  CompletionOp op {};
+
+  auto await_ready() const noexcept -> bool { return false; }
+  auto await_suspend(std::coroutine_handle<> handle) -> bool;
+  auto await_resume() -> StdResult<ResultTy>
+  {
+    if (op.result < 0) {
+      return make_unexpected(std::errc(-op.result));
+    }
+    if constexpr (std::is_void_v<ResultTy>) {
+      return {};
+    } else if constexpr (std::is_same_v<ResultTy, CompletionOp>) {
+      return op; // result and cqe flags as they came
+    } else {
+      return static_cast<ResultTy>(op.result);
+    }
+  }
+};
+
+// `Reactor::sleep`, resumes early with `operation_canceled` when the sleeping task is stopped
+struct SleepAwaiter {
+  // takes the timer back and resumes the sleeper, nothing happens once it fired
+  struct Canceller {
+    SleepAwaiter* self;
+    auto operator()() noexcept -> void;
+  };
+  SleepAwaiter(Reactor* reactor, TimePoint when);
+  Reactor* reactor;
+  TimePoint when;
+  size_t id;
+  bool cancelled = false;
+  ExecutorRef executor;
+  std::optional<std::stop_callback<Canceller>> onStop;
+
+  auto await_ready() const noexcept -> bool { return false; }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> handle) -> bool;
+  auto await_resume() const noexcept -> StdResult<void>
+  {
+    if (cancelled) {
+      return make_unexpected(std::errc::operation_canceled);
+    }
+    return {};
+  }
+};
+
 struct ReactorLock {
   Reactor& reactor;
   std::unique_lock<std::mutex> eventLock; // eventLock must be held
@@ -99,71 +365,167 @@ struct ReactorLock {
 };
 
 class Reactor {
-  using TimersType = std::map<std::pair<TimePoint, size_t>, std::coroutine_handle<>>;
+#ifdef ASYNC_TIMER_MAP
+  using TimersType = TimerMap;
+#else
+  using TimersType = TimerWheel;
+#endif
 
 public:
-  Reactor() : mPoller(), mTicker(0), mSources(), mEvents(), mTimers(), mTimerOps() {}
+  // `maxEvents` bounds the readiness events taken from one poller wait
+  explicit Reactor(size_t maxEvents = impl::Events::MAX_EVENTS)
+      : mPoller(maxEvents), mTicker(0), mSources(), mEvents(), mTimers(), mTimerOps()
+  {
+    // completion poller is optional, kernels without io_uring keep readiness based io only
+    if (auto r = UringPoller::Create(); r) {
+      if (mPoller.add(r.value()->fd(), Event::Readable(URING_KEY), PollMode::Level)) {
+        mUring = std::move(r.value());
+      }
+    }
+  }
   ~Reactor() {}
+  // reactor the calling thread's timers and io go to, executors install it on the threads they run coroutines on
+  static auto Current() -> Reactor* { return tCurrent; }
+  // returns the previous one
+  static auto SetCurrent(Reactor* reactor) -> Reactor* { return std::exchange(tCurrent, reactor); }
   auto ticker() -> size_t { return mTicker.load(); }
-  auto insertIo(int fd) -> StdResult<std::shared_ptr<Source>>
-  {
-    auto sourceLk = std::unique_lock {mSourceLock};
-    auto source = std::make_shared<Source>(fd, 0);
-    auto key = mSources.insert(source);
-    source->key = key;
-    sourceLk.unlock();
-
-    if (auto r = mPoller.add(fd, Event::None(key)); !r) {
-      auto lk = std::unique_lock {mSourceLock};
-      auto e = mSources.tryRemove(key);
-      assert(e);
+  // `PollMode::Edge` registers both directions once and never touches the poller again until `removeIo`,
+  // `PollMode::Oneshot` re-arms through `updateIo` on every wait. The source stays valid until `removeIo`.
+  auto insertIo(int fd, PollMode mode = PollMode::Edge) -> StdResult<Source*>
+  {
+    assert((mode == PollMode::Edge || mode == PollMode::Oneshot) && "sources are edge triggered or oneshot");
+    auto source = mSources.insert(fd, mode);
+    if (source == nullptr) {
+      return make_unexpected(std::errc::too_many_files_open);
+    }
+    auto event = mode == PollMode::Edge ? Event::All(source->key) : Event::None(source->key);
+    if (auto r = mPoller.add(fd, event, mode); !r) {
+      mSources.remove(*source);
       return make_unexpected(r.error());
     }
     return source;
   }
-  auto removeIo(Source const& source) -> StdResult<void>
+  auto removeIo(Source& source) -> StdResult<void>
   {
-    auto lk = std::unique_lock {mSourceLock};
-    auto e = mSources.tryRemove(source.key);
-    assert(e && "remove invalid key");
-    return mPoller.del(source.fd);
+    auto r = mPoller.del(source.fd);
+    mSources.remove(source);
+    return r;
   }
+  // re-arm a oneshot source with its current interest, nothing to do for an edge triggered one
   auto updateIo(Source const& source) -> StdResult<void>
   {
-    auto lk = std::unique_lock {mSourceLock};
-    auto e = mSources.get(source.key);
-    assert(e);
-    auto event = e->get()->getEvent();
-    return mPoller.mod(source.fd, event);
+    if (source.isEdge()) {
+      return {};
+    }
+    return mPoller.mod(source.fd, source.getEvent());
   }
-  [[nodiscard]] auto sleep(TimePoint::duration duration)
+  auto supportCompletion() const -> bool { return mUring != nullptr; }
+  // submit `prep` to the completion poller, `op` is completed and resumed from `react`
+  template <typename PrepFn>
+  auto submitOp(PrepFn&& prep, CompletionOp& op) -> StdResult<void>
   {
-    struct SleepAwaiter : public std::suspend_always {
-      SleepAwaiter(async::Reactor* reactor, TimePoint when) : reactor(reactor), when(when) {}
-      Reactor* reactor;
-      TimePoint when;
-      size_t id = std::numeric_limits<size_t>::max();
-      auto await_suspend(std::coroutine_handle<> handle) -> void { id = reactor->insertTimer(when, handle); }
+    return submit(prep, reinterpret_cast<uint64_t>(&op));
+  }
+  // like `submitOp` for an operation nobody waits for, its completion is dropped
+  template <typename PrepFn>
+  auto submitDetached(PrepFn&& prep) -> StdResult<void>
+  {
+    return submit(prep, DETACHED);
+  }
+  [[nodiscard]] auto read(int fd, std::span<std::byte> buf, uint64_t offset = impl::Uring::CURRENT_POSITION)
+  {
+    auto prep = [=](impl::Uring& ring, uint64_t data) { return ring.read(fd, buf, offset, data); };
+    return CompletionAwaiter<size_t, decltype(prep)> {this, prep};
+  }
+  [[nodiscard]] auto write(int fd, std::span<std::byte const> buf, uint64_t offset = impl::Uring::CURRENT_POSITION)
+  {
+    auto prep = [=](impl::Uring& ring, uint64_t data) { return ring.write(fd, buf, offset, data); };
+    return CompletionAwaiter<size_t, decltype(prep)> {this, prep};
+  }
+  [[nodiscard]] auto accept(int fd, sockaddr* addr = nullptr, socklen_t* len = nullptr)
+  {
+    auto prep = [=](impl::Uring& ring, uint64_t data) {
+      return ring.accept(fd, addr, len, SOCK_NONBLOCK | SOCK_CLOEXEC, data);
     };
+    return CompletionAwaiter<int, decltype(prep)> {this, prep};
+  }
+  [[nodiscard]] auto connect(int fd, sockaddr const* addr, socklen_t len)
+  {
+    auto prep = [=](impl::Uring& ring, uint64_t data) { return ring.connect(fd, addr, len, data); };
+    return CompletionAwaiter<void, decltype(prep)> {this, prep};
+  }
+  // the kernel picks the buffer from `group` once data arrives, so a pending recv holds no memory; the result is
+  // the byte count and the flags carry the buffer id, see `BufferPool`
+  [[nodiscard]] auto recv(int fd, uint16_t group, int flags = 0)
+  {
+    auto prep = [=](impl::Uring& ring, uint64_t data) { return ring.recv(fd, group, flags, data); };
+    return CompletionAwaiter<CompletionOp, decltype(prep)> {this, prep};
+  }
+  // hand `count` buffers of `len` bytes from `addr` on to the kernel as buffer group `group`, ids from `bid` on
+  [[nodiscard]] auto provideBuffers(std::byte* addr, uint32_t len, uint32_t count, uint16_t group, uint16_t bid)
+  {
+    auto prep = [=](impl::Uring& ring, uint64_t data) {
+      return ring.provideBuffers(addr, len, count, group, bid, data);
+    };
+    return CompletionAwaiter<void, decltype(prep)> {this, prep};
+  }
+  // a buffer group id not used on this reactor yet
+  auto newBufferGroup() -> uint16_t { return mNextGroup.fetch_add(1, std::memory_order_relaxed); }
+  [[nodiscard]] auto sleep(TimePoint::duration duration) -> SleepAwaiter
+  {
     return SleepAwaiter {this, TimePoint::clock::now() + duration};
   }
-  auto insertTimer(TimePoint when, std::coroutine_handle<> handle) -> size_t
+  static auto NewTimerId() -> size_t
   {
     static auto ID_GENERATOR = std::atomic_size_t {0};
-    auto id = ID_GENERATOR.fetch_add(1, std::memory_order_acquire);
+    return ID_GENERATOR.fetch_add(1, std::memory_order_relaxed);
+  }
+  auto insertTimer(TimePoint when, std::coroutine_handle<> handle) -> size_t
+  {
+    auto id = NewTimerId();
+    insertTimer(when, id, handle);
+    return id;
+  }
+  auto insertTimer(TimePoint when, size_t id, std::coroutine_handle<> handle) -> void
+  {
     {
       auto lk = std::scoped_lock(mTimerOpLock);
-      mTimerOps.push(TimerOp {TimerOp::Insert {id, when, handle}});
+      mTimerOps.push(TimerOp {id, when, handle});
     }
+    Metrics::count(Counter::TimersInserted);
     notify();
-    return id;
   }
-  auto removeTimer(TimePoint when, size_t id) -> void
+  // false, without inserting, when stop was already requested; checked under the same lock `removeTimer` drains
+  auto insertTimer(TimePoint when, size_t id, std::coroutine_handle<> handle, std::stop_token const& stop) -> bool
   {
     {
       auto lk = std::scoped_lock(mTimerOpLock);
-      mTimerOps.push(TimerOp {TimerOp::Remove {id, when}});
+      if (stop.stop_requested()) {
+        return false;
+      }
+      mTimerOps.push(TimerOp {id, when, handle});
+    }
+    Metrics::count(Counter::TimersInserted);
+    notify();
+    return true;
+  }
+  // cancel a pending timer, returns its handle when it has not fired yet, otherwise null
+  auto removeTimer(TimePoint when, size_t id) -> std::coroutine_handle<>
+  {
+    auto lk = std::scoped_lock {mTimerLock};
+    processTimeOps(mTimers);
+    auto handle = mTimers.remove(when, id);
+    if (handle) {
+      Metrics::count(Counter::TimersCancelled);
     }
+    return handle;
+  }
+  // timers inserted and neither fired nor removed yet
+  auto pendingTimers() -> size_t
+  {
+    auto lk = std::scoped_lock {mTimerLock};
+    processTimeOps(mTimers);
+    return mTimers.size();
   }
   auto notify() -> void
   {
@@ -176,62 +538,61 @@ public:
     using namespace std::chrono_literals;
     auto lk = std::unique_lock {mTimerLock};
     processTimeOps(mTimers);
-    auto pending = std::vector<std::pair<TimePoint, size_t>> {};
-    auto ready = std::vector<std::coroutine_handle<>> {};
-    auto now = TimePoint::clock::now() + 1ns;
-    // TODO: split timers into ready and pending
-    for (auto const& entry : mTimers) {
-      if (entry.first.first <= now) {
-        ready.push_back(entry.second);
-        mTimers.erase(entry.first);
-      } else {
-        pending.push_back(entry.first);
-      }
+    auto now = TimePoint::clock::now();
+    auto ready = mTimers.popExpired(now, handles);
+    auto next = mTimers.nextDeadline();
+    lk.unlock();
+    Metrics::count(Counter::TimersFired, ready);
+
+    if (ready != 0) {
+      return 0ns;
+    } else if (next) {
+      return next.value() <= now ? 0ns : next.value() - now;
     }
+    return std::nullopt;
+  }
 
-    auto duration = std::optional<TimePoint::duration> {std::nullopt};
-    if (ready.empty()) {
-      auto it = std::min_element(pending.begin(), pending.end(),
-                                 [](auto const& a, auto const& b) { return a.first < b.first; });
-      if (it != pending.end()) {
-        duration = (it->first - now).count() < 0 ? 0ns : it->first - now;
-      }
-    } else {
-      duration = 0ns;
+  auto processTimeOps(TimersType& mTimers) -> void
+  {
+    auto ops = std::queue<TimerOp> {};
+    {
+      auto lk = std::scoped_lock(mTimerOpLock);
+      std::swap(ops, mTimerOps);
     }
-    lk.unlock();
-    for (auto const handle : ready) {
-      handles.push_back(handle);
+    for (; !ops.empty(); ops.pop()) {
+      auto const& op = ops.front();
+      mTimers.insert(op.when, op.key, op.handle);
     }
-    return duration;
   }
 
-  auto processTimeOps(TimersType& mTimers) -> void
+  // submit every operation queued since last turn with one syscall
+  auto flushCompletions() -> void
   {
-    while (true) {
-      auto value = std::optional<TimerOp>(std::nullopt);
-      {
-        auto lk = std::scoped_lock(mTimerOpLock);
-        if (mTimerOps.empty()) {
-          break;
-        }
-        value = std::move(mTimerOps.front());
-        mTimerOps.pop();
+    if (mUring != nullptr) {
+      if (auto r = mUring->flush(); !r) {
+        assert("uring submit failed" && (r.error() == std::errc::resource_unavailable_try_again ||
+                                         r.error() == std::errc::device_or_resource_busy ||
+                                         r.error() == std::errc::interrupted));
       }
-      if (value) {
-        auto fn = overloaded {
-            [&](TimerOp::Insert const& op) {
-              mTimers.insert({{op.when, op.key}, op.handle});
-            },
-            [&](TimerOp::Remove const& op) {
-              mTimers.erase({op.when, op.key});
-            },
-        };
-        std::visit(fn, value.value().op);
-      } else {
-        break;
+    }
+  }
+  auto reapCompletions(std::vector<std::coroutine_handle<>>& handles) -> void
+  {
+    if (mUring == nullptr) {
+      return;
+    }
+    mCompletions.clear();
+    mUring->reap(mCompletions);
+    for (auto const& c : mCompletions) {
+      if (c.userData == DETACHED) {
+        continue;
       }
+      auto op = reinterpret_cast<CompletionOp*>(c.userData);
+      op->result = c.result;
+      op->flags = c.flags;
+      handles.push_back(op->handle);
     }
+    Metrics::count(Counter::Completions, mCompletions.size());
   }
 
   auto lock() -> ReactorLock
@@ -265,20 +626,21 @@ public:
       waitTimeout.emplace(nextTimer.value());
     }
     mEvents.clear();
-    if (auto r = mPoller.wait(mEvents, waitTimeout); r) {
+    flushCompletions();
+    auto r = mPoller.wait(mEvents, waitTimeout);
+    reapCompletions(handles);
+    if (r) {
       if (r.value() == 0) {
-        if (*waitTimeout != 0s) {
+        if (waitTimeout && *waitTimeout != 0s) {
           processTimers(handles);
         }
       } else {
-        auto lk = std::unique_lock {mSourceLock};
         for (auto const& ev : mEvents) {
-          if (auto ptr = mSources.get(ev.key); ptr) {
-            if (ev.readable) {
-              handles.push_back(ptr->get()->takeReadable());
-            } else if (ev.writable) {
-              handles.push_back(ptr->get()->takeWritable());
-            }
+          if (ev.key == URING_KEY) {
+            continue;
+          }
+          if (auto source = mSources.find(ev.key)) {
+            source->wake(ev.readable, ev.writable, handles);
           }
         }
       }
@@ -301,11 +663,30 @@ public:
   friend struct ReactorLock;
 
 private:
+  static constexpr uint64_t DETACHED = 0; // user data of completions nobody waits for, never an op's address
+
+  template <typename PrepFn>
+  auto submit(PrepFn& prep, uint64_t userData) -> StdResult<void>
+  {
+    if (mUring == nullptr) {
+      return make_unexpected(std::errc::function_not_supported);
+    }
+    auto r = mUring->submit([&](impl::Uring& ring) { return prep(ring, userData); });
+    if (!r) {
+      return make_unexpected(r.error());
+    }
+    if (r.value()) { // first operation of this batch, wake the reactor to submit it
+      notify();
+    }
+    return {};
+  }
+
+  static inline thread_local Reactor* tCurrent = nullptr;
+
   async::Poller mPoller;
   std::atomic_size_t mTicker;
 
-  std::mutex mSourceLock;
-  Slab<std::shared_ptr<Source>> mSources;
+  SourceRegistry mSources;
 
   std::mutex mEventLock;
   std::vector<Event> mEvents;
@@ -315,8 +696,53 @@ private:
 
   std::mutex mTimerOpLock;
   std::queue<TimerOp> mTimerOps;
+
+  std::unique_ptr<UringPoller> mUring;
+  std::vector<UringPoller::Completion> mCompletions;
+  std::atomic<uint16_t> mNextGroup {0}; // provided buffer groups
 };
 
+template <typename ResultTy, typename PrepFn>
+inline auto CompletionAwaiter<ResultTy, PrepFn>::await_suspend(std::coroutine_handle<> handle) -> bool
+{
+  op.handle = handle;
+  if (auto r = reactor->submitOp(prep, op); !r) {
+    op.result = -static_cast<int32_t>(r.error());
+    return false;
+  }
+  return true;
+}
+
+inline SleepAwaiter::SleepAwaiter(Reactor* reactor, TimePoint when)
+    : reactor(reactor), when(when), id(Reactor::NewTimerId())
+{
+}
+inline auto SleepAwaiter::Canceller::operator()() noexcept -> void
+{
+  if (auto handle = self->reactor->removeTimer(self->when, self->id)) {
+    self->cancelled = true;
+    self->executor.execute(handle);
+  }
+}
+// the timer may fire on another thread before `insertTimer` returns, id must be known in advance
+template <typename P>
+inline auto SleepAwaiter::await_suspend(std::coroutine_handle<P> handle) -> bool
+{
+  auto stop = StopTokenOf(handle);
+  if (stop == nullptr || !stop->stop_possible()) {
+    reactor->insertTimer(when, id, handle);
+    return true;
+  }
+  // registered first: a stop racing with the insertion either removes the timer or prevents it
+  executor = ExecutorRef::Current();
+  onStop.emplace(*stop, Canceller {this});
+  if (!reactor->insertTimer(when, id, handle, *stop)) {
+    cancelled = true;
+    return false;
+  }
+  return true;
+}
+
 template <typename ExecutorType>
 inline auto ReactorLock::react(std::optional<TimePoint::duration> timeout, ExecutorType& e) -> StdResult<void>
 {
@@ -333,20 +759,21 @@ inline auto ReactorLock::react(std::optional<TimePoint::duration> timeout, Execu
     waitTimeout.emplace(nextTimer.value());
   }
   reactor.mEvents.clear();
-  if (auto r = reactor.mPoller.wait(reactor.mEvents, waitTimeout); r) {
+  reactor.flushCompletions();
+  auto r = reactor.mPoller.wait(reactor.mEvents, waitTimeout);
+  reactor.reapCompletions(handles);
+  if (r) {
     if (r.value() == 0) {
-      if (*waitTimeout != 0s) {
+      if (waitTimeout && *waitTimeout != 0s) {
         reactor.processTimers(handles);
       }
     } else {
-      auto lk = std::unique_lock {reactor.mSourceLock};
       for (auto const& ev : reactor.mEvents) {
-        if (auto ptr = reactor.mSources.get(ev.key); ptr) {
-          if (ev.readable) {
-            handles.push_back(ptr->get()->takeReadable());
-          } else if (ev.writable) {
-            handles.push_back(ptr->get()->takeWritable());
-          }
+        if (ev.key == URING_KEY) {
+          continue;
+        }
+        if (auto source = reactor.mSources.find(ev.key)) {
+          source->wake(ev.readable, ev.writable, handles);
         }
       }
     }
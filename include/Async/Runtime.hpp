@@ -1,6 +1,8 @@
 #pragma once
 #include "Async/Executor.hpp"
+#include "Async/Select.hpp"
 #include "Async/Task.hpp"
+#include "Async/ThreadPool.hpp"
 #include "Async/concepts.hpp"
 #include <cassert>
 #include <coroutine>
@@ -10,49 +12,152 @@ namespace async {
 class Reactor;
 template <typename T = void>
 struct JoinHandle;
+// A reactor and an executor. Any number of them may live in one process, e.g. one for latency critical work and one
+// for batch jobs; each executor installs its reactor and itself as the current ones on its threads, so `sleep`, IO
+// and the primitives used from a coroutine stay on the runtime that runs it.
+template <ExecutorCpt ExecutorTy>
+class RuntimeInstance {
+public:
+  template <typename... Args>
+  explicit RuntimeInstance(Args&&... args) : mReactor(std::make_unique<Reactor>())
+  {
+    if constexpr (std::is_constructible_v<ExecutorTy, Reactor&, Args&&...>) {
+      mExecutor = std::make_unique<ExecutorTy>(*mReactor, std::forward<Args>(args)...);
+    } else {
+      mExecutor = std::make_unique<ExecutorTy>(std::forward<Args>(args)...);
+    }
+  }
+  RuntimeInstance(RuntimeInstance const&) = delete;
+  RuntimeInstance& operator=(RuntimeInstance const&) = delete;
+
+  // reactor of the calling thread when it runs coroutines, the main reactor otherwise
+  auto reactor() -> Reactor&
+  {
+    if (auto local = Reactor::Current(); local != nullptr) {
+      return *local;
+    }
+    return *mReactor;
+  }
+  // reactor driven by the thread inside `block`
+  auto mainReactor() -> Reactor& { return *mReactor; }
+  auto executor() -> ExecutorTy& { return *mExecutor; }
+
+  auto spawnDetach(Task<> task) -> void { mExecutor->spawnDetach(std::move(task)); }
+  // executors without lanes ignore the priority
+  auto spawnDetach(Task<> task, Priority priority) -> void
+  {
+    if constexpr (requires { mExecutor->spawnDetach(std::move(task), priority); }) {
+      mExecutor->spawnDetach(std::move(task), priority);
+    } else {
+      mExecutor->spawnDetach(std::move(task));
+    }
+  }
+  template <typename Fn, typename... Args>
+  [[nodiscard]] auto blockSpawn(Fn&& fn, Args&&... args)
+  {
+    return mExecutor->blockSpawn(std::forward<Fn>(fn), std::forward<Args>(args)...);
+  }
+  template <typename T>
+  auto block(Task<T> task) -> T
+  {
+    return mExecutor->block(std::move(task));
+  }
+  [[nodiscard]] auto sleep(TimePoint::duration duration) { return reactor().sleep(duration); }
+  template <typename T>
+  [[nodiscard]] auto timeout(TimePoint::duration duration, Task<T> task)
+  {
+    return async::timeout(reactor(), duration, std::move(task));
+  }
+  template <typename T>
+  auto spawn(JoinHandle<T>& handle) -> void
+  {
+    mExecutor->spawn(handle);
+  }
+  template <typename T>
+  auto spawn(JoinHandle<T>& handle, Priority priority) -> void
+  {
+    if constexpr (requires { mExecutor->spawn(handle, priority); }) {
+      mExecutor->spawn(handle, priority);
+    } else {
+      mExecutor->spawn(handle);
+    }
+  }
+
+private:
+  std::unique_ptr<Reactor> mReactor;     // outlives the executor's threads
+  std::unique_ptr<ExecutorTy> mExecutor;
+};
+
+// reactor of the runtime running the calling coroutine
+inline auto CurrentReactor() -> Reactor&
+{
+  auto reactor = Reactor::Current();
+  assert(reactor != nullptr && "not called from a runtime thread");
+  return *reactor;
+}
+// sleeps on the runtime running the calling coroutine
+[[nodiscard]] inline auto sleep(TimePoint::duration duration) { return CurrentReactor().sleep(duration); }
+template <typename T>
+[[nodiscard]] auto timeout(TimePoint::duration duration, Task<T> task)
+{
+  return timeout(CurrentReactor(), duration, std::move(task));
+}
+
+// process wide `RuntimeInstance` per executor type
 template <ExecutorCpt ExecutorTy>
 struct Runtime {
   template <typename... Args>
   static inline auto Init(Args&&... args) -> bool
   {
     std::call_once(onceFlag, [&]() {
-      reactor = std::make_unique<Reactor>();
-      executor = std::make_unique<ExecutorTy>(std::forward<Args>(args)...);
+      instance = std::make_unique<RuntimeInstance<ExecutorTy>>(std::forward<Args>(args)...);
       isInit.store(true);
     });
     return true;
   }
-  static inline auto GetReactor() -> Reactor&
+  static inline auto GetInstance() -> RuntimeInstance<ExecutorTy>&
   {
     if (!isInit.load()) {
       assert(false && "Runtime is not initialized or initialization failed");
     }
-    return *reactor;
+    return *instance;
   }
-  static inline auto GetExecutor() -> ExecutorTy&
+  // reactor of the calling worker when running one reactor per worker, the main reactor otherwise
+  static inline auto GetReactor() -> Reactor& { return GetInstance().reactor(); }
+  // reactor driven by the thread inside `Block`
+  static inline auto GetMainReactor() -> Reactor& { return GetInstance().mainReactor(); }
+  static inline auto GetExecutor() -> ExecutorTy& { return GetInstance().executor(); }
+
+  static inline auto SpawnDetach(Task<> task) -> void { GetInstance().spawnDetach(std::move(task)); }
+  static inline auto SpawnDetach(Task<> task, Priority priority) -> void
   {
-    if (!isInit.load()) {
-      assert(false && "Runtime is not initialized or initialization failed");
-    }
-    return *executor;
+    GetInstance().spawnDetach(std::move(task), priority);
   }
-
-  static inline auto SpawnDetach(Task<> task) -> void { GetExecutor().spawnDetach(std::move(task)); }
   template <typename Fn, typename ...Args>
   [[nodiscard]] static inline auto BlockSpawn(Fn&& fn, Args&&... args)
   {
-    return GetExecutor().blockSpawn(std::forward<Fn>(fn), std::forward<Args>(args)...);
+    return GetInstance().blockSpawn(std::forward<Fn>(fn), std::forward<Args>(args)...);
   }
   template <typename T>
   static inline auto Block(Task<T> task) -> T
   {
-    return GetExecutor().block(std::move(task));
+    return GetInstance().block(std::move(task));
+  }
+  [[nodiscard]] static inline auto Sleep(TimePoint::duration duration) { return GetInstance().sleep(duration); }
+  template <typename T>
+  [[nodiscard]] static inline auto Timeout(TimePoint::duration duration, Task<T> task)
+  {
+    return GetInstance().timeout(duration, std::move(task));
   }
-  [[nodiscard]] static inline auto Sleep(TimePoint::duration duration) { return GetReactor().sleep(duration); }
   template <typename T>
   static auto Spawn(JoinHandle<T>& handle) -> void
   {
-    return GetExecutor().spawn(handle);
+    return GetInstance().spawn(handle);
+  }
+  template <typename T>
+  static auto Spawn(JoinHandle<T>& handle, Priority priority) -> void
+  {
+    return GetInstance().spawn(handle, priority);
   }
   template <typename... JoinHandleTy>
   [[nodiscard]] static auto WaitAll(JoinHandleTy&&... handles) -> Task<>
@@ -63,7 +168,6 @@ struct Runtime {
 private:
   static inline std::atomic_bool isInit = false;
   static inline std::once_flag onceFlag;
-  static inline std::unique_ptr<Reactor> reactor = nullptr;
-  static inline std::unique_ptr<ExecutorTy> executor = nullptr;
+  static inline std::unique_ptr<RuntimeInstance<ExecutorTy>> instance = nullptr;
 };
-} // namespace async
\ No newline at end of file
+} // namespace async
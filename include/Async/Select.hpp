@@ -0,0 +1,475 @@
+#pragma once
+#include "Async/ExecutorRef.hpp"
+#include "Async/Reactor.hpp"
+#include "Async/Task.hpp"
+#include <array>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <limits>
+#include <stop_token>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+namespace async {
+namespace detail {
+template <typename T>
+struct ResultOf {
+  using type = T;
+};
+template <>
+struct ResultOf<void> {
+  using type = std::monostate;
+};
+template <typename T>
+using ResultOfT = typename ResultOf<T>::type;
+
+// Stop source of one branch of a combinator, so the branch can be stopped on its own once it lost. The token the
+// branch would have had, its own or else the parent's, stays chained to it.
+struct BranchStop {
+  struct Request {
+    std::stop_source* source;
+    auto operator()() noexcept -> void { source->request_stop(); }
+  };
+  std::stop_source source;
+  std::optional<std::stop_callback<Request>> upstream;
+
+  template <typename P>
+  auto attach(PromiseBase& child, std::coroutine_handle<P> parent) -> void
+  {
+    InheritStop(child, parent);
+    if (child.stopToken.stop_possible()) {
+      upstream.emplace(child.stopToken, Request {&source});
+    }
+    child.stopToken = source.get_token();
+  }
+  auto stop() noexcept -> void { source.request_stop(); }
+};
+
+template <typename T>
+struct TimeoutState {
+  Task<T> task;
+  Reactor* reactor;
+  TimePoint when;
+  size_t timerId = Reactor::NewTimerId();
+  std::atomic_size_t refs = 1; // the awaiter, and the task once started
+  std::atomic_bool done = false;
+  BranchStop branch;
+
+  auto release() -> void
+  {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+  static auto OnComplete(void* ctx, std::coroutine_handle<>) noexcept -> std::coroutine_handle<>
+  {
+    auto state = static_cast<TimeoutState*>(ctx);
+    state->done.store(true, std::memory_order_release);
+    // got the timer back before it fired: nobody else will resume the parent
+    auto parent = state->reactor->removeTimer(state->when, state->timerId);
+    state->release(); // may destroy this very frame
+    return parent;
+  }
+};
+
+template <typename... Ts>
+struct SelectState {
+  static constexpr auto NONE = sizeof...(Ts);
+  std::tuple<Task<Ts>...> tasks;
+  std::atomic_size_t refs = 1; // the awaiter, and every started task
+  std::atomic_size_t winner = NONE;
+  std::atomic_bool armed = false; // set by whichever comes second of await_suspend and the winner
+  std::coroutine_handle<> parent = nullptr;
+  std::array<BranchStop, sizeof...(Ts)> branches;
+
+  auto release() -> void
+  {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this; // the losers' results go with their frames
+    }
+  }
+  template <size_t I>
+  static auto OnComplete(void* ctx, std::coroutine_handle<>) noexcept -> std::coroutine_handle<>
+  {
+    auto state = static_cast<SelectState*>(ctx);
+    auto next = std::coroutine_handle<> {};
+    auto expected = NONE;
+    if (state->winner.compare_exchange_strong(expected, I, std::memory_order_acq_rel)) {
+      for (size_t i = 0; i < NONE; ++i) {
+        if (i != I) {
+          state->branches[i].stop();
+        }
+      }
+      if (state->armed.exchange(true, std::memory_order_acq_rel)) {
+        next = state->parent;
+      }
+    }
+    state->release(); // may destroy this very frame, `next` is a copy
+    return next;
+  }
+};
+
+// drops the awaiter's reference once it resumed
+template <typename State>
+struct ReleaseGuard {
+  State* state;
+  ~ReleaseGuard() { state->release(); }
+};
+
+template <typename T>
+auto TakeResult(Task<T>& task) -> ResultOfT<T>
+{
+  if constexpr (std::is_void_v<T>) {
+    task.promise().result();
+    return {};
+  } else {
+    return std::move(task).promise().result();
+  }
+}
+} // namespace detail
+
+// The task's frame is owned by the state, which the awaiter and the started task each hold a reference to. An
+// awaiter dropped without being awaited destroys the task that never started.
+template <typename T>
+struct TimeoutAwaiter {
+  using State = detail::TimeoutState<T>;
+  State* state;
+  bool awaited = false;
+
+  explicit TimeoutAwaiter(State* state) : state(state) {}
+  TimeoutAwaiter(TimeoutAwaiter const&) = delete;
+  TimeoutAwaiter(TimeoutAwaiter&& other) noexcept : state(std::exchange(other.state, nullptr)), awaited(other.awaited) {}
+  TimeoutAwaiter& operator=(TimeoutAwaiter const&) = delete;
+  TimeoutAwaiter& operator=(TimeoutAwaiter&&) = delete;
+  ~TimeoutAwaiter()
+  {
+    if (state != nullptr) {
+      if (!awaited) {
+        state->task.destroy(); // never started
+      }
+      state->release();
+    }
+  }
+
+  auto await_ready() const noexcept -> bool { return false; }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> parent) -> std::coroutine_handle<>
+  {
+    awaited = true;
+    auto local = state;
+    local->refs.fetch_add(1, std::memory_order_relaxed);
+    local->task.promise().setCompletion(&State::OnComplete, local);
+    local->branch.attach(local->task.promise(), parent);
+    // the timer may resume `parent` before this returns, don't touch `this` afterwards
+    local->reactor->insertTimer(local->when, local->timerId, parent);
+    return local->task.handle();
+  }
+  auto await_resume() -> StdResult<T>
+  {
+    auto guard = detail::ReleaseGuard<State> {std::exchange(state, nullptr)};
+    if (!guard.state->done.load(std::memory_order_acquire)) {
+      // the timer fired, the task unwinds on its own
+      guard.state->branch.stop();
+      return make_unexpected(std::errc::timed_out);
+    }
+    if constexpr (std::is_void_v<T>) {
+      guard.state->task.promise().result();
+      return {};
+    } else {
+      return std::move(guard.state->task).promise().result();
+    }
+  }
+};
+
+// Race `task` against a deadline. When the task finishes first its timer is removed right away, otherwise the
+// awaiting coroutine resumes with `timed_out` and the task is stopped: its sleeps, readiness waits and locks resume
+// with `operation_canceled` and it finishes detached.
+template <typename T>
+[[nodiscard]] auto timeout(Reactor& reactor, TimePoint::duration duration, Task<T> task) -> TimeoutAwaiter<T>
+{
+  auto when = TimePoint::clock::now() + duration;
+  return TimeoutAwaiter<T> {new detail::TimeoutState<T> {std::move(task), &reactor, when}};
+}
+
+// owns its state like `TimeoutAwaiter`
+template <typename... Ts>
+struct SelectAwaiter {
+  using State = detail::SelectState<Ts...>;
+  State* state;
+  bool awaited = false;
+
+  explicit SelectAwaiter(State* state) : state(state) {}
+  SelectAwaiter(SelectAwaiter const&) = delete;
+  SelectAwaiter(SelectAwaiter&& other) noexcept : state(std::exchange(other.state, nullptr)), awaited(other.awaited) {}
+  SelectAwaiter& operator=(SelectAwaiter const&) = delete;
+  SelectAwaiter& operator=(SelectAwaiter&&) = delete;
+  ~SelectAwaiter()
+  {
+    if (state != nullptr) {
+      if (!awaited) {
+        std::apply([](auto&... task) { (..., task.destroy()); }, state->tasks); // never started
+      }
+      state->release();
+    }
+  }
+
+  auto await_ready() const noexcept -> bool { return false; }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> parent) -> bool
+  {
+    awaited = true;
+    auto local = state;
+    local->parent = parent;
+    local->refs.fetch_add(sizeof...(Ts), std::memory_order_relaxed);
+    [&]<size_t... Is>(std::index_sequence<Is...>) {
+      (..., std::get<Is>(local->tasks).promise().setCompletion(&State::template OnComplete<Is>, local));
+      (..., local->branches[Is].attach(std::get<Is>(local->tasks).promise(), parent));
+      (..., std::get<Is>(local->tasks).handle().resume());
+    }(std::index_sequence_for<Ts...> {});
+    // false: a branch already won while starting the others
+    return !local->armed.exchange(true, std::memory_order_acq_rel);
+  }
+  auto await_resume() -> std::variant<detail::ResultOfT<Ts>...>
+  {
+    auto guard = detail::ReleaseGuard<State> {std::exchange(state, nullptr)};
+    auto index = guard.state->winner.load(std::memory_order_acquire);
+    auto value = std::optional<std::variant<detail::ResultOfT<Ts>...>> {};
+    [&]<size_t... Is>(std::index_sequence<Is...>) {
+      (..., [&] {
+        if (Is == index) {
+          value.emplace(std::in_place_index<Is>, detail::TakeResult(std::get<Is>(guard.state->tasks)));
+        }
+      }());
+    }(std::index_sequence_for<Ts...> {});
+    return std::move(value).value();
+  }
+};
+
+// Run every task and resume with the result of the first one to finish, `index()` tells which one. The winner
+// stops the losing branches like `timeout` does, they finish detached and their results are dropped.
+template <typename... Ts>
+[[nodiscard]] auto select(Task<Ts>... tasks) -> SelectAwaiter<Ts...>
+{
+  static_assert(sizeof...(Ts) > 0, "select needs at least one task");
+  return SelectAwaiter<Ts...> {new detail::SelectState<Ts...> {{std::move(tasks)...}}};
+}
+namespace detail {
+// children of a when_all keep their frames, the results are read straight from their promises
+struct WhenAllCounter {
+  std::atomic_size_t remaining;
+  std::coroutine_handle<> parent = nullptr;
+
+  static auto OnComplete(void* ctx, std::coroutine_handle<>) noexcept -> std::coroutine_handle<>
+  {
+    auto& counter = *static_cast<WhenAllCounter*>(ctx);
+    return counter.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 ? counter.parent : nullptr;
+  }
+};
+
+// queue all but the last child on the current executor and return the last one to run by symmetric transfer, the
+// parent can't be resumed before that one finished
+template <typename It>
+auto LaunchAll(It begin, It end, WhenAllCounter& counter) -> std::coroutine_handle<>
+{
+  auto executor = ExecutorRef::Current();
+  auto last = std::coroutine_handle<> {};
+  for (auto it = begin; it != end; ++it) {
+    it->promise().setCompletion(&WhenAllCounter::OnComplete, &counter);
+  }
+  for (auto it = begin; it != end; ++it) {
+    if (last) {
+      executor.execute(last);
+    }
+    last = it->handle();
+  }
+  return last;
+}
+
+template <typename T>
+struct WhenAnyState {
+  static constexpr auto NONE = std::numeric_limits<size_t>::max();
+  std::vector<Task<T>> tasks;
+  std::atomic_size_t refs = 1; // the awaiter, and every started task
+  std::atomic_size_t winner = NONE;
+  std::atomic_bool armed = false; // set by whichever comes second of await_suspend and the winner
+  std::coroutine_handle<> parent = nullptr;
+  std::unique_ptr<BranchStop[]> branches = std::make_unique<BranchStop[]>(tasks.size());
+
+  auto release() -> void
+  {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this; // every child is done, their frames go with `tasks`
+    }
+  }
+  static auto OnComplete(void* ctx, std::coroutine_handle<> self) noexcept -> std::coroutine_handle<>
+  {
+    auto state = static_cast<WhenAnyState*>(ctx);
+    auto next = std::coroutine_handle<> {};
+    if (state->winner.load(std::memory_order_relaxed) == NONE) {
+      auto index = size_t {0};
+      while (state->tasks[index].handle().address() != self.address()) {
+        ++index;
+      }
+      auto expected = NONE;
+      if (state->winner.compare_exchange_strong(expected, index, std::memory_order_acq_rel)) {
+        for (size_t i = 0; i < state->tasks.size(); ++i) {
+          if (i != index) {
+            state->branches[i].stop();
+          }
+        }
+        if (state->armed.exchange(true, std::memory_order_acq_rel)) {
+          next = state->parent;
+        }
+      }
+    }
+    state->release(); // may destroy this very frame, `next` is a copy
+    return next;
+  }
+};
+} // namespace detail
+
+template <typename... Ts>
+struct WhenAllAwaiter {
+  std::tuple<Task<Ts>...> tasks;
+  detail::WhenAllCounter counter {sizeof...(Ts)};
+
+  auto await_ready() const noexcept -> bool { return false; }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> parent) -> std::coroutine_handle<>
+  {
+    counter.parent = parent;
+    return std::apply(
+        [this, parent](auto&... task) {
+          (..., task.promise().setCompletion(&detail::WhenAllCounter::OnComplete, &counter));
+          (..., InheritStop(task.promise(), parent));
+          // same as LaunchAll: queue all but the last, run that one here
+          auto executor = ExecutorRef::Current();
+          auto last = std::coroutine_handle<> {};
+          (..., (last ? executor.execute(last) : void(), last = task.handle()));
+          return last;
+        },
+        tasks);
+  }
+  auto await_resume() -> std::tuple<detail::ResultOfT<Ts>...>
+  {
+    return std::apply([](auto&... task) { return std::tuple {detail::TakeResult(task)...}; }, tasks);
+  }
+};
+
+template <typename T>
+struct WhenAllRangeAwaiter {
+  std::vector<Task<T>> tasks;
+  detail::WhenAllCounter counter {tasks.size()};
+
+  auto await_ready() const noexcept -> bool { return tasks.empty(); }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> parent) -> std::coroutine_handle<>
+  {
+    counter.parent = parent;
+    for (auto& task : tasks) {
+      InheritStop(task.promise(), parent);
+    }
+    return detail::LaunchAll(tasks.begin(), tasks.end(), counter);
+  }
+  auto await_resume() -> std::conditional_t<std::is_void_v<T>, void, std::vector<T>>
+  {
+    if constexpr (std::is_void_v<T>) {
+      for (auto& task : tasks) {
+        task.promise().result();
+      }
+    } else {
+      auto results = std::vector<T> {};
+      results.reserve(tasks.size());
+      for (auto& task : tasks) {
+        results.push_back(std::move(task).promise().result());
+      }
+      return results;
+    }
+  }
+};
+
+// Run every task in parallel on the current executor and resume once, from the last one to finish, with all the
+// results in order. The first exception (by position) is rethrown after all of them finished.
+template <typename... Ts>
+[[nodiscard]] auto when_all(Task<Ts>... tasks) -> WhenAllAwaiter<Ts...>
+{
+  static_assert(sizeof...(Ts) > 0, "when_all needs at least one task");
+  return WhenAllAwaiter<Ts...> {{std::move(tasks)...}};
+}
+template <typename T>
+[[nodiscard]] auto when_all(std::vector<Task<T>> tasks) -> WhenAllRangeAwaiter<T>
+{
+  return WhenAllRangeAwaiter<T> {std::move(tasks)};
+}
+
+// owns its state like `TimeoutAwaiter`
+template <typename T>
+struct WhenAnyAwaiter {
+  using State = detail::WhenAnyState<T>;
+  State* state;
+  bool awaited = false;
+
+  explicit WhenAnyAwaiter(State* state) : state(state) {}
+  WhenAnyAwaiter(WhenAnyAwaiter const&) = delete;
+  WhenAnyAwaiter(WhenAnyAwaiter&& other) noexcept
+      : state(std::exchange(other.state, nullptr)), awaited(other.awaited)
+  {}
+  WhenAnyAwaiter& operator=(WhenAnyAwaiter const&) = delete;
+  WhenAnyAwaiter& operator=(WhenAnyAwaiter&&) = delete;
+  ~WhenAnyAwaiter()
+  {
+    if (state != nullptr) {
+      if (!awaited) {
+        for (auto& task : state->tasks) {
+          task.destroy(); // never started
+        }
+      }
+      state->release();
+    }
+  }
+
+  auto await_ready() const noexcept -> bool { return false; }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> parent) -> bool
+  {
+    awaited = true;
+    auto local = state;
+    local->parent = parent;
+    local->refs.fetch_add(local->tasks.size(), std::memory_order_relaxed);
+    auto executor = ExecutorRef::Current();
+    for (size_t i = 0; i < local->tasks.size(); ++i) {
+      local->tasks[i].promise().setCompletion(&State::OnComplete, local);
+      local->branches[i].attach(local->tasks[i].promise(), parent);
+    }
+    for (auto& task : local->tasks) {
+      executor.execute(task.handle());
+    }
+    // false: a child already won while the others were starting
+    return !local->armed.exchange(true, std::memory_order_acq_rel);
+  }
+  auto await_resume() -> std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, T>>
+  {
+    auto guard = detail::ReleaseGuard<State> {std::exchange(state, nullptr)};
+    auto index = guard.state->winner.load(std::memory_order_acquire);
+    if constexpr (std::is_void_v<T>) {
+      guard.state->tasks[index].promise().result();
+      return index;
+    } else {
+      return std::pair<size_t, T> {index, std::move(guard.state->tasks[index]).promise().result()};
+    }
+  }
+};
+
+// Run every task in parallel and resume with the index (and value) of the first one to finish. The others are stopped
+// like the losers of `select`, their frames are released by whoever finishes last. See `select` for tasks of
+// different types.
+template <typename T>
+[[nodiscard]] auto when_any(std::vector<Task<T>> tasks) -> WhenAnyAwaiter<T>
+{
+  assert(!tasks.empty() && "when_any needs at least one task");
+  return WhenAnyAwaiter<T> {new detail::WhenAnyState<T> {std::move(tasks)}};
+}
+} // namespace async
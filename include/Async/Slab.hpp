@@ -1,5 +1,10 @@
 #pragma once
 #include "utils/predefined.hpp"
+#include <array>
+#include <bit>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -150,4 +155,177 @@ private:
   std::vector<Entry<T>> mEntries;
   size_t mLen;
   size_t mNext;
-};
\ No newline at end of file
+};
+
+// Slab over fixed-size pages that never move: a value keeps its address for as long as it is in, and growing only
+// allocates another page. A vacant slot keeps the free list link in the value's own storage, occupancy is one bit per
+// slot in the page header, so a slot costs exactly `sizeof(T)` and iteration skips empty runs a word at a time.
+template <typename T, size_t PAGE_SIZE = 256>
+class ChunkedSlab {
+  static_assert(PAGE_SIZE >= 64 && std::has_single_bit(PAGE_SIZE), "PAGE_SIZE is a power of two, at least 64");
+  static constexpr auto PAGE_SHIFT = std::countr_zero(PAGE_SIZE);
+  static constexpr auto PAGE_MASK = PAGE_SIZE - 1;
+  static constexpr auto WORDS = PAGE_SIZE / 64;
+  static constexpr auto NONE = std::numeric_limits<size_t>::max();
+
+  union Slot {
+    Slot() noexcept {}
+    ~Slot() {}
+    T value;
+    size_t next;
+  };
+  struct Page {
+    std::array<uint64_t, WORDS> occupied {};
+    Slot slots[PAGE_SIZE];
+  };
+
+public:
+  ChunkedSlab() = default;
+  ChunkedSlab(ChunkedSlab const&) = delete;
+  ChunkedSlab(ChunkedSlab&& other) noexcept
+      : mPages(std::move(other.mPages)), mLen(std::exchange(other.mLen, 0)), mNext(std::exchange(other.mNext, NONE)),
+        mTop(std::exchange(other.mTop, 0))
+  {
+  }
+  ChunkedSlab& operator=(ChunkedSlab const&) = delete;
+  ChunkedSlab& operator=(ChunkedSlab&& other) noexcept
+  {
+    if (this != &other) {
+      clear();
+      mPages = std::move(other.mPages);
+      mLen = std::exchange(other.mLen, 0);
+      mNext = std::exchange(other.mNext, NONE);
+      mTop = std::exchange(other.mTop, 0);
+    }
+    return *this;
+  }
+  ~ChunkedSlab() { clear(); }
+
+  auto len() const { return mLen; }
+  auto isEmpty() const { return mLen == 0; }
+  auto capacity() const { return mPages.size() * PAGE_SIZE; }
+  // drops the values and the pages
+  auto clear() -> void
+  {
+    forEach<false>([](size_t, T& value) { std::destroy_at(std::addressof(value)); });
+    mPages.clear();
+    mLen = 0;
+    mNext = NONE;
+    mTop = 0;
+  }
+  auto reserve(size_t size) -> void
+  {
+    while (capacity() < size) {
+      mPages.push_back(std::make_unique<Page>());
+    }
+  }
+
+  auto get(size_t key) -> T*
+  {
+    auto page = key >> PAGE_SHIFT;
+    if (page >= mPages.size() || !IsOccupied(*mPages[page], key & PAGE_MASK)) {
+      return nullptr;
+    }
+    return std::addressof(mPages[page]->slots[key & PAGE_MASK].value);
+  }
+  auto get(size_t key) const -> T const* { return const_cast<ChunkedSlab*>(this)->get(key); }
+  auto contains(size_t key) const -> bool { return get(key) != nullptr; }
+  // unchecked, the key must be occupied
+  auto operator[](size_t key) -> T& { return slotAt(key).value; }
+  auto operator[](size_t key) const -> T const& { return const_cast<ChunkedSlab*>(this)->slotAt(key).value; }
+
+  template <typename... Args>
+  auto emplace(Args&&... args) -> size_t
+  {
+    auto fresh = mNext == NONE;
+    auto key = fresh ? mTop : mNext;
+    if ((key >> PAGE_SHIFT) == mPages.size()) {
+      mPages.push_back(std::make_unique<Page>());
+    }
+    auto& page = *mPages[key >> PAGE_SHIFT];
+    auto& slot = page.slots[key & PAGE_MASK];
+    auto next = fresh ? NONE : slot.next;
+    try {
+      std::construct_at(std::addressof(slot.value), std::forward<Args>(args)...);
+    } catch (...) {
+      if (!fresh) {
+        slot.next = next;
+      }
+      throw;
+    }
+    if (fresh) {
+      mTop += 1;
+    } else {
+      mNext = next;
+    }
+    page.occupied[(key & PAGE_MASK) / 64] |= uint64_t {1} << (key % 64);
+    mLen += 1;
+    return key;
+  }
+  auto insert(T&& data) -> size_t { return emplace(std::move(data)); }
+  auto insert(T const& data) -> size_t { return emplace(data); }
+  auto tryRemove(size_t key) -> std::optional<T>
+  {
+    auto page = key >> PAGE_SHIFT;
+    if (page >= mPages.size() || !IsOccupied(*mPages[page], key & PAGE_MASK)) {
+      return std::nullopt;
+    }
+    auto& slot = mPages[page]->slots[key & PAGE_MASK];
+    auto out = std::optional<T>(std::move(slot.value));
+    std::destroy_at(std::addressof(slot.value));
+    slot.next = mNext;
+    mPages[page]->occupied[(key & PAGE_MASK) / 64] &= ~(uint64_t {1} << (key % 64));
+    mNext = key;
+    mLen -= 1;
+    return out;
+  }
+
+  // visits the occupied slots in key order as `fn(key, value)`; with PREFETCH the next occupied slot and the next
+  // page are requested while the current one is handed out. `fn` may remove the key it is given.
+  template <bool PREFETCH = true, typename Fn>
+  auto forEach(Fn&& fn) -> void
+  {
+    for (size_t p = 0; p < mPages.size(); ++p) {
+      auto& page = *mPages[p];
+      if constexpr (PREFETCH) {
+        if (p + 1 < mPages.size()) {
+          Prefetch(mPages[p + 1].get());
+        }
+      }
+      for (size_t word = 0; word < WORDS; ++word) {
+        for (auto bits = page.occupied[word]; bits != 0;) {
+          auto index = word * 64 + std::countr_zero(bits);
+          bits &= bits - 1;
+          if constexpr (PREFETCH) {
+            if (bits != 0) {
+              Prefetch(std::addressof(page.slots[word * 64 + std::countr_zero(bits)]));
+            }
+          }
+          fn((p << PAGE_SHIFT) | index, page.slots[index].value);
+        }
+      }
+    }
+  }
+
+private:
+  auto slotAt(size_t key) -> Slot&
+  {
+    assert(contains(key));
+    return mPages[key >> PAGE_SHIFT]->slots[key & PAGE_MASK];
+  }
+  static auto IsOccupied(Page const& page, size_t index) -> bool
+  {
+    return (page.occupied[index / 64] >> (index % 64)) & 1;
+  }
+  static auto Prefetch(void const* address) -> void
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#endif
+  }
+
+  std::vector<std::unique_ptr<Page>> mPages;
+  size_t mLen = 0;
+  size_t mNext = NONE; // head of the vacant list
+  size_t mTop = 0;     // slots past this were never used
+};
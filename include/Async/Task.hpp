@@ -1,18 +1,30 @@
 #pragma once
+#include "Async/utils/FrameAllocator.hpp"
+#include "Async/utils/InlineFunction.hpp"
 #include <cassert>
 #include <coroutine>
+#include <cstdint>
 #include <cstdio>
 #include <exception>
-#include <functional>
+#include <stop_token>
+#include <type_traits>
 #include <utility>
 
 namespace async {
 template <typename T = void>
 class Task;
 
-struct PromiseBase {
+struct PromiseBase : PooledFrame {
+  // runs when the coroutine finishes without a continuation, may destroy the frame, the returned handle (if any)
+  // is resumed by symmetric transfer
+  using CompletionFn = std::coroutine_handle<> (*)(void* ctx, std::coroutine_handle<> self) noexcept;
+
   std::coroutine_handle<> continueHandle;
   std::exception_ptr exceptionPtr;
+  CompletionFn completionFn {nullptr};
+  void* completionCtx {nullptr};
+  // cancellation of this task, handed down to every task it awaits that has none of its own
+  std::stop_token stopToken;
 
   struct FinalAwaiter {
     auto await_ready() const noexcept -> bool { return false; }
@@ -20,11 +32,16 @@ struct PromiseBase {
     auto await_suspend(std::coroutine_handle<PromiseTy> handle) noexcept -> std::coroutine_handle<>
     {
       assert(handle.done() && "handle should done here");
-      if (handle.promise().continueHandle) {
-        return handle.promise().continueHandle;
-      } else {
-        return std::noop_coroutine();
+      auto& promise = handle.promise();
+      if (promise.continueHandle) {
+        return promise.continueHandle;
+      } else if (promise.completionFn) {
+        // the frame may be gone after this call
+        if (auto next = promise.completionFn(promise.completionCtx, handle)) {
+          return next;
+        }
       }
+      return std::noop_coroutine();
     }
     auto await_resume() noexcept -> void {}
   };
@@ -33,8 +50,37 @@ struct PromiseBase {
   auto final_suspend() noexcept -> FinalAwaiter { return {}; }
   auto unhandled_exception() noexcept -> void { exceptionPtr = std::current_exception(); }
   auto setContinue(std::coroutine_handle<> continuation) noexcept -> void { continueHandle = continuation; }
+  auto setCompletion(CompletionFn fn, void* ctx) noexcept -> void
+  {
+    completionFn = fn;
+    completionCtx = ctx;
+  }
+  auto inheritStop(std::stop_token const& token) noexcept -> void
+  {
+    if (!stopToken.stop_possible()) {
+      stopToken = token;
+    }
+  }
 };
 
+// stop token of the coroutine behind `handle`, null when it is not a Task
+template <typename P>
+auto StopTokenOf(std::coroutine_handle<P> handle) noexcept -> std::stop_token const*
+{
+  if constexpr (std::is_base_of_v<PromiseBase, P>) {
+    return &handle.promise().stopToken;
+  } else {
+    return nullptr;
+  }
+}
+template <typename P>
+auto InheritStop(PromiseBase& child, std::coroutine_handle<P> parent) noexcept -> void
+{
+  if (auto token = StopTokenOf(parent)) {
+    child.inheritStop(*token);
+  }
+}
+
 template <typename T>
 struct Promise final : PromiseBase {
   T returnValue;
@@ -81,6 +127,18 @@ public:
   explicit Task(std::coroutine_handle<promise_type> handle) noexcept : mHandle(handle) {}
   Task(Task const&) = delete;
   Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr)) {}
+  Task& operator=(Task const&) = delete;
+  Task& operator=(Task&& other) noexcept
+  {
+    if (this != &other) {
+      if (mHandle) {
+        assert(mHandle.done() && "handle should done here");
+        mHandle.destroy();
+      }
+      mHandle = std::exchange(other.mHandle, nullptr);
+    }
+    return *this;
+  }
   ~Task() noexcept
   {
     if (mHandle) {
@@ -112,37 +170,31 @@ public:
     }
   }
 
-  auto operator co_await() const& noexcept
-  {
-    struct Awaiter {
-      std::coroutine_handle<promise_type> callee;
-      auto await_ready() -> bool { return false; }
-      auto await_suspend(std::coroutine_handle<> caller) -> std::coroutine_handle<>
-      {
-        callee.promise().setContinue(caller);
-        return callee;
-      }
-      auto await_resume() -> decltype(auto) { return callee.promise().result(); }
-    };
-    return Awaiter {mHandle};
-  }
+  auto operator co_await() const& noexcept { return Awaiter<false> {mHandle}; }
+  auto operator co_await() && noexcept { return Awaiter<true> {mHandle}; }
 
-  auto operator co_await() && noexcept
-  {
-    struct Awaiter {
-      std::coroutine_handle<promise_type> callee;
-      auto await_ready() -> bool { return false; }
-      auto await_suspend(std::coroutine_handle<> caller) -> std::coroutine_handle<>
-      {
-        callee.promise().setContinue(caller);
-        return callee;
+private:
+  template <bool MOVE>
+  struct Awaiter {
+    std::coroutine_handle<promise_type> callee;
+    auto await_ready() -> bool { return false; }
+    template <typename P>
+    auto await_suspend(std::coroutine_handle<P> caller) -> std::coroutine_handle<>
+    {
+      callee.promise().setContinue(caller);
+      InheritStop(callee.promise(), caller);
+      return callee;
+    }
+    auto await_resume() -> decltype(auto)
+    {
+      if constexpr (MOVE) {
+        return std::move(callee.promise()).result();
+      } else {
+        return callee.promise().result();
       }
-      auto await_resume() -> decltype(auto) { return std::move(callee.promise()).result(); }
-    };
-    return Awaiter {mHandle};
-  }
+    }
+  };
 
-private:
   std::coroutine_handle<promise_type> mHandle {nullptr};
 };
 
@@ -156,6 +208,31 @@ inline auto Promise<void>::get_return_object() noexcept -> Task<void>
   return Task<void> {std::coroutine_handle<Promise>::from_promise(*this)};
 }
 
+// Attach `token` to `task`, the awaited tasks below it inherit it. Reactor sleeps, fd readiness waits and mutex
+// locks in the tree then resume with `operation_canceled` once stop is requested.
+template <typename T>
+[[nodiscard]] auto withStop(Task<T> task, std::stop_token token) -> Task<T>
+{
+  task.promise().stopToken = std::move(token);
+  return task;
+}
+
+struct StopTokenAwaiter {
+  std::stop_token token;
+  auto await_ready() const noexcept -> bool { return false; }
+  template <typename P>
+  auto await_suspend(std::coroutine_handle<P> handle) noexcept -> bool
+  {
+    if (auto current = StopTokenOf(handle)) {
+      token = *current;
+    }
+    return false;
+  }
+  auto await_resume() noexcept -> std::stop_token { return std::move(token); }
+};
+// `co_await currentStopToken()` gives the token of the running task without suspending
+[[nodiscard]] inline auto currentStopToken() noexcept -> StopTokenAwaiter { return {}; }
+
 template<typename T = void>
 struct DetachTask;
 
@@ -179,10 +256,10 @@ struct DetachTask {
     }
   };
 
-  struct promise_type {
+  struct promise_type : PooledFrame {
     std::exception_ptr exceptionPtr;
     T value;
-    std::function<void(T&&)> afterCleanUpFn {nullptr};
+    InlineFunction<void(T&&)> afterCleanUpFn {nullptr};
 
     auto get_return_object() -> DetachTask { return DetachTask {coroutine_handle_type::from_promise(*this)}; }
     auto initial_suspend() noexcept -> std::suspend_always { return {}; }
@@ -191,9 +268,10 @@ struct DetachTask {
     auto unhandled_exception() noexcept -> void { exceptionPtr = std::current_exception(); }
   };
   explicit DetachTask(coroutine_handle_type in) : handle(in) {}
-  auto afterDestroy(std::function<void(T&&)>&& fn) -> DetachTask
+  template <typename Fn>
+  auto afterDestroy(Fn&& fn) -> DetachTask
   {
-    handle.promise().afterCleanUpFn = std::move(fn);
+    handle.promise().afterCleanUpFn = std::forward<Fn>(fn);
     return *this;
   };
   coroutine_handle_type handle {nullptr};
@@ -218,9 +296,9 @@ struct DetachTask<void> {
     }
   };
 
-  struct promise_type {
+  struct promise_type : PooledFrame {
     std::exception_ptr exceptionPtr;
-    std::function<void(void)> afterCleanUpFn {nullptr};
+    InlineFunction<void()> afterCleanUpFn {nullptr};
 
     auto get_return_object() -> DetachTask { return DetachTask {coroutine_handle_type::from_promise(*this)}; }
     auto initial_suspend() noexcept -> std::suspend_always { return {}; }
@@ -229,9 +307,10 @@ struct DetachTask<void> {
     auto unhandled_exception() noexcept -> void { exceptionPtr = std::current_exception(); }
   };
   explicit DetachTask(coroutine_handle_type in) : handle(in) {}
-  auto afterDestroy(std::function<void(void)>&& fn) -> DetachTask
+  template <typename Fn>
+  auto afterDestroy(Fn&& fn) -> DetachTask
   {
-    handle.promise().afterCleanUpFn = std::move(fn);
+    handle.promise().afterCleanUpFn = std::forward<Fn>(fn);
     return *this;
   };
   coroutine_handle_type handle {nullptr};
@@ -257,7 +336,7 @@ struct ContinueTask {
     }
   };
 
-  struct promise_type {
+  struct promise_type : PooledFrame {
     std::exception_ptr exceptionPtr;
     std::coroutine_handle<> continueHandle {nullptr};
 
@@ -300,10 +379,10 @@ struct AfterDestroy {
     }
   };
 
-  struct promise_type {
+  struct promise_type : PooledFrame {
     std::exception_ptr exceptionPtr;
     T value;
-    std::function<void(T&&)> afterCleanUpFn {nullptr};
+    InlineFunction<void(T&&)> afterCleanUpFn {nullptr};
 
     auto get_return_object() -> AfterDestroy { return AfterDestroy {coroutine_handle_type::from_promise(*this)}; }
     auto initial_suspend() noexcept -> std::suspend_always { return {}; }
@@ -312,9 +391,10 @@ struct AfterDestroy {
     auto unhandled_exception() noexcept -> void { exceptionPtr = std::current_exception(); }
   };
   explicit AfterDestroy(coroutine_handle_type in) : handle(in) {}
-  auto afterDestroy(std::function<void(T&&)>&& fn) -> AfterDestroy
+  template <typename Fn>
+  auto afterDestroy(Fn&& fn) -> AfterDestroy
   {
-    handle.promise().afterCleanUpFn = std::move(fn);
+    handle.promise().afterCleanUpFn = std::forward<Fn>(fn);
     return *this;
   };
   coroutine_handle_type handle {nullptr};
@@ -339,9 +419,9 @@ struct AfterDestroy<void> {
     }
   };
 
-  struct promise_type {
+  struct promise_type : PooledFrame {
     std::exception_ptr exceptionPtr;
-    std::function<void(void)> afterCleanUpFn {nullptr};
+    InlineFunction<void()> afterCleanUpFn {nullptr};
 
     auto get_return_object() -> AfterDestroy { return AfterDestroy {coroutine_handle_type::from_promise(*this)}; }
     auto initial_suspend() noexcept -> std::suspend_always { return {}; }
@@ -350,9 +430,10 @@ struct AfterDestroy<void> {
     auto unhandled_exception() noexcept -> void { exceptionPtr = std::current_exception(); }
   };
   explicit AfterDestroy(coroutine_handle_type in) : handle(in) {}
-  auto afterDestroy(std::function<void(void)>&& fn) -> AfterDestroy
+  template <typename Fn>
+  auto afterDestroy(Fn&& fn) -> AfterDestroy
   {
-    handle.promise().afterCleanUpFn = std::move(fn);
+    handle.promise().afterCleanUpFn = std::forward<Fn>(fn);
     return *this;
   };
   coroutine_handle_type handle {nullptr};
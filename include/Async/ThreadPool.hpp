@@ -1,9 +1,18 @@
 #pragma once
+#include "ExecutorRef.hpp"
 #include "Task.hpp"
 #include "ThreadSafe.hpp"
+#include "sys/Topology.hpp"
+#include "utils/Metrics.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <condition_variable>
+#include <list>
 #include <mutex>
+#include <optional>
 #include <thread>
+#include <vector>
 
 namespace async {
 
@@ -12,65 +21,234 @@ struct ThreadPoolBase {
   virtual auto execute(std::coroutine_handle<> handle) -> void = 0;
 };
 
+// scheduling lane of a coroutine, it keeps the lane it was spawned on: a task resumed by the reactor or a primitive
+// is queued back on the lane it suspended from
+enum class Priority : uint8_t {
+  High,   // served first
+  Normal,
+  Low,    // background work, gets a fixed share of the picks while the other lanes keep the workers busy
+};
+
+class StealingThreadPool;
+// lets the owner of a StealingThreadPool run its own event loop on the workers, every call comes from worker `id`
+struct WorkerDriver {
+  virtual ~WorkerDriver() = default;
+  virtual auto start(StealingThreadPool& pool, std::size_t id) -> void = 0;
+  virtual auto stop(StealingThreadPool& pool, std::size_t id) -> void = 0;
+  // non-blocking, called every few tasks so a busy worker still sees its events
+  virtual auto poll(StealingThreadPool& pool, std::size_t id) -> void = 0;
+  // block until `unpark(id)` or until the driver has work of its own, false if it cannot block right now and the
+  // worker should sleep on its futex instead
+  virtual auto park(StealingThreadPool& pool, std::size_t id) -> bool = 0;
+  // any thread
+  virtual auto unpark(std::size_t id) -> void = 0;
+};
+
+struct BlockingPoolConfig {
+  size_t minThreads = 0;   // started up front and never reaped
+  size_t maxThreads = 500;
+  std::chrono::milliseconds keepAlive = std::chrono::milliseconds(500); // idle time before a thread above the minimum exits
+  size_t queueCapacity = 4096; // jobs past this wait, suspended, until a worker makes room
+};
+
+struct BlockingPoolStats {
+  size_t threads;        // alive workers
+  size_t idle;           // workers waiting for a job
+  size_t queued;         // admitted jobs not started yet
+  size_t throttled;      // jobs waiting for room in the queue
+  size_t peakQueued;     // admitted plus throttled, at its highest
+  size_t submitted;
+  size_t completed;
+  size_t throttledTotal; // jobs that had to wait for room
+  size_t threadsStarted;
+  std::chrono::nanoseconds totalWait; // submit to start, over the started jobs
+  std::chrono::nanoseconds maxWait;
+  std::chrono::nanoseconds totalRun;
+};
+
+namespace detail {
+// intrusive, usually it is the awaiter of the coroutine that is suspended until the job ran
+struct BlockingJob {
+  BlockingJob* next = nullptr;
+  auto (*run)(BlockingJob*) -> void = nullptr;
+  std::chrono::steady_clock::time_point submitted {};
+};
+
+struct BlockingJobQueue {
+  BlockingJob* head = nullptr;
+  BlockingJob* tail = nullptr;
+  size_t size = 0;
+
+  auto push(BlockingJob* job) -> void
+  {
+    job->next = nullptr;
+    (tail != nullptr ? tail->next : head) = job;
+    tail = job;
+    size += 1;
+  }
+  auto pop() -> BlockingJob*
+  {
+    auto job = head;
+    if (job != nullptr) {
+      head = job->next;
+      tail = head != nullptr ? tail : nullptr;
+      size -= 1;
+    }
+    return job;
+  }
+};
+} // namespace detail
+
+// Threads for blocking calls. A thread is started when the admitted jobs outnumber the idle threads, and one above
+// `minThreads` exits after `keepAlive` without work. At most `queueCapacity` jobs are admitted, the rest wait in
+// submission order, their coroutines staying suspended. The destructor runs what was submitted and joins every thread.
 class BlockingThreadPool : public ThreadPoolBase {
 public:
-  BlockingThreadPool(size_t threadLimit) : mIdleCount(0), mThreadCount(0), mThreadLimits(threadLimit) {}
+  explicit BlockingThreadPool(BlockingPoolConfig config = {}) : mConfig(config)
+  {
+    assert(mConfig.maxThreads > 0 && mConfig.minThreads <= mConfig.maxThreads && mConfig.queueCapacity > 0);
+    auto lk = std::unique_lock(mLock);
+    while (mThreads.size() < mConfig.minThreads) {
+      startThread();
+    }
+  }
   ~BlockingThreadPool() override
   {
-    auto lk = std::unique_lock(mQueueMt);
-    mQueueCv.wait(lk, [this]() { return mQueue.empty(); });
+    auto lk = std::unique_lock(mLock);
+    mStopping = true;
+    mCv.notify_all();
+    auto threads = std::move(mThreads);
+    auto exited = std::move(mExited);
+    lk.unlock();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (auto& thread : exited) {
+      thread.join();
+    }
   }
+  BlockingThreadPool(BlockingThreadPool const&) = delete;
+  BlockingThreadPool& operator=(BlockingThreadPool const&) = delete;
+
+  // the job must stay alive until its `run` is called
+  auto submit(detail::BlockingJob* job) -> void
+  {
+    job->submitted = std::chrono::steady_clock::now();
+    auto lk = std::unique_lock(mLock);
+    assert(!mStopping);
+    mStats.submitted += 1;
+    if (mQueue.size < mConfig.queueCapacity) {
+      mQueue.push(job);
+    } else {
+      mThrottled.push(job);
+      mStats.throttledTotal += 1;
+    }
+    mStats.peakQueued = std::max(mStats.peakQueued, mQueue.size + mThrottled.size);
+    if (mIdle > 0) {
+      mCv.notify_one();
+    }
+    while (mQueue.size > mIdle && mThreads.size() < mConfig.maxThreads) {
+      startThread();
+    }
+    auto exited = std::move(mExited);
+    mExited.clear();
+    lk.unlock();
+    for (auto& thread : exited) {
+      thread.join();
+    }
+  }
+  // resumes the handle on a pool thread
   auto execute(std::coroutine_handle<> handle) -> void override
   {
-    auto lk = std::unique_lock(mQueueMt);
-    mQueue.push_back(std::move(handle));
-    mQueueCv.notify_one();
-    growPool();
+    struct HandleJob : detail::BlockingJob {
+      std::coroutine_handle<> handle;
+    };
+    auto job = new HandleJob {};
+    job->handle = handle;
+    job->run = [](detail::BlockingJob* self) {
+      auto handle = static_cast<HandleJob*>(self)->handle;
+      delete static_cast<HandleJob*>(self);
+      handle.resume();
+    };
+    submit(job);
+  }
+
+  [[nodiscard]] auto config() const -> BlockingPoolConfig const& { return mConfig; }
+  [[nodiscard]] auto stats() -> BlockingPoolStats
+  {
+    auto lk = std::unique_lock(mLock);
+    auto stats = mStats;
+    stats.threads = mThreads.size();
+    stats.idle = mIdle;
+    stats.queued = mQueue.size;
+    stats.throttled = mThrottled.size;
+    return stats;
   }
 
 private:
-  auto loop() -> void
+  auto startThread() -> void
   {
-    using namespace std::chrono_literals;
-    auto lk = std::unique_lock(mQueueMt);
-    while (true) {
-      mIdleCount -= 1;
-      while (!mQueue.empty()) {
-        growPool();
-        auto task = std::move(mQueue.front());
-        mQueue.pop_front();
-        lk.unlock();
-        task.resume();
-        lk.lock();
-      }
-      mIdleCount += 1;
-      auto r = mQueueCv.wait_for(lk, 500ms);
-      if (r == std::cv_status::timeout && mQueue.empty()) {
-        mIdleCount -= 1;
-        mThreadCount -= 1;
-        break;
+    auto it = mThreads.emplace(mThreads.end());
+    mIdle += 1; // counted as idle until it looks at the queue
+    mStats.threadsStarted += 1;
+    *it = std::thread([this, it]() { loop(it); });
+  }
+
+  // the oldest admitted job, a throttled one takes its place
+  auto take() -> detail::BlockingJob*
+  {
+    auto job = mQueue.pop();
+    if (job != nullptr) {
+      if (auto waiting = mThrottled.pop()) {
+        mQueue.push(waiting);
       }
     }
+    return job;
   }
 
-  auto growPool() -> void
+  auto loop(std::list<std::thread>::iterator self) -> void
   {
-    assert(!mQueueMt.try_lock());
-    while (mQueue.size() > mIdleCount * 5 && mThreadCount < mThreadLimits) {
-      mThreadCount += 1;
-      mIdleCount += 1;
-      mQueueCv.notify_all();
-      std::thread([this]() { loop(); }).detach();
+    auto lk = std::unique_lock(mLock);
+    mIdle -= 1;
+    while (true) {
+      while (auto job = take()) {
+        auto start = std::chrono::steady_clock::now();
+        auto wait = std::chrono::duration_cast<std::chrono::nanoseconds>(start - job->submitted);
+        mStats.totalWait += wait;
+        mStats.maxWait = std::max(mStats.maxWait, wait);
+        lk.unlock();
+        job->run(job); // the job may be gone after this
+        auto end = std::chrono::steady_clock::now();
+        lk.lock();
+        mStats.completed += 1;
+        mStats.totalRun += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+      }
+      if (mStopping) {
+        return; // joined by the destructor
+      }
+      mIdle += 1;
+      auto status = mCv.wait_for(lk, mConfig.keepAlive);
+      mIdle -= 1;
+      if (status == std::cv_status::timeout && mQueue.size == 0 && !mStopping &&
+          mThreads.size() > mConfig.minThreads) {
+        // joined by the next submit or the destructor
+        mExited.push_back(std::move(*self));
+        mThreads.erase(self);
+        return;
+      }
     }
   }
 
-  std::mutex mQueueMt;
-  std::condition_variable mQueueCv;
-  std::deque<std::coroutine_handle<>> mQueue;
-
-  size_t mIdleCount;
-  size_t mThreadCount;
-  size_t mThreadLimits;
+  BlockingPoolConfig const mConfig;
+  std::mutex mLock;
+  std::condition_variable mCv;
+  detail::BlockingJobQueue mQueue;     // guarded by mLock
+  detail::BlockingJobQueue mThrottled; // guarded by mLock
+  std::list<std::thread> mThreads;     // guarded by mLock
+  std::vector<std::thread> mExited;    // guarded by mLock
+  size_t mIdle = 0;
+  bool mStopping = false;
+  BlockingPoolStats mStats {};
 };
 
 class ThreadPool : public ThreadPoolBase {
@@ -145,70 +323,470 @@ private:
 
 class StealingThreadPool : public ThreadPoolBase {
 public:
-  explicit StealingThreadPool(uint32_t const& threadNum) : mQueues(threadNum)
-  {
-    std::size_t currentId = 0;
-    for (std::size_t i = 0; i < threadNum; ++i) {
-      mThreads.emplace_back([&, id = currentId](std::stop_token const& stop_tok) {
-        do {
-          mQueues[id].signal.acquire();
-          do {
-            while (auto task = mQueues[id].tasks.pop()) {
-              mPendingTasks.fetch_sub(1, std::memory_order_release);
-              std::invoke(std::move(task.value()));
-            }
-            for (std::size_t j = 1; j < mQueues.size(); ++j) {
-              const std::size_t index = (id + j) % mQueues.size();
-              if (auto task = mQueues[index].tasks.steal()) {
-                mPendingTasks.fetch_sub(1, std::memory_order_release);
-                std::invoke(std::move(task.value()));
-                break;
-              }
-            }
-          } while (mPendingTasks.load(std::memory_order_acquire) > 0);
-        } while (!stop_tok.stop_requested());
-      });
-      ++currentId;
+  static constexpr size_t INJECTOR_CAPACITY = 1024;
+  static constexpr size_t INJECT_BATCH = 32;   // handles a worker moves from the injector in one go
+  static constexpr uint32_t MAX_LIFO_STREAK = 3; // consecutive LIFO slot runs before the local queue gets a turn
+  static constexpr uint32_t SPIN_ROUNDS = 32;    // failed searches before a worker parks
+  static constexpr uint32_t POLL_INTERVAL = 61;  // tasks between two driver polls on a busy worker
+  static constexpr size_t LANES = 3;
+  // every NORMAL_TURN-th pick from the queues looks at the Normal lane first and every LOW_TURN-th at the Low lane,
+  // so work on a lower lane ages into a turn however busy the higher ones are
+  static constexpr uint32_t NORMAL_TURN = 8;
+  static constexpr uint32_t LOW_TURN = 64;
+
+  // with a driver, workers park in `driver->park` instead of the futex; with a placement worker `i` is pinned to
+  // `placement[i]` and steals from the closest workers first
+  explicit StealingThreadPool(uint32_t const& threadNum, WorkerDriver* driver = nullptr,
+                              std::vector<CpuInfo> placement = {})
+      : mQueues(threadNum), mDriver(driver), mPlacement(std::move(placement)),
+        mLanes {Lane {this, Priority::High}, Lane {this, Priority::Normal}, Lane {this, Priority::Low}}
+  {
+    assert(mPlacement.empty() || mPlacement.size() == threadNum);
+    auto orders = mPlacement.empty() ? std::vector<std::vector<uint32_t>> {} : Topology::StealOrder(mPlacement);
+    for (std::size_t id = 0; id < threadNum; ++id) {
+      if (!orders.empty()) {
+        mQueues[id].victims = std::move(orders[id]);
+        continue;
+      }
+      for (std::size_t j = 1; j < threadNum; ++j) {
+        mQueues[id].victims.push_back(static_cast<uint32_t>((id + j) % threadNum));
+      }
+    }
+    mSleepers.reserve(threadNum);
+    for (std::size_t id = 0; id < threadNum; ++id) {
+      mThreads.emplace_back([this, id](std::stop_token const& stop_tok) { run(id, stop_tok); });
     }
   }
 
   ~StealingThreadPool() override
   {
-    for (std::size_t i = 0; i < mThreads.size(); ++i) {
-      mThreads[i].request_stop();
-      mQueues[i].signal.release();
-      mThreads[i].join();
+    for (auto& thread : mThreads) {
+      thread.request_stop();
+    }
+    {
+      auto lk = std::scoped_lock(mSleepLock);
+      for (auto id : mSleepers) {
+        unpark(id);
+      }
+      mSleepers.clear();
+      mSleeperCount.store(0, std::memory_order_relaxed);
+    }
+    for (auto& thread : mThreads) {
+      thread.join();
     }
   }
   StealingThreadPool(StealingThreadPool const&) = delete;
   StealingThreadPool& operator=(StealingThreadPool const&) = delete;
 
   [[nodiscard]] auto size() const { return mThreads.size(); }
-  auto execute(std::coroutine_handle<> h) -> void override
+  // empty when the workers are not pinned
+  [[nodiscard]] auto placement() const -> std::vector<CpuInfo> const& { return mPlacement; }
+  // true once parked worker `id` has been woken, lets a driver check this before it blocks
+  [[nodiscard]] auto unparked(std::size_t id) const -> bool
+  {
+    return mQueues[id].state.load(std::memory_order_seq_cst) != PARKED;
+  }
+  // index of the calling worker, empty when called from outside this pool
+  [[nodiscard]] auto currentWorker() const -> std::optional<std::size_t>
+  {
+    if (tWorker.pool != this) {
+      return std::nullopt;
+    }
+    return tWorker.id;
+  }
+  auto execute(std::coroutine_handle<> h) -> void override { execute(h, Priority::Normal); }
+  auto execute(std::coroutine_handle<> h, Priority priority) -> void
   {
     if (h == nullptr) {
       return;
     }
-    enqueue_task(h);
+    auto lane = static_cast<size_t>(priority);
+    if (lane != NORMAL && (mActiveLanes.load(std::memory_order_relaxed) & (1u << lane)) == 0) {
+      mActiveLanes.fetch_or(1u << lane, std::memory_order_relaxed);
+    }
+    sample(h, lane);
+    if (auto id = currentWorker()) {
+      enqueue_local(*id, h, lane);
+    } else {
+      enqueue_task(h, lane);
+    }
   }
 
 private:
-  auto enqueue_task(std::coroutine_handle<> h) -> void
+  enum : uint32_t { RUNNING, PARKED };
+  static constexpr size_t HIGH = static_cast<size_t>(Priority::High);
+  static constexpr size_t NORMAL = static_cast<size_t>(Priority::Normal);
+
+  // what `ExecutorRef::Current()` is while a task of that lane runs, so whatever it suspends on brings it back there
+  struct Lane {
+    StealingThreadPool* pool;
+    Priority priority;
+    auto execute(std::coroutine_handle<> h) -> void { pool->execute(h, priority); }
+  };
+  struct Picked {
+    std::coroutine_handle<> handle;
+    size_t lane;
+  };
+  using LaneOrder = std::array<uint8_t, LANES>;
+
+  struct TaskItem {
+    std::array<spmc::Deque<std::coroutine_handle<>>, LANES> tasks;
+    std::atomic_uint32_t state {RUNNING}; // futex word while parked
+    std::coroutine_handle<> next = nullptr; // LIFO slot, owner only and never stolen
+    size_t nextLane = NORMAL;
+    uint32_t streak = 0;
+    uint32_t picks = 0; // queue picks so far, decides which lane is looked at first
+    std::vector<uint32_t> victims {}; // the other workers, in steal order
+  };
+  struct Injector {
+    mpmc::BoundedQueue<std::coroutine_handle<>> queue {INJECTOR_CAPACITY};
+    mpmc::Queue<std::coroutine_handle<>> overflow {}; // only used when the queue is full
+    std::atomic_size_t spilled {};
+  };
+
+  static auto OrderOf(uint32_t pick) -> LaneOrder
   {
-    const std::size_t i = mCount++ % mQueues.size();
-    mPendingTasks.fetch_add(1, std::memory_order_relaxed);
-    mQueues[i].tasks.push(std::move(h));
-    mQueues[i].signal.release();
+    if (pick % LOW_TURN == 0) {
+      return {2, 0, 1};
+    }
+    if (pick % NORMAL_TURN == 0) {
+      return {1, 0, 2};
+    }
+    return {0, 1, 2};
   }
+  auto isActive(size_t lane) const -> bool { return (mActiveLanes.load(std::memory_order_relaxed) >> lane) & 1; }
 
-  struct TaskItem {
-    mpmc::Queue<std::coroutine_handle<>> tasks {};
-    std::binary_semaphore signal {0};
+  auto run(std::size_t id, std::stop_token const& stop) -> void
+  {
+    tWorker = WorkerContext {this, id};
+    Metrics::setWorker(id);
+    if (!mPlacement.empty()) {
+      // pinned before its first allocation, so the frames it caches are first touched on its own node; a cpu taken
+      // away since the placement was made leaves it unpinned
+      static_cast<void>(Topology::Pin(mPlacement[id].cpu));
+    }
+    auto current = NORMAL;
+    auto previous = ExecutorRef::SetCurrent(mLanes[current]);
+    if (mDriver != nullptr) {
+      mDriver->start(*this, id);
+    }
+    auto searching = false;
+    auto woken = false;
+    auto ticks = 0u;
+    while (true) {
+      auto task = findTask(id);
+      if (!task && mDriver != nullptr) {
+        mDriver->poll(*this, id); // may dispatch events straight into this worker's queue
+        task = findTask(id);
+      }
+      for (auto spin = 0u; !task && spin < SPIN_ROUNDS; ++spin) {
+        if (!searching) {
+          searching = true;
+          mSearching.fetch_add(1, std::memory_order_seq_cst);
+        }
+        std::this_thread::yield();
+        task = findTask(id);
+      }
+      if (searching) {
+        searching = false;
+        // the last searcher found work, there may be more: hand the search over to someone else
+        if (mSearching.fetch_sub(1, std::memory_order_seq_cst) == 1 && task) {
+          notifyOne();
+        }
+      }
+      if (task) {
+        if (task->lane != current) {
+          current = task->lane;
+          ExecutorRef::SetCurrent(mLanes[current]);
+        }
+        woken = false;
+        sampled(task->handle, task->lane);
+        auto start = Metrics::now();
+        task->handle.resume();
+        Metrics::count(Counter::Tasks);
+        Metrics::record(Histogram::TaskPoll, Metrics::since(start));
+        if (mDriver != nullptr && ++ticks == POLL_INTERVAL) {
+          ticks = 0;
+          mDriver->poll(*this, id);
+        }
+      } else if (stop.stop_requested()) {
+        break;
+      } else {
+        if (woken) {
+          Metrics::count(Counter::SpuriousWakeups);
+        }
+        park(id, stop);
+        woken = true;
+      }
+    }
+    if (mDriver != nullptr) {
+      mDriver->stop(*this, id);
+    }
+    ExecutorRef::SetCurrent(previous);
+    Metrics::setWorker(std::nullopt);
+    tWorker = WorkerContext {nullptr, 0};
+  }
+
+  // register as a sleeper, check for work once more, then sleep on the futex until unparked
+  auto park(std::size_t id, std::stop_token const& stop) -> void
+  {
+    auto& state = mQueues[id].state;
+    Metrics::count(Counter::Parks);
+    state.store(PARKED, std::memory_order_relaxed);
+    {
+      auto lk = std::scoped_lock(mSleepLock);
+      mSleepers.push_back(id);
+      mSleeperCount.fetch_add(1, std::memory_order_seq_cst);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (hasWork() || stop.stop_requested()) {
+      auto lk = std::scoped_lock(mSleepLock);
+      if (auto it = std::find(mSleepers.begin(), mSleepers.end(), id); it != mSleepers.end()) {
+        mSleepers.erase(it);
+        mSleeperCount.fetch_sub(1, std::memory_order_relaxed);
+        state.store(RUNNING, std::memory_order_relaxed);
+        return;
+      }
+      // already picked by a waker, consume its wakeup below
+    }
+    if (mDriver != nullptr && mDriver->park(*this, id)) {
+      // the driver may return because of its own events, leave the sleeper list in that case
+      {
+        auto lk = std::scoped_lock(mSleepLock);
+        if (auto it = std::find(mSleepers.begin(), mSleepers.end(), id); it != mSleepers.end()) {
+          mSleepers.erase(it);
+          mSleeperCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+      state.store(RUNNING, std::memory_order_relaxed);
+      // nobody may be polling now, let another worker pick the driver up
+      notifyOne();
+      return;
+    }
+    while (state.load(std::memory_order_acquire) == PARKED) {
+      state.wait(PARKED, std::memory_order_acquire);
+    }
+  }
+
+  // wake one sleeper, unless a searching worker will see the new work anyway
+  auto notifyOne() -> void
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSearching.load(std::memory_order_seq_cst) > 0 || mSleeperCount.load(std::memory_order_seq_cst) == 0) {
+      return;
+    }
+    auto lk = std::unique_lock(mSleepLock);
+    if (mSleepers.empty()) {
+      return;
+    }
+    auto id = mSleepers.back();
+    mSleepers.pop_back();
+    mSleeperCount.fetch_sub(1, std::memory_order_relaxed);
+    lk.unlock();
+    Metrics::count(Counter::Unparks);
+    unpark(id);
+  }
+
+  auto unpark(std::size_t id) -> void
+  {
+    auto& state = mQueues[id].state;
+    state.store(RUNNING, std::memory_order_seq_cst);
+    state.notify_one();
+    if (mDriver != nullptr) {
+      mDriver->unpark(id);
+    }
+  }
+
+  // only stealable work counts, LIFO slots are drained by their owners before parking
+  auto hasWork() const -> bool
+  {
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      if (!isActive(lane)) {
+        continue;
+      }
+      auto& injector = mInjectors[lane];
+      if (injector.queue.size() > 0 || injector.spilled.load(std::memory_order_relaxed) > 0) {
+        return true;
+      }
+      auto queued = [lane](TaskItem const& item) { return !item.tasks[lane].empty(); };
+      if (std::any_of(mQueues.begin(), mQueues.end(), queued)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  // queued work on a lane above `lane` this worker would pick first
+  auto higherWaiting(TaskItem const& worker, size_t lane) const -> bool
+  {
+    for (size_t higher = 0; higher < lane; ++higher) {
+      if (isActive(higher) && (!worker.tasks[higher].empty() || mInjectors[higher].queue.size() > 0 ||
+                               mInjectors[higher].spilled.load(std::memory_order_relaxed) > 0)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // a handle woken by a worker most likely touches what that worker just touched, keep it there
+  auto enqueue_local(std::size_t id, std::coroutine_handle<> h, size_t lane) -> void
+  {
+    auto& worker = mQueues[id];
+    auto prevLane = std::exchange(worker.nextLane, lane);
+    if (auto prev = std::exchange(worker.next, h)) {
+      worker.tasks[prevLane].push(prev);
+      if constexpr (Metrics::ENABLED) {
+        Metrics::record(Histogram::QueueDepth, worker.tasks[prevLane].size());
+      }
+      // a stealable handle appeared, make sure someone can take it while this worker is busy
+      notifyOne();
+    }
+  }
+
+  auto enqueue_task(std::coroutine_handle<> h, size_t lane) -> void
+  {
+    auto& injector = mInjectors[lane];
+    Metrics::count(Counter::Injected);
+    if (!injector.queue.tryPush(h)) {
+      Metrics::count(Counter::Spilled);
+      injector.spilled.fetch_add(1, std::memory_order_relaxed);
+      injector.overflow.push(std::move(h));
+    }
+    if constexpr (Metrics::ENABLED) {
+      Metrics::record(Histogram::InjectorDepth,
+                      injector.queue.size() + injector.spilled.load(std::memory_order_relaxed));
+    }
+    notifyOne();
+  }
+
+  // LIFO slot first unless a higher lane has work, then lane by lane the local deque and the injector, and finally
+  // the other workers
+  auto findTask(std::size_t id) -> std::optional<Picked>
+  {
+    auto& worker = mQueues[id];
+    auto fifo = LANES;
+    if (worker.next != nullptr) {
+      if (worker.streak < MAX_LIFO_STREAK && !higherWaiting(worker, worker.nextLane)) {
+        worker.streak += 1;
+        Metrics::count(Counter::LifoHits);
+        return Picked {std::exchange(worker.next, nullptr), worker.nextLane};
+      }
+      // two coroutines ping-ponging must not starve the rest of the queue: take its oldest handle instead
+      worker.tasks[worker.nextLane].push(std::exchange(worker.next, nullptr));
+      fifo = worker.nextLane;
+    }
+    worker.streak = 0;
+    auto order = OrderOf(worker.picks++);
+    for (auto lane : order) {
+      if (!isActive(lane)) {
+        continue;
+      }
+      auto& local = worker.tasks[lane];
+      if (auto task = lane == fifo ? local.steal() : local.pop()) {
+        Metrics::count(Counter::LocalPops);
+        return Picked {*task, lane};
+      }
+      if (auto task = takeInjected(local, lane)) {
+        Metrics::count(Counter::InjectorTakes);
+        return Picked {*task, lane};
+      }
+    }
+    for (auto lane : order) {
+      if (!isActive(lane)) {
+        continue;
+      }
+      for (auto victim : worker.victims) {
+        Metrics::count(Counter::StealAttempts);
+        if (auto task = mQueues[victim].tasks[lane].steal()) {
+          Metrics::count(Counter::Steals);
+          return Picked {*task, lane};
+        }
+      }
+    }
+    return std::nullopt;
+  }
+
+  // take one handle to run now and move a fair share of the rest into the local deque
+  auto takeInjected(spmc::Deque<std::coroutine_handle<>>& local, size_t lane) -> std::optional<std::coroutine_handle<>>
+  {
+    auto& injector = mInjectors[lane];
+    auto next = [&injector]() -> std::optional<std::coroutine_handle<>> {
+      if (auto task = injector.queue.pop()) {
+        return task;
+      }
+      if (injector.spilled.load(std::memory_order_relaxed) > 0) {
+        if (auto task = injector.overflow.pop()) {
+          injector.spilled.fetch_sub(1, std::memory_order_relaxed);
+          return task;
+        }
+      }
+      return std::nullopt;
+    };
+    auto first = next();
+    if (!first) {
+      return std::nullopt;
+    }
+    auto queued = injector.queue.size() + injector.spilled.load(std::memory_order_relaxed);
+    auto batch = std::min(INJECT_BATCH, queued / mQueues.size() + 1);
+    for (std::size_t n = 1; n < batch; ++n) {
+      auto task = next();
+      if (!task) {
+        break;
+      }
+      local.push(*task);
+    }
+    return first;
+  }
+
+  // times a handle from `execute` to its `resume` when no other one of its lane is being timed; published before the
+  // handle is queued, so the worker taking it always sees it
+  auto sample([[maybe_unused]] std::coroutine_handle<> h, [[maybe_unused]] size_t lane) -> void
+  {
+#ifdef ASYNC_METRICS
+    auto& probe = mProbes[lane];
+    auto expected = static_cast<void*>(nullptr);
+    if (probe.handle.load(std::memory_order_relaxed) == nullptr &&
+        probe.handle.compare_exchange_strong(expected, Probe::CLAIMED, std::memory_order_acquire)) {
+      probe.queued = Metrics::now();
+      probe.handle.store(h.address(), std::memory_order_release);
+    }
+#endif
+  }
+  auto sampled([[maybe_unused]] std::coroutine_handle<> h, [[maybe_unused]] size_t lane) -> void
+  {
+#ifdef ASYNC_METRICS
+    auto& probe = mProbes[lane];
+    if (probe.handle.load(std::memory_order_acquire) == h.address()) {
+      Metrics::record(Histogram::ScheduleDelay, Metrics::since(probe.queued));
+      probe.handle.store(nullptr, std::memory_order_release);
+    }
+#endif
+  }
+
+  struct WorkerContext {
+    StealingThreadPool const* pool;
+    std::size_t id;
   };
+  static inline thread_local WorkerContext tWorker {nullptr, 0};
 
   std::vector<std::jthread> mThreads;
   std::deque<TaskItem> mQueues;
-  std::size_t mCount {};
-  std::atomic_int64_t mPendingTasks {};
+  std::array<Injector, LANES> mInjectors;
+  std::atomic_uint32_t mActiveLanes {1u << NORMAL}; // lanes that were ever used, the others are never scanned
+  WorkerDriver* mDriver;
+  std::vector<CpuInfo> const mPlacement;
+  std::array<Lane, LANES> mLanes;
+#ifdef ASYNC_METRICS
+  struct alignas(64) Probe {
+    static inline void* const CLAIMED = reinterpret_cast<void*>(1); // frames are never at odd addresses
+    std::atomic<void*> handle {nullptr};
+    Metrics::Stamp queued {};
+  };
+  std::array<Probe, LANES> mProbes;
+#endif
+
+  std::atomic_uint32_t mSearching {}; // workers spinning on the queues, a push needs no wakeup while non-zero
+  std::atomic_size_t mSleeperCount {};
+  std::mutex mSleepLock;
+  std::vector<std::size_t> mSleepers; // parked workers, woken LIFO so the warmest one goes first
 };
 } // namespace async
\ No newline at end of file
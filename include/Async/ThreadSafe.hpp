@@ -1,8 +1,13 @@
 #pragma once
+#include <atomic>
+#include <bit>
+#include <cassert>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <optional>
+#include <queue>
+#include <vector>
 namespace async::mpmc {
 template <typename Lock>
 concept is_lockable = requires(Lock&& lock) {
@@ -60,4 +65,188 @@ private:
   std::deque<T> mData {};
   mutable Lock mMutex {};
 };
-} // namespace async::mpmc
\ No newline at end of file
+
+// bounded lock-free queue (Vyukov), every cell carries a sequence number telling whose turn it is
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : mMask(std::bit_ceil(capacity) - 1), mCells(mMask + 1)
+  {
+    assert(capacity >= 2);
+    for (size_t i = 0; i <= mMask; ++i) {
+      mCells[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  BoundedQueue(BoundedQueue const&) = delete;
+  BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+  // false when full
+  [[nodiscard]] auto tryPush(T value) -> bool
+  {
+    auto pos = mTail.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &mCells[pos & mMask];
+      auto seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = mTail.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = value;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] auto pop() -> std::optional<T>
+  {
+    auto pos = mHead.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &mCells[pos & mMask];
+      auto seq = cell->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return std::nullopt;
+      } else {
+        pos = mHead.load(std::memory_order_relaxed);
+      }
+    }
+    auto value = cell->value;
+    cell->seq.store(pos + mMask + 1, std::memory_order_release);
+    return value;
+  }
+
+  // approximate, only meant as a hint
+  [[nodiscard]] auto size() const -> size_t
+  {
+    auto tail = mTail.load(std::memory_order_relaxed);
+    auto head = mHead.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+  }
+  [[nodiscard]] auto capacity() const -> size_t { return mMask + 1; }
+
+private:
+  struct Cell {
+    std::atomic_size_t seq;
+    T value;
+  };
+  size_t const mMask;
+  std::vector<Cell> mCells;
+  alignas(64) std::atomic_size_t mHead {0};
+  alignas(64) std::atomic_size_t mTail {0};
+};
+} // namespace async::mpmc
+
+namespace async::spmc {
+// Chase-Lev work-stealing deque. The owner pushes and pops at the bottom without locking, thieves CAS the top.
+// The ring grows on demand, retired rings are kept until destruction because a thief may still be reading one.
+template <typename T>
+  requires std::is_trivially_copyable_v<T>
+class Deque {
+public:
+  explicit Deque(size_t capacity = 256) : mRing(new Ring(std::bit_ceil(capacity)))
+  {
+    mRetired.emplace_back(mRing.load(std::memory_order_relaxed));
+  }
+  Deque(Deque const&) = delete;
+  Deque& operator=(Deque const&) = delete;
+
+  // owner only
+  auto push(T value) -> void
+  {
+    auto bottom = mBottom.load(std::memory_order_relaxed);
+    auto top = mTop.load(std::memory_order_acquire);
+    auto ring = mRing.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<int64_t>(ring->mask)) {
+      ring = grow(ring, top, bottom);
+    }
+    ring->put(bottom, value);
+    mBottom.store(bottom + 1, std::memory_order_release); // publishes the slot to thieves
+  }
+
+  // owner only, LIFO
+  [[nodiscard]] auto pop() -> std::optional<T>
+  {
+    auto bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    auto ring = mRing.load(std::memory_order_relaxed);
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto top = mTop.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    auto value = ring->get(bottom);
+    if (top == bottom) {
+      // last element, race against thieves
+      auto won = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      mBottom.store(bottom + 1, std::memory_order_relaxed);
+      if (!won) {
+        return std::nullopt;
+      }
+    }
+    return value;
+  }
+
+  // any thread, FIFO; also fails spuriously when another thief wins the same element
+  [[nodiscard]] auto steal() -> std::optional<T>
+  {
+    auto top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto bottom = mBottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return std::nullopt;
+    }
+    auto value = mRing.load(std::memory_order_acquire)->get(top);
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  [[nodiscard]] auto size() const -> size_t
+  {
+    auto bottom = mBottom.load(std::memory_order_relaxed);
+    auto top = mTop.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+  }
+  [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+private:
+  struct Ring {
+    explicit Ring(size_t capacity) : mask(capacity - 1), slots(std::make_unique<std::atomic<T>[]>(capacity)) {}
+    auto put(int64_t i, T value) -> void { slots[i & mask].store(value, std::memory_order_relaxed); }
+    auto get(int64_t i) const -> T { return slots[i & mask].load(std::memory_order_relaxed); }
+    size_t mask;
+    std::unique_ptr<std::atomic<T>[]> slots;
+  };
+
+  auto grow(Ring* ring, int64_t top, int64_t bottom) -> Ring*
+  {
+    auto bigger = new Ring((ring->mask + 1) * 2);
+    for (auto i = top; i < bottom; ++i) {
+      bigger->put(i, ring->get(i));
+    }
+    mRetired.emplace_back(bigger);
+    mRing.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  alignas(64) std::atomic_int64_t mTop {0};
+  alignas(64) std::atomic_int64_t mBottom {0};
+  std::atomic<Ring*> mRing;
+  std::vector<std::unique_ptr<Ring>> mRetired; // owns every ring, including the live one
+};
+} // namespace async::spmc
\ No newline at end of file
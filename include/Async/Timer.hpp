@@ -0,0 +1,106 @@
+#pragma once
+#include "Async/Slab.hpp"
+#include "Async/concepts.hpp"
+#include <array>
+#include <chrono>
+#include <coroutine>
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace async {
+using TimePoint = std::chrono::time_point<std::chrono::steady_clock>;
+
+// Ordered timer store, O(log n) insert/cancel, expiry stops at the first future deadline.
+class TimerMap {
+public:
+  auto insert(TimePoint when, size_t id, std::coroutine_handle<> handle) -> void { mTimers.insert({{when, id}, handle}); }
+  auto remove(TimePoint when, size_t id) -> std::coroutine_handle<>
+  {
+    if (auto node = mTimers.extract({when, id}); !node.empty()) {
+      return node.mapped();
+    }
+    return nullptr;
+  }
+  auto popExpired(TimePoint now, std::vector<std::coroutine_handle<>>& out) -> size_t
+  {
+    auto count = size_t {0};
+    auto it = mTimers.begin();
+    for (; it != mTimers.end() && it->first.first <= now; ++it, ++count) {
+      out.push_back(it->second);
+    }
+    mTimers.erase(mTimers.begin(), it);
+    return count;
+  }
+  auto nextDeadline() const -> std::optional<TimePoint>
+  {
+    if (mTimers.empty()) {
+      return std::nullopt;
+    }
+    return mTimers.begin()->first.first;
+  }
+  auto size() const -> size_t { return mTimers.size(); }
+
+private:
+  std::map<std::pair<TimePoint, size_t>, std::coroutine_handle<>> mTimers;
+};
+
+// Hierarchical timing wheel, O(1) insert/cancel. Each level has 64 slots, a slot of level n covers 64^n ticks.
+// Deadlines are rounded up to the tick, so a timer never fires early and at most one tick late. The next deadline
+// is found from the per-level occupancy bitmaps without touching the entries.
+class TimerWheel {
+public:
+  static constexpr auto LEVEL_BITS = 6u;
+  static constexpr auto SLOTS = 1u << LEVEL_BITS;
+  static constexpr auto LEVELS = 6u;
+  static constexpr auto MAX_TICK = (uint64_t {1} << (LEVEL_BITS * LEVELS)) - 1;
+
+  explicit TimerWheel(TimePoint::duration resolution = std::chrono::milliseconds(1),
+                      TimePoint start = TimePoint::clock::now());
+
+  auto insert(TimePoint when, size_t id, std::coroutine_handle<> handle) -> void;
+  auto remove(TimePoint when, size_t id) -> std::coroutine_handle<>;
+  auto popExpired(TimePoint now, std::vector<std::coroutine_handle<>>& out) -> size_t;
+  auto nextDeadline() const -> std::optional<TimePoint>;
+  auto size() const -> size_t { return mIndex.size(); }
+
+private:
+  static constexpr auto NONE = std::numeric_limits<size_t>::max();
+  static constexpr auto EXPIRED_LEVEL = LEVELS; // list of timers that are already due
+
+  struct Node {
+    TimePoint when;
+    size_t id;
+    std::coroutine_handle<> handle;
+    size_t prev;
+    size_t next;
+    uint32_t level;
+    uint32_t slot;
+  };
+  struct Expiration {
+    uint32_t level;
+    uint32_t slot;
+    uint64_t deadline;
+  };
+
+  auto deadlineTick(TimePoint when) const -> uint64_t;
+  auto nowTick(TimePoint now) const -> uint64_t;
+  auto place(size_t key) -> void;
+  auto link(size_t key, uint32_t level, uint32_t slot) -> void;
+  auto unlink(size_t key) -> void;
+  auto nextExpiration() const -> std::optional<Expiration>;
+  auto headOf(uint32_t level, uint32_t slot) -> size_t& { return mSlots[level * SLOTS + slot]; }
+
+  TimePoint::duration mResolution;
+  TimePoint mStart;
+  uint64_t mElapsed;
+  std::array<uint64_t, LEVELS> mOccupied;
+  std::array<size_t, LEVELS * SLOTS + 1> mSlots; // last one is the expired list
+  Slab<Node> mNodes;
+  std::unordered_map<size_t, size_t> mIndex; // timer id -> node key
+};
+
+static_assert(TimerStoreCpt<TimerMap>);
+static_assert(TimerStoreCpt<TimerWheel>);
+} // namespace async
@@ -1,9 +1,28 @@
 #pragma once
+#include "Async/Task.hpp"
+#include <chrono>
 #include <concepts>
 #include <coroutine>
+#include <optional>
+#include <vector>
 namespace async {
-class MultiThreadExecutor;
-class InlineExecutor;
+// anything that can run coroutines; an executor constructible from `(Reactor&, args...)` gets the runtime's reactor
+// and should install it as `Reactor::Current()` on the threads it runs coroutines on
 template <typename T>
-concept ExecutorCpt = std::is_same_v<MultiThreadExecutor, T> || std::is_same_v<InlineExecutor, T>;
-} // namespace async
\ No newline at end of file
+concept ExecutorCpt = requires(T& executor, std::coroutine_handle<> handle, Task<> task, void (*fn)()) {
+                        executor.execute(handle);
+                        executor.spawnDetach(std::move(task));
+                        executor.block(std::move(task));
+                        executor.blockSpawn(fn);
+                      };
+
+template <typename T>
+concept TimerStoreCpt = requires(T store, std::chrono::steady_clock::time_point when, size_t id,
+                                 std::coroutine_handle<> handle, std::vector<std::coroutine_handle<>>& out) {
+                          store.insert(when, id, handle);
+                          { store.remove(when, id) } -> std::same_as<std::coroutine_handle<>>;
+                          { store.popExpired(when, out) } -> std::same_as<size_t>;
+                          { store.nextDeadline() } -> std::same_as<std::optional<std::chrono::steady_clock::time_point>>;
+                          { store.size() } -> std::convertible_to<size_t>;
+                        };
+} // namespace async
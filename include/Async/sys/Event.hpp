@@ -1,15 +1,22 @@
 #pragma once
+#include "Async/utils/Metrics.hpp"
 #include "Async/utils/predefined.hpp"
 #include <atomic>
 #include <cstring>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #ifdef __linux__
   #include "Async/sys/unix/epoll.hpp"
+  #include "Async/sys/unix/uring.hpp"
 #endif
 
 namespace async {
 static constexpr auto NOTIFY_KEY = std::numeric_limits<size_t>::max();
+static constexpr auto URING_KEY = NOTIFY_KEY - 1;
+static constexpr auto TIMER_KEY = NOTIFY_KEY - 2; // poller internal deadline timer
 struct Event {
   size_t key;
   bool readable;
@@ -33,7 +40,7 @@ enum class PollMode {
 
 class Poller {
 public:
-  Poller() : mEvents(), mEventsLock(), mNotified(false)
+  explicit Poller(size_t maxEvents = impl::Events::MAX_EVENTS) : mEvents(maxEvents), mEventsLock(), mNotified(false)
   {
     auto r = impl::Poller::Create();
     if (!r.has_value()) {
@@ -69,20 +76,32 @@ public:
   {
     auto t = mEventsLock.try_lock();
     if (t) {
+      auto start = Metrics::now();
       auto r = mPoller.wait(mEvents, timeout);
+      Metrics::record(Histogram::PollWait, Metrics::since(start));
+      Metrics::count(Counter::Polls);
       if (!r) {
         mEventsLock.unlock();
         return make_unexpected(r.error());
       }
       mNotified.exchange(false);
       auto len = events.size();
+      [[maybe_unused]] auto notified = false;
       for (auto const& e : mEvents) {
-        if (e.key != NOTIFY_KEY) {
+        if (e.key != NOTIFY_KEY && e.key != TIMER_KEY) {
           events.push_back(e);
+        } else if constexpr (Metrics::ENABLED) {
+          notified = notified || e.key == NOTIFY_KEY;
         }
       }
       mEventsLock.unlock();
-      return {events.size() - len};
+      auto ready = events.size() - len;
+      Metrics::count(Counter::PollEvents, ready);
+      Metrics::record(Histogram::PollBatch, ready);
+      if (ready == 0) {
+        Metrics::count(notified ? Counter::PollNotifies : Counter::PollTimeouts);
+      }
+      return {ready};
     } else {
       // other thread is waiting, just return 0
       return {0};
@@ -103,4 +122,52 @@ private:
   std::mutex mEventsLock;
   std::atomic_bool mNotified;
 };
+
+// Completion based poller. Operations can be queued from any thread, they are
+// submitted in one batch by `flush` and completed by `reap` on the reactor thread.
+class UringPoller {
+public:
+  using Completion = impl::Completion;
+  explicit UringPoller(impl::Uring ring) : mRing(std::move(ring)), mRingLock() {}
+  ~UringPoller() = default;
+  static auto Create(unsigned entries = impl::Uring::DEFAULT_ENTRIES) -> StdResult<std::unique_ptr<UringPoller>>
+  {
+    auto r = impl::Uring::Create(entries);
+    if (!r) {
+      return make_unexpected(r.error());
+    }
+    return std::make_unique<UringPoller>(std::move(r.value()));
+  }
+
+  auto fd() const -> int { return mRing.fd(); }
+  // `prep` writes one sqe, returns true if it is the first operation of the current batch
+  template <typename PrepFn>
+  auto submit(PrepFn&& prep) -> StdResult<bool>
+  {
+    auto lk = std::scoped_lock {mRingLock};
+    auto r = prep(mRing);
+    if (!r && r.error() == std::errc::resource_unavailable_try_again) {
+      // submission ring is full, push current batch to kernel
+      if (auto s = mRing.submit(); !s) {
+        return make_unexpected(s.error());
+      }
+      r = prep(mRing);
+    }
+    if (!r) {
+      return make_unexpected(r.error());
+    }
+    return mRing.pending() == 1;
+  }
+  auto flush() -> StdResult<size_t>
+  {
+    auto lk = std::scoped_lock {mRingLock};
+    return mRing.submit();
+  }
+  // only one thread can reap at a time, reactor's event lock must be held
+  auto reap(std::vector<Completion>& completions) -> size_t { return mRing.reap(completions); }
+
+private:
+  impl::Uring mRing;
+  std::mutex mRingLock;
+};
 } // namespace async
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "Async/utils/predefined.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace async {
+// where a cpu sits, every id is the lowest cpu number sharing that level so equal ids mean shared hardware
+struct CpuInfo {
+  uint32_t cpu;
+  uint32_t core;    // SMT siblings
+  uint32_t cache;   // last level cache
+  uint32_t node;    // NUMA node
+  uint32_t package; // socket
+};
+
+class Topology {
+public:
+  // closer is smaller
+  enum Distance : uint32_t {
+    SAME_CPU,
+    SMT_SIBLING,
+    SAME_CACHE,
+    SAME_NODE,
+    SAME_PACKAGE,
+    REMOTE,
+  };
+
+  // the cpus this process may run on
+  static auto Detect() -> Topology;
+  // `cpus` as described by the sysfs cpu directory at `root`, `Detect` reads /sys/devices/system/cpu
+  static auto Parse(std::string const& root, std::vector<uint32_t> const& cpus) -> Topology;
+  // pins the calling thread
+  static auto Pin(uint32_t cpu) -> StdResult<void>;
+  static auto DistanceOf(CpuInfo const& a, CpuInfo const& b) -> Distance;
+
+  explicit Topology(std::vector<CpuInfo> cpus) : mCpus(std::move(cpus)) {}
+  [[nodiscard]] auto cpus() const -> std::vector<CpuInfo> const& { return mCpus; }
+  // one cpu per worker: a core each node by node and cache by cache, SMT siblings only once every core has a
+  // worker; wraps around when there are more workers than cpus
+  [[nodiscard]] auto place(size_t workers) const -> std::vector<CpuInfo>;
+  // for every worker of `placement`, the others ordered by distance, ties in ring order
+  static auto StealOrder(std::vector<CpuInfo> const& placement) -> std::vector<std::vector<uint32_t>>;
+
+private:
+  std::vector<CpuInfo> mCpus;
+};
+} // namespace async
@@ -10,11 +10,19 @@ enum class PollMode;
 
 namespace impl {
 struct Events {
-  static constexpr auto MAX_EVENTS = 1024;
+#ifdef ASYNC_MAX_EVENTS
+  static constexpr size_t MAX_EVENTS = ASYNC_MAX_EVENTS;
+#else
+  static constexpr size_t MAX_EVENTS = 1024;
+#endif
   std::unique_ptr<struct epoll_event[]> data;
   size_t len;
+  size_t capacity; // events returned by one wait at most
 
-  Events() : data(new struct epoll_event[MAX_EVENTS]), len(MAX_EVENTS) {}
+  explicit Events(size_t capacity = MAX_EVENTS)
+      : data(new struct epoll_event[capacity]), len(0), capacity(capacity)
+  {
+  }
 
   struct Iterator {
     Iterator(struct epoll_event* ptr) : mPtr(ptr) {}
@@ -56,8 +64,7 @@ struct Events {
 class Poller {
 public:
   static auto Create() -> StdResult<Poller>;
-  Poller() : mEpollFd(-1), mEventFd(-1), mTimerFd(-1) {}
-  Poller(int epollFd, int eventFd, int timerFd) : mEpollFd(epollFd), mEventFd(eventFd), mTimerFd(timerFd) {}
+  Poller() = default;
   ~Poller();
   Poller(Poller const&) = delete;
   Poller(Poller&&);
@@ -71,13 +78,20 @@ public:
   auto mod(int fd, Event ev, PollMode mode) -> StdResult<void>;
   auto del(int fd) -> StdResult<void>;
 
+  // the eventfd and timerfd are drained only when they show up in `events`, they are never reported
   auto wait(Events& events, std::optional<std::chrono::nanoseconds> timeout) -> StdResult<void>;
   auto notify() -> StdResult<void>;
 
 private:
-  int mEpollFd;
-  int mEventFd;
-  int mTimerFd;
+  // sub-millisecond deadlines without epoll_pwait2 (before 5.11): the timerfd is only re-armed when the deadline
+  // moves earlier or the armed one passed
+  auto armTimer(std::chrono::nanoseconds timeout) -> StdResult<void>;
+  auto drain(Events& events) -> void;
+
+  int mEpollFd = -1;
+  int mEventFd = -1;
+  int mTimerFd = -1; // only without epoll_pwait2
+  std::chrono::steady_clock::time_point mArmed {}; // timerfd deadline, epoch when disarmed
 };
 } // namespace impl
 } // namespace async
@@ -0,0 +1,77 @@
+#pragma once
+#ifdef __linux__
+  #include "Async/utils/predefined.hpp"
+  #include <linux/io_uring.h>
+  #include <span>
+  #include <sys/socket.h>
+  #include <vector>
+namespace async {
+namespace impl {
+struct Completion {
+  uint64_t userData;
+  int32_t result;
+  uint32_t flags;
+};
+
+class Uring {
+public:
+  static constexpr auto DEFAULT_ENTRIES = 256u;
+  // offset for streams and files that should use (and advance) the current file position
+  static constexpr auto CURRENT_POSITION = ~uint64_t {0};
+  static auto Create(unsigned entries = DEFAULT_ENTRIES) -> StdResult<Uring>;
+  Uring() = default;
+  ~Uring();
+  Uring(Uring const&) = delete;
+  Uring(Uring&&);
+  Uring& operator=(Uring const&) = delete;
+  Uring& operator=(Uring&&);
+
+  auto fd() const -> int { return mRingFd; }
+  // number of sqes written since the last submit
+  auto pending() const -> unsigned { return mPending; }
+
+  // every prep function returns `resource_unavailable_try_again` when the submission ring is full
+  auto read(int fd, std::span<std::byte> buf, uint64_t offset, uint64_t userData) -> StdResult<void>;
+  auto write(int fd, std::span<std::byte const> buf, uint64_t offset, uint64_t userData) -> StdResult<void>;
+  auto accept(int fd, sockaddr* addr, socklen_t* len, int flags, uint64_t userData) -> StdResult<void>;
+  auto connect(int fd, sockaddr const* addr, socklen_t len, uint64_t userData) -> StdResult<void>;
+  // recv into a buffer the kernel takes from provided buffer group `group`, its id comes back in the cqe flags
+  auto recv(int fd, uint16_t group, int flags, uint64_t userData) -> StdResult<void>;
+  // hand `count` buffers of `len` bytes from `addr` on to the kernel as `group`, with ids from `bid` on (5.7+)
+  auto provideBuffers(void* addr, uint32_t len, uint32_t count, uint16_t group, uint16_t bid, uint64_t userData)
+      -> StdResult<void>;
+  auto removeBuffers(uint32_t count, uint16_t group, uint64_t userData) -> StdResult<void>;
+
+  // one io_uring_enter for every sqe written since the last submit
+  auto submit() -> StdResult<size_t>;
+  // append all available cqes to `out`, never blocks
+  auto reap(std::vector<Completion>& out) -> size_t;
+
+private:
+  auto getSqe() -> io_uring_sqe*;
+  auto pushSqe() -> void;
+
+  int mRingFd {-1};
+  unsigned mPending {0};
+
+  void* mSqRing {nullptr};
+  size_t mSqRingSize {0};
+  void* mCqRing {nullptr};
+  size_t mCqRingSize {0};
+  io_uring_sqe* mSqes {nullptr};
+  size_t mSqesSize {0};
+
+  unsigned* mSqHead {nullptr};
+  unsigned* mSqTail {nullptr};
+  unsigned* mSqMask {nullptr};
+  unsigned* mSqArray {nullptr};
+  unsigned mSqEntries {0};
+
+  unsigned* mCqHead {nullptr};
+  unsigned* mCqTail {nullptr};
+  unsigned* mCqMask {nullptr};
+  io_uring_cqe* mCqes {nullptr};
+};
+} // namespace impl
+} // namespace async
+#endif
@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace async {
+struct FrameStats {
+  static constexpr std::size_t HISTOGRAM_STEP = 32;
+  static constexpr std::size_t HISTOGRAM_BUCKETS = 64; // [0, 32), [32, 64) ... the last one is everything above
+
+  std::array<std::size_t, HISTOGRAM_BUCKETS> sizes {}; // requested frame sizes
+  std::size_t allocations = 0;
+  std::size_t reused = 0;    // served from a free list
+  std::size_t oversized = 0; // larger than the biggest class, went to the global allocator
+  std::size_t largest = 0;
+};
+
+// Recycles coroutine frames through per-thread size-class free lists. A frame freed on another thread than the one
+// that allocated it simply joins the freeing thread's list, every block is a plain global allocation of its class
+// size so it may be released from anywhere.
+class FrameAllocator {
+public:
+  static constexpr std::array<std::size_t, 11> CLASSES {64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+  static constexpr std::size_t MAX_CACHED = 1024; // per class and thread, the rest goes back to the global allocator
+
+  static auto allocate(std::size_t size) -> void*
+  {
+    auto index = classOf(size);
+    if (tDead) {
+      return ::operator new(index < CLASSES.size() ? CLASSES[index] : size);
+    }
+    auto& cache = tCache;
+    cache.record(size, index);
+    if (index == CLASSES.size()) {
+      return ::operator new(size);
+    }
+    auto& list = cache.lists[index];
+    if (list.head != nullptr) {
+      auto block = list.head;
+      list.head = block->next;
+      list.len -= 1;
+      bump(cache.reused);
+      return block;
+    }
+    return ::operator new(CLASSES[index]);
+  }
+
+  static auto deallocate(void* ptr, std::size_t size) noexcept -> void
+  {
+    auto index = classOf(size);
+    if (index == CLASSES.size() || tDead) {
+      ::operator delete(ptr);
+      return;
+    }
+    auto& list = tCache.lists[index];
+    if (list.len >= MAX_CACHED) {
+      ::operator delete(ptr);
+      return;
+    }
+    list.head = ::new (ptr) Block {list.head};
+    list.len += 1;
+  }
+
+  // summed over every live thread and the ones that already exited
+  static auto stats() -> FrameStats;
+
+private:
+  using Counter = std::atomic_size_t;
+  struct Block {
+    Block* next;
+  };
+  struct FreeList {
+    Block* head = nullptr;
+    std::size_t len = 0;
+  };
+  struct ThreadCache {
+    ThreadCache();
+    ~ThreadCache();
+    auto record(std::size_t size, std::size_t index) -> void
+    {
+      bump(sizes[size / FrameStats::HISTOGRAM_STEP < sizes.size() ? size / FrameStats::HISTOGRAM_STEP
+                                                                    : sizes.size() - 1]);
+      bump(allocations);
+      if (index == CLASSES.size()) {
+        bump(oversized);
+      }
+      if (size > largest.load(std::memory_order_relaxed)) {
+        largest.store(size, std::memory_order_relaxed);
+      }
+    }
+    auto collect(FrameStats& out) const -> void;
+
+    std::array<FreeList, CLASSES.size()> lists {};
+    // only written by the owning thread, `stats()` reads them from others
+    std::array<Counter, FrameStats::HISTOGRAM_BUCKETS> sizes {};
+    Counter allocations {0};
+    Counter reused {0};
+    Counter oversized {0};
+    Counter largest {0};
+  };
+
+  static auto classOf(std::size_t size) -> std::size_t
+  {
+    auto index = std::size_t {0};
+    while (index < CLASSES.size() && CLASSES[index] < size) {
+      ++index;
+    }
+    return index;
+  }
+  static auto bump(Counter& counter) -> void
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  static inline thread_local ThreadCache tCache;
+  // set once tCache is destroyed, frames released during thread teardown bypass the lists
+  static inline thread_local bool tDead = false;
+};
+
+// Base of every promise type. With ASYNC_FRAME_POOL the coroutine frames are taken from `FrameAllocator`.
+struct PooledFrame {
+#ifdef ASYNC_FRAME_POOL
+  static auto operator new(std::size_t size) -> void* { return FrameAllocator::allocate(size); }
+  static auto operator delete(void* ptr, std::size_t size) noexcept -> void { FrameAllocator::deallocate(ptr, size); }
+#endif
+};
+} // namespace async
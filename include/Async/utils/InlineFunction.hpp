@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace async {
+template <typename Sig, std::size_t Size = 4 * sizeof(void*)>
+class InlineFunction;
+
+// move-only std::function replacement that never allocates, the callable must fit in `Size` bytes
+template <typename R, typename... Args, std::size_t Size>
+class InlineFunction<R(Args...), Size> {
+public:
+  InlineFunction() noexcept = default;
+  InlineFunction(std::nullptr_t) noexcept {}
+  template <typename Fn>
+    requires(!std::is_same_v<std::remove_cvref_t<Fn>, InlineFunction> && std::is_invocable_r_v<R, Fn&, Args...>)
+  InlineFunction(Fn&& fn)
+  {
+    using Callable = std::remove_cvref_t<Fn>;
+    static_assert(sizeof(Callable) <= Size, "callable too large for InlineFunction, capture less or a pointer");
+    static_assert(alignof(Callable) <= alignof(std::max_align_t));
+    static_assert(std::is_nothrow_move_constructible_v<Callable>);
+    ::new (static_cast<void*>(mStorage)) Callable(std::forward<Fn>(fn));
+    mInvoke = [](void* self, Args&&... args) -> R {
+      return (*static_cast<Callable*>(self))(std::forward<Args>(args)...);
+    };
+    mManage = [](void* dst, void* src) noexcept {
+      auto from = static_cast<Callable*>(src);
+      if (dst != nullptr) {
+        ::new (dst) Callable(std::move(*from));
+      }
+      from->~Callable();
+    };
+  }
+  InlineFunction(InlineFunction&& other) noexcept { moveFrom(other); }
+  InlineFunction& operator=(InlineFunction&& other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      moveFrom(other);
+    }
+    return *this;
+  }
+  InlineFunction(InlineFunction const&) = delete;
+  InlineFunction& operator=(InlineFunction const&) = delete;
+  ~InlineFunction() { reset(); }
+
+  explicit operator bool() const noexcept { return mInvoke != nullptr; }
+  auto operator()(Args... args) -> R { return mInvoke(mStorage, std::forward<Args>(args)...); }
+
+private:
+  auto reset() noexcept -> void
+  {
+    if (mManage != nullptr) {
+      mManage(nullptr, mStorage);
+    }
+    mInvoke = nullptr;
+    mManage = nullptr;
+  }
+  auto moveFrom(InlineFunction& other) noexcept -> void
+  {
+    if (other.mManage != nullptr) {
+      other.mManage(mStorage, other.mStorage);
+    }
+    mInvoke = std::exchange(other.mInvoke, nullptr);
+    mManage = std::exchange(other.mManage, nullptr);
+  }
+
+  alignas(std::max_align_t) std::byte mStorage[Size];
+  R (*mInvoke)(void*, Args&&...) = nullptr;
+  void (*mManage)(void* dst, void* src) noexcept = nullptr; // move into `dst` (when not null) and destroy `src`
+};
+} // namespace async
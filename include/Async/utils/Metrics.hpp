@@ -0,0 +1,249 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace async {
+enum class Counter : std::size_t {
+  Tasks,           // handles resumed by a pool worker
+  LifoHits,        // taken from the worker's LIFO slot
+  LocalPops,       // taken from the worker's own deques
+  InjectorTakes,   // taken from the injectors
+  Steals,          // taken from another worker
+  StealAttempts,   // victims looked at, successful or not
+  Injected,        // handles queued from outside the pool
+  Spilled,         // injections that found the bounded injector full
+  Parks,
+  SpuriousWakeups, // parked again without having found anything since the last wakeup
+  Unparks,         // wakeups sent to parked workers
+  Polls,           // poller waits
+  PollEvents,      // readiness events returned by them
+  PollTimeouts,    // waits that returned without any event
+  PollNotifies,    // waits only woken through the notify eventfd
+  Completions,     // io_uring completions reaped
+  TimersInserted,
+  TimersFired,
+  TimersCancelled,
+  COUNT,
+};
+
+enum class Histogram : std::size_t {
+  ScheduleDelay, // ns from `execute` to `resume`, sampled: one handle per lane is timed at a time
+  TaskPoll,      // ns a worker spent in one `resume`
+  PollWait,      // ns spent in one poller wait, blocking included
+  PollBatch,     // readiness events returned by one wait
+  QueueDepth,    // a worker's deque length after it pushed onto it
+  InjectorDepth, // the injector length when a handle is injected
+  COUNT,
+};
+
+inline constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(Counter::COUNT);
+inline constexpr std::size_t HISTOGRAM_COUNT = static_cast<std::size_t>(Histogram::COUNT);
+
+inline constexpr std::array<std::string_view, COUNTER_COUNT> COUNTER_NAMES {
+    "tasks",       "lifo_hits",     "local_pops",    "injector_takes", "steals",          "steal_attempts",
+    "injected",    "spilled",       "parks",         "spurious_wakeups", "unparks",       "polls",
+    "poll_events", "poll_timeouts", "poll_notifies", "completions",    "timers_inserted", "timers_fired",
+    "timers_cancelled",
+};
+inline constexpr std::array<std::string_view, HISTOGRAM_COUNT> HISTOGRAM_NAMES {
+    "schedule_delay_ns", "task_poll_ns", "poll_wait_ns", "poll_batch", "queue_depth", "injector_depth",
+};
+
+// Log-linear buckets like an HDR histogram: values below SUB are exact, every power of two above is split into SUB
+// buckets, so a value is off by at most 1/SUB of itself.
+struct HistogramSnapshot {
+  static constexpr std::size_t SUB_BITS = 3;
+  static constexpr std::size_t SUB = std::size_t {1} << SUB_BITS;
+  static constexpr std::size_t MAX_BITS = 40; // from 2^40 (18 minutes in ns) on everything is in the last bucket
+  static constexpr std::size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB;
+
+  std::array<std::uint64_t, BUCKETS> counts {};
+  std::uint64_t count = 0;
+  std::uint64_t sum = 0;
+  std::uint64_t max = 0;
+
+  static constexpr auto BucketOf(std::uint64_t value) -> std::size_t
+  {
+    if (value < SUB) {
+      return static_cast<std::size_t>(value);
+    }
+    auto msb = static_cast<std::size_t>(std::bit_width(value)) - 1;
+    if (msb >= MAX_BITS) {
+      return BUCKETS - 1;
+    }
+    return (msb - SUB_BITS + 1) * SUB + static_cast<std::size_t>((value >> (msb - SUB_BITS)) & (SUB - 1));
+  }
+  // smallest value that lands in `bucket`
+  static constexpr auto LowerBound(std::size_t bucket) -> std::uint64_t
+  {
+    if (bucket < SUB) {
+      return bucket;
+    }
+    auto shift = bucket / SUB - 1;
+    return (SUB + bucket % SUB) << shift;
+  }
+
+  // upper end of the bucket holding the `q`-quantile, never above the largest recorded value
+  [[nodiscard]] auto percentile(double q) const -> std::uint64_t
+  {
+    if (count == 0) {
+      return 0;
+    }
+    auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    auto seen = std::uint64_t {0};
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if (seen >= rank) {
+        return i + 1 < BUCKETS ? std::min(LowerBound(i + 1) - 1, max) : max;
+      }
+    }
+    return max;
+  }
+  [[nodiscard]] auto mean() const -> double
+  {
+    return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+  }
+  auto merge(HistogramSnapshot const& other) -> void
+  {
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+      counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+  }
+};
+
+struct ThreadMetrics {
+  std::size_t thread = 0;                // the order threads first recorded something in
+  std::optional<std::size_t> worker {};  // index of the StealingThreadPool worker it is
+  std::array<std::uint64_t, COUNTER_COUNT> counters {};
+  std::array<HistogramSnapshot, HISTOGRAM_COUNT> histograms {};
+
+  auto operator[](Counter counter) const -> std::uint64_t { return counters[static_cast<std::size_t>(counter)]; }
+  auto operator[](Histogram histogram) const -> HistogramSnapshot const&
+  {
+    return histograms[static_cast<std::size_t>(histogram)];
+  }
+  auto merge(ThreadMetrics const& other) -> void
+  {
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+      counters[i] += other.counters[i];
+    }
+    for (std::size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+      histograms[i].merge(other.histograms[i]);
+    }
+  }
+};
+
+struct MetricsSnapshot {
+  std::vector<ThreadMetrics> threads; // live threads
+  ThreadMetrics total;                // live and exited threads
+
+  // Prometheus text format, counters per worker and a summary per histogram over all threads
+  [[nodiscard]] auto toPrometheus(std::string_view prefix = "async_") const -> std::string;
+};
+
+// Runtime counters, compiled in with ASYNC_METRICS and otherwise empty inline functions. Every thread records into
+// its own cache line padded block with relaxed stores, `snapshot()` is the only place that reads them all.
+class Metrics {
+public:
+#ifdef ASYNC_METRICS
+  static constexpr bool ENABLED = true;
+  using Stamp = std::chrono::steady_clock::time_point;
+#else
+  static constexpr bool ENABLED = false;
+  struct Stamp {};
+#endif
+
+  // empty without ASYNC_METRICS
+  static auto snapshot() -> MetricsSnapshot;
+
+  static auto count([[maybe_unused]] Counter counter, [[maybe_unused]] std::uint64_t n = 1) noexcept -> void
+  {
+#ifdef ASYNC_METRICS
+    bump(tLocal.counters[static_cast<std::size_t>(counter)], n);
+#endif
+  }
+  static auto record([[maybe_unused]] Histogram histogram, [[maybe_unused]] std::uint64_t value) noexcept -> void
+  {
+#ifdef ASYNC_METRICS
+    tLocal.histograms[static_cast<std::size_t>(histogram)].record(value);
+#endif
+  }
+  // labels the calling thread's block as pool worker `id`
+  static auto setWorker([[maybe_unused]] std::optional<std::size_t> id) noexcept -> void
+  {
+#ifdef ASYNC_METRICS
+    tLocal.worker.store(id ? static_cast<std::int64_t>(*id) : -1, std::memory_order_relaxed);
+#endif
+  }
+  // a clock read only when metrics are compiled in
+  static auto now() noexcept -> Stamp
+  {
+#ifdef ASYNC_METRICS
+    return std::chrono::steady_clock::now();
+#else
+    return {};
+#endif
+  }
+  static auto since([[maybe_unused]] Stamp start) noexcept -> std::uint64_t
+  {
+#ifdef ASYNC_METRICS
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+#else
+    return 0;
+#endif
+  }
+
+#ifdef ASYNC_METRICS
+private:
+  using Cell = std::atomic_uint64_t;
+  struct LiveHistogram {
+    std::array<Cell, HistogramSnapshot::BUCKETS> counts {};
+    Cell count {0};
+    Cell sum {0};
+    Cell max {0};
+
+    auto record(std::uint64_t value) noexcept -> void
+    {
+      bump(counts[HistogramSnapshot::BucketOf(value)], 1);
+      bump(count, 1);
+      bump(sum, value);
+      if (value > max.load(std::memory_order_relaxed)) {
+        max.store(value, std::memory_order_relaxed);
+      }
+    }
+    auto collect(HistogramSnapshot& out) const -> void;
+  };
+  // only written by the owning thread
+  struct alignas(64) ThreadBlock {
+    ThreadBlock();
+    ~ThreadBlock();
+    auto collect(ThreadMetrics& out) const -> void;
+
+    std::size_t thread = 0;
+    std::atomic_int64_t worker {-1};
+    std::array<Cell, COUNTER_COUNT> counters {};
+    std::array<LiveHistogram, HISTOGRAM_COUNT> histograms {};
+  };
+
+  static auto bump(Cell& cell, std::uint64_t n) noexcept -> void
+  {
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  static inline thread_local ThreadBlock tLocal;
+#endif
+};
+} // namespace async
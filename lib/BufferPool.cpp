@@ -0,0 +1,127 @@
+#include "Async/BufferPool.hpp"
+#include <algorithm>
+#include <new>
+
+namespace async {
+static constexpr auto CHUNK_ALIGN = std::align_val_t {4096};
+
+BufferPool::BufferPool(size_t bufferSize, size_t maxBuffers)
+    : mBufferSize((std::max<size_t>(bufferSize, 1) + 63) & ~size_t {63}),
+      mMaxBuffers(static_cast<uint32_t>(
+          std::min<size_t>((std::max<size_t>(maxBuffers, 1) + CHUNK_BUFFERS - 1) / CHUNK_BUFFERS * CHUNK_BUFFERS,
+                           NONE / CHUNK_BUFFERS * CHUNK_BUFFERS))),
+      mChunks(std::make_unique<std::atomic<Chunk*>[]>(mMaxBuffers / CHUNK_BUFFERS))
+{
+}
+
+BufferPool::~BufferPool()
+{
+  assert(inUse() == 0 && "every buffer must be back before the pool goes");
+  if (mProvided != nullptr) {
+    // no recv takes from the group anymore, the kernel drops its pointers into the chunks
+    auto count = static_cast<uint32_t>(mProvided->ids.size());
+    auto group = mProvided->group;
+    (void)mProvided->reactor->submitDetached(
+        [=](impl::Uring& ring, uint64_t data) { return ring.removeBuffers(count, group, data); });
+  }
+  for (size_t i = 0; i < mMaxBuffers / CHUNK_BUFFERS; ++i) {
+    if (auto chunk = mChunks[i].load(std::memory_order_relaxed)) {
+      ::operator delete(chunk->memory, CHUNK_ALIGN);
+      delete chunk;
+    }
+  }
+}
+
+auto BufferPool::chunkAt(uint32_t id) -> Chunk&
+{
+  auto& entry = mChunks[id / CHUNK_BUFFERS];
+  auto chunk = entry.load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    auto fresh = new Chunk();
+    fresh->memory = static_cast<std::byte*>(::operator new(CHUNK_BUFFERS * mBufferSize, CHUNK_ALIGN));
+    if (entry.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+      chunk = fresh;
+      mChunkCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      ::operator delete(fresh->memory, CHUNK_ALIGN);
+      delete fresh;
+    }
+  }
+  return *chunk;
+}
+
+auto BufferPool::provide(Reactor& reactor, size_t count) -> Task<StdResult<void>>
+{
+  if (mProvided != nullptr) {
+    co_return make_unexpected(std::errc::device_or_resource_busy);
+  }
+  if (!reactor.supportCompletion()) {
+    co_return make_unexpected(std::errc::function_not_supported);
+  }
+  count = std::min({count, MAX_PROVIDED, size_t {mMaxBuffers}});
+  if (count == 0) {
+    co_return make_unexpected(std::errc::invalid_argument);
+  }
+  auto provided = std::make_unique<Provided>();
+  provided->reactor = &reactor;
+  provided->group = reactor.newBufferGroup();
+  for (size_t bid = 0; bid < count; ++bid) {
+    auto id = pop();
+    if (id == NONE) {
+      break;
+    }
+    provided->ids.push_back(id);
+  }
+  // one submission per run of neighbouring buffers, fresh ones come in whole chunks
+  auto& ids = provided->ids;
+  for (size_t start = 0, end = 0; start < ids.size(); start = end) {
+    end = start + 1;
+    while (end < ids.size() && ids[end] == ids[end - 1] + 1 && ids[end] % CHUNK_BUFFERS != 0) {
+      ++end;
+    }
+    auto r = co_await reactor.provideBuffers(dataOf(ids[start]), static_cast<uint32_t>(mBufferSize),
+                                             static_cast<uint32_t>(end - start), provided->group,
+                                             static_cast<uint16_t>(start));
+    if (!r) {
+      if (start != 0) {
+        (void)reactor.submitDetached([count = static_cast<uint32_t>(start), group = provided->group](
+                                         impl::Uring& ring, uint64_t data) {
+          return ring.removeBuffers(count, group, data);
+        });
+      }
+      for (auto id : ids) {
+        push(id);
+      }
+      co_return make_unexpected(r.error());
+    }
+  }
+  if (ids.empty()) {
+    co_return make_unexpected(std::errc::no_buffer_space);
+  }
+  mProvided = std::move(provided);
+  co_return {};
+}
+
+auto BufferPool::fromCompletion(uint32_t flags, size_t size) noexcept -> PooledBuffer
+{
+  if (mProvided == nullptr || (flags & IORING_CQE_F_BUFFER) == 0) {
+    return {};
+  }
+  auto bid = flags >> IORING_CQE_BUFFER_SHIFT;
+  assert(bid < mProvided->ids.size());
+  auto out = wrap(mProvided->ids[bid], static_cast<int32_t>(bid));
+  out.setSize(size);
+  return out;
+}
+
+auto BufferPool::reprovide(uint16_t bid) noexcept -> bool
+{
+  auto& provided = *mProvided;
+  auto addr = dataOf(provided.ids[bid]);
+  auto len = static_cast<uint32_t>(mBufferSize);
+  auto group = provided.group;
+  auto r = provided.reactor->submitDetached(
+      [=](impl::Uring& ring, uint64_t data) { return ring.provideBuffers(addr, len, 1, group, bid, data); });
+  return r.has_value();
+}
+} // namespace async
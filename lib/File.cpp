@@ -0,0 +1,30 @@
+#include "Async/File.hpp"
+#include <sys/stat.h>
+
+namespace async {
+auto File::Open(Reactor& reactor, std::string const& path, int flags, mode_t mode) -> StdResult<File>
+{
+  auto fd = SysCall(::open, path.c_str(), flags | O_CLOEXEC, mode);
+  if (!fd) {
+    return make_unexpected(fd.error());
+  }
+  return File {reactor, fd.value()};
+}
+
+auto File::size() const -> StdResult<size_t>
+{
+  struct stat st;
+  if (auto r = SysCall(::fstat, mFd, &st); !r) {
+    return make_unexpected(r.error());
+  }
+  return static_cast<size_t>(st.st_size);
+}
+
+auto File::close() -> void
+{
+  if (mFd != -1) {
+    ::close(mFd);
+    mFd = -1;
+  }
+}
+} // namespace async
@@ -0,0 +1,37 @@
+#include "Async/Io.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace async {
+auto IoHandle::Create(Reactor& reactor, int fd, PollMode mode) -> StdResult<IoHandle>
+{
+  auto flags = SysCall(::fcntl, fd, F_GETFL);
+  if (!flags) {
+    return make_unexpected(flags.error());
+  }
+  if ((flags.value() & O_NONBLOCK) == 0) {
+    if (auto r = SysCall(::fcntl, fd, F_SETFL, flags.value() | O_NONBLOCK); !r) {
+      return make_unexpected(r.error());
+    }
+  }
+  auto source = reactor.insertIo(fd, mode);
+  if (!source) {
+    return make_unexpected(source.error());
+  }
+  return IoHandle {reactor, source.value(), fd};
+}
+
+auto IoHandle::close() -> void
+{
+  if (mFd == -1) {
+    return;
+  }
+  if (mSource != nullptr) {
+    [[maybe_unused]] auto r = mReactor->removeIo(*mSource);
+    assert(r && "remove io failed");
+    mSource = nullptr;
+  }
+  ::close(mFd);
+  mFd = -1;
+}
+} // namespace async
@@ -0,0 +1,452 @@
+#include "Async/Net.hpp"
+#include <arpa/inet.h>
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+namespace async {
+SocketAddr::SocketAddr(sockaddr const* addr, socklen_t len) : mStorage(), mLen(len)
+{
+  assert(len <= capacity());
+  std::memcpy(&mStorage, addr, len);
+}
+
+auto SocketAddr::V4(uint32_t ip, uint16_t port) -> SocketAddr
+{
+  auto addr = sockaddr_in {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(ip);
+  return SocketAddr {reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)};
+}
+
+auto SocketAddr::V6(in6_addr const& ip, uint16_t port) -> SocketAddr
+{
+  auto addr = sockaddr_in6 {};
+  addr.sin6_family = AF_INET6;
+  addr.sin6_port = htons(port);
+  addr.sin6_addr = ip;
+  return SocketAddr {reinterpret_cast<sockaddr const*>(&addr), sizeof(addr)};
+}
+
+auto SocketAddr::Parse(std::string_view addr) -> StdResult<SocketAddr>
+{
+  auto colon = addr.rfind(':');
+  if (colon == std::string_view::npos) {
+    return make_unexpected(std::errc::invalid_argument);
+  }
+  auto host = std::string(addr.substr(0, colon));
+  auto portStr = addr.substr(colon + 1);
+  auto port = uint16_t {0};
+  if (auto [ptr, ec] = std::from_chars(portStr.data(), portStr.data() + portStr.size(), port);
+      ec != std::errc {} || ptr != portStr.data() + portStr.size()) {
+    return make_unexpected(std::errc::invalid_argument);
+  }
+
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']') {
+    host = host.substr(1, host.size() - 2);
+    auto ip = in6_addr {};
+    if (::inet_pton(AF_INET6, host.c_str(), &ip) != 1) {
+      return make_unexpected(std::errc::invalid_argument);
+    }
+    return V6(ip, port);
+  }
+  auto ip = in_addr {};
+  if (::inet_pton(AF_INET, host.c_str(), &ip) != 1) {
+    return make_unexpected(std::errc::invalid_argument);
+  }
+  return V4(ntohl(ip.s_addr), port);
+}
+
+auto SocketAddr::port() const -> uint16_t
+{
+  if (family() == AF_INET) {
+    return ntohs(reinterpret_cast<sockaddr_in const*>(&mStorage)->sin_port);
+  } else if (family() == AF_INET6) {
+    return ntohs(reinterpret_cast<sockaddr_in6 const*>(&mStorage)->sin6_port);
+  }
+  return 0;
+}
+
+auto SocketAddr::toString() const -> std::string
+{
+  char buf[INET6_ADDRSTRLEN] = {};
+  if (family() == AF_INET) {
+    ::inet_ntop(AF_INET, &reinterpret_cast<sockaddr_in const*>(&mStorage)->sin_addr, buf, sizeof(buf));
+    return std::string(buf) + ":" + std::to_string(port());
+  } else if (family() == AF_INET6) {
+    ::inet_ntop(AF_INET6, &reinterpret_cast<sockaddr_in6 const*>(&mStorage)->sin6_addr, buf, sizeof(buf));
+    // appended piecewise, `"[" + std::string` trips a false -Wrestrict in GCC 12 Release builds
+    auto out = std::string {"["};
+    out.append(buf).append("]:").append(std::to_string(port()));
+    return out;
+  }
+  return {};
+}
+
+static auto CreateSocket(int family, int type) -> StdResult<int>
+{
+  return SysCall(::socket, family, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+}
+
+static auto GetName(int fd, bool peer) -> StdResult<SocketAddr>
+{
+  auto addr = SocketAddr {};
+  addr.len() = SocketAddr::capacity();
+  auto r = peer ? SysCall(::getpeername, fd, addr.data(), &addr.len())
+                : SysCall(::getsockname, fd, addr.data(), &addr.len());
+  if (!r) {
+    return make_unexpected(r.error());
+  }
+  return addr;
+}
+
+// wrap a fresh socket, close it when registration fails
+static auto Register(Reactor& reactor, int fd) -> StdResult<IoHandle>
+{
+  auto io = IoHandle::Create(reactor, fd);
+  if (!io) {
+    ::close(fd);
+  }
+  return io;
+}
+
+auto TcpStream::FromFd(Reactor& reactor, int fd) -> StdResult<TcpStream>
+{
+  auto io = Register(reactor, fd);
+  if (!io) {
+    return make_unexpected(io.error());
+  }
+  return TcpStream {std::move(io.value())};
+}
+
+auto TcpStream::Connect(Reactor& reactor, SocketAddr addr) -> Task<StdResult<TcpStream>>
+{
+  auto fd = CreateSocket(addr.family(), SOCK_STREAM);
+  if (!fd) {
+    co_return make_unexpected(fd.error());
+  }
+  auto stream = FromFd(reactor, fd.value());
+  if (!stream) {
+    co_return make_unexpected(stream.error());
+  }
+  if (auto r = SysCall(::connect, stream->fd(), addr.data(), addr.len()); !r) {
+    if (r.error() != std::errc::operation_in_progress) {
+      co_return make_unexpected(r.error());
+    }
+    if (auto w = co_await stream->mIo.writable(); !w) {
+      co_return make_unexpected(w.error());
+    }
+    auto error = 0;
+    auto len = socklen_t {sizeof(error)};
+    if (auto r = SysCall(::getsockopt, stream->fd(), SOL_SOCKET, SO_ERROR, &error, &len); !r) {
+      co_return make_unexpected(r.error());
+    }
+    if (error != 0) {
+      co_return make_unexpected(std::errc(error));
+    }
+  }
+  co_return std::move(stream);
+}
+
+auto TcpStream::read(BufferPool& pool) -> Task<StdResult<PooledBuffer>>
+{
+  auto& reactor = mIo.reactor();
+  if (auto group = pool.providedGroup(reactor)) {
+    auto r = co_await reactor.recv(mIo.fd(), *group);
+    if (r) {
+      auto buf = pool.fromCompletion(r->flags, static_cast<size_t>(r->result));
+      co_return r->result == 0 ? PooledBuffer {} : std::move(buf);
+    }
+    if (r.error() != std::errc::no_buffer_space) {
+      co_return make_unexpected(r.error());
+    }
+    // every provided buffer is taken, borrow from the free list
+  }
+  while (true) {
+    auto buf = pool.tryAcquire();
+    if (!buf) {
+      if (auto ready = co_await mIo.readable(); !ready) {
+        co_return make_unexpected(ready.error());
+      }
+      buf = co_await pool.acquire();
+    }
+    auto n = SysCall(::recv, mIo.fd(), buf.data(), buf.capacity(), 0);
+    if (n) {
+      if (n.value() == 0) {
+        co_return PooledBuffer {};
+      }
+      buf.setSize(static_cast<size_t>(n.value()));
+      co_return std::move(buf);
+    }
+    if (n.error() != std::errc::resource_unavailable_try_again) {
+      co_return make_unexpected(n.error());
+    }
+    // nothing there, wait without holding the buffer
+    buf.release();
+    if (auto ready = co_await mIo.readable(); !ready) {
+      co_return make_unexpected(ready.error());
+    }
+  }
+}
+
+auto TcpStream::writeAll(std::span<std::byte const> buf) -> Task<StdResult<void>>
+{
+  while (!buf.empty()) {
+    auto n = co_await write(buf);
+    if (!n) {
+      co_return make_unexpected(n.error());
+    }
+    buf = buf.subspan(n.value());
+  }
+  co_return {};
+}
+
+auto TcpStream::writevAll(std::span<iovec> bufs) -> Task<StdResult<void>>
+{
+  // drop what went out, empty buffers included
+  auto advance = [&bufs](size_t n) {
+    while (!bufs.empty() && bufs.front().iov_len <= n) {
+      n -= bufs.front().iov_len;
+      bufs = bufs.subspan(1);
+    }
+    if (!bufs.empty()) {
+      bufs.front().iov_base = static_cast<std::byte*>(bufs.front().iov_base) + n;
+      bufs.front().iov_len -= n;
+    }
+  };
+  advance(0);
+  while (!bufs.empty()) {
+    auto n = co_await writev(bufs.first(std::min<size_t>(bufs.size(), IOV_MAX)));
+    if (!n) {
+      co_return make_unexpected(n.error());
+    }
+    advance(n.value());
+  }
+  co_return {};
+}
+
+auto TcpStream::SendFile(int out, int fd, uint64_t offset, size_t count) -> StdResult<size_t>
+{
+  auto position = static_cast<off_t>(offset);
+  return SysCall(::sendfile, out, fd, &position, count).map([](auto n) { return static_cast<size_t>(n); });
+}
+
+auto TcpStream::sendFileAll(int fd, uint64_t offset, size_t count) -> Task<StdResult<size_t>>
+{
+  auto sent = size_t {0};
+  while (sent < count) {
+    auto n = co_await sendFile(fd, offset + sent, count - sent);
+    if (!n) {
+      co_return make_unexpected(n.error());
+    }
+    if (n.value() == 0) {
+      break;
+    }
+    sent += n.value();
+  }
+  co_return sent;
+}
+
+auto TcpStream::spliceFrom(int fd, uint64_t offset, size_t count) -> Task<StdResult<size_t>>
+{
+  struct Pipe {
+    int fds[2] = {-1, -1};
+    ~Pipe()
+    {
+      for (auto end : fds) {
+        if (end != -1) {
+          ::close(end);
+        }
+      }
+    }
+  } pipe;
+  if (auto r = SysCall(::pipe2, pipe.fds, O_NONBLOCK | O_CLOEXEC); !r) {
+    co_return make_unexpected(r.error());
+  }
+  auto sent = size_t {0};
+  while (sent < count) {
+    // the pipe is empty here, filling it never waits
+    auto position = static_cast<loff_t>(offset + sent);
+    auto filled =
+        SysCall(::splice, fd, &position, pipe.fds[1], nullptr, count - sent, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (!filled) {
+      co_return make_unexpected(filled.error());
+    }
+    if (filled.value() == 0) {
+      break;
+    }
+    for (auto pending = static_cast<size_t>(filled.value()); pending > 0;) {
+      auto n = co_await mIo.io(Interest::Write, [in = pipe.fds[0], out = mIo.fd(), pending]() -> StdResult<size_t> {
+        return SysCall(::splice, in, nullptr, out, nullptr, pending, SPLICE_F_MOVE | SPLICE_F_NONBLOCK).map([](auto n) {
+          return static_cast<size_t>(n);
+        });
+      });
+      if (!n) {
+        co_return make_unexpected(n.error());
+      }
+      pending -= n.value();
+      sent += n.value();
+    }
+  }
+  co_return sent;
+}
+
+auto TcpStream::sendZeroCopy(std::span<std::byte const> buf) -> Task<StdResult<void>>
+{
+  if (!mZeroCopy) {
+    auto value = 1;
+    if (auto r = SysCall(::setsockopt, fd(), SOL_SOCKET, SO_ZEROCOPY, &value, sizeof(value)); !r) {
+      co_return make_unexpected(r.error());
+    }
+    mZeroCopy = true;
+  }
+  // a notification queued on the error queue shows up as EPOLLERR, which wakes the write direction
+  auto awaitNotification = [this]() -> Task<StdResult<void>> {
+    auto reaped = reapZeroCopy();
+    if (!reaped) {
+      co_return make_unexpected(reaped.error());
+    }
+    if (!reaped.value()) {
+      co_return co_await mIo.writable();
+    }
+    co_return {};
+  };
+  while (!buf.empty()) {
+    auto n = co_await mIo.io(Interest::Write, [fd = fd(), buf]() -> StdResult<size_t> {
+      return SysCall(::send, fd, buf.data(), buf.size(), MSG_ZEROCOPY | MSG_NOSIGNAL).map([](auto n) {
+        return static_cast<size_t>(n);
+      });
+    });
+    if (!n) {
+      // too many pages pinned by unfinished sends, wait for some of them
+      if (n.error() == std::errc::no_buffer_space && mZeroCopyPending > 0) {
+        if (auto r = co_await awaitNotification(); !r) {
+          co_return make_unexpected(r.error());
+        }
+        continue;
+      }
+      co_return make_unexpected(n.error());
+    }
+    mZeroCopyPending += 1;
+    buf = buf.subspan(n.value());
+  }
+  while (mZeroCopyPending > 0) {
+    if (auto r = co_await awaitNotification(); !r) {
+      co_return make_unexpected(r.error());
+    }
+  }
+  co_return {};
+}
+
+auto TcpStream::reapZeroCopy() -> StdResult<bool>
+{
+  auto reaped = false;
+  while (true) {
+    alignas(cmsghdr) char control[128];
+    auto msg = msghdr {};
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (auto r = SysCall(::recvmsg, fd(), &msg, MSG_ERRQUEUE); !r) {
+      if (r.error() == std::errc::resource_unavailable_try_again) {
+        return reaped;
+      }
+      return make_unexpected(r.error());
+    }
+    for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+          !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+        continue;
+      }
+      auto error = sock_extended_err {};
+      std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+      if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY || error.ee_errno != 0) {
+        continue;
+      }
+      // sends [ee_info, ee_data] completed, not necessarily in order with other ranges
+      auto completed = static_cast<size_t>(error.ee_data - error.ee_info) + 1;
+      mZeroCopyPending -= std::min(completed, mZeroCopyPending);
+      if ((error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {
+        mZeroCopyCopied += completed;
+      }
+      reaped = true;
+    }
+  }
+}
+
+auto TcpStream::shutdown(int how) -> StdResult<void>
+{
+  if (auto r = SysCall(::shutdown, fd(), how); !r) {
+    return make_unexpected(r.error());
+  }
+  return {};
+}
+
+auto TcpStream::setNoDelay(bool enable) -> StdResult<void>
+{
+  int value = enable ? 1 : 0;
+  if (auto r = SysCall(::setsockopt, fd(), IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)); !r) {
+    return make_unexpected(r.error());
+  }
+  return {};
+}
+
+auto TcpStream::localAddr() const -> StdResult<SocketAddr> { return GetName(fd(), false); }
+auto TcpStream::peerAddr() const -> StdResult<SocketAddr> { return GetName(fd(), true); }
+
+auto TcpListener::Bind(Reactor& reactor, SocketAddr const& addr, int backlog) -> StdResult<TcpListener>
+{
+  auto fd = CreateSocket(addr.family(), SOCK_STREAM);
+  if (!fd) {
+    return make_unexpected(fd.error());
+  }
+  auto io = Register(reactor, fd.value());
+  if (!io) {
+    return make_unexpected(io.error());
+  }
+  int reuse = 1;
+  if (auto r = SysCall(::setsockopt, fd.value(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)); !r) {
+    return make_unexpected(r.error());
+  }
+  if (auto r = SysCall(::bind, fd.value(), addr.data(), addr.len()); !r) {
+    return make_unexpected(r.error());
+  }
+  if (auto r = SysCall(::listen, fd.value(), backlog); !r) {
+    return make_unexpected(r.error());
+  }
+  return TcpListener {std::move(io.value())};
+}
+
+auto TcpListener::localAddr() const -> StdResult<SocketAddr> { return GetName(fd(), false); }
+
+auto UdpSocket::Bind(Reactor& reactor, SocketAddr const& addr) -> StdResult<UdpSocket>
+{
+  auto fd = CreateSocket(addr.family(), SOCK_DGRAM);
+  if (!fd) {
+    return make_unexpected(fd.error());
+  }
+  auto io = Register(reactor, fd.value());
+  if (!io) {
+    return make_unexpected(io.error());
+  }
+  if (auto r = SysCall(::bind, fd.value(), addr.data(), addr.len()); !r) {
+    return make_unexpected(r.error());
+  }
+  return UdpSocket {std::move(io.value())};
+}
+
+auto UdpSocket::connect(SocketAddr const& addr) -> StdResult<void>
+{
+  if (auto r = SysCall(::connect, fd(), addr.data(), addr.len()); !r) {
+    return make_unexpected(r.error());
+  }
+  return {};
+}
+
+auto UdpSocket::localAddr() const -> StdResult<SocketAddr> { return GetName(fd(), false); }
+} // namespace async
@@ -0,0 +1,174 @@
+#include "Async/Timer.hpp"
+#include <bit>
+
+namespace async {
+TimerWheel::TimerWheel(TimePoint::duration resolution, TimePoint start)
+    : mResolution(resolution), mStart(start), mElapsed(0), mOccupied(), mSlots(), mNodes(), mIndex()
+{
+  assert(resolution.count() > 0);
+  mSlots.fill(NONE);
+}
+
+auto TimerWheel::deadlineTick(TimePoint when) const -> uint64_t
+{
+  if (when <= mStart) {
+    return 0;
+  }
+  auto elapsed = when - mStart;
+  return static_cast<uint64_t>((elapsed + mResolution - TimePoint::duration(1)) / mResolution); // round up
+}
+
+auto TimerWheel::nowTick(TimePoint now) const -> uint64_t
+{
+  if (now <= mStart) {
+    return 0;
+  }
+  return static_cast<uint64_t>((now - mStart) / mResolution);
+}
+
+auto TimerWheel::insert(TimePoint when, size_t id, std::coroutine_handle<> handle) -> void
+{
+  auto key = mNodes.insert(Node {when, id, handle, NONE, NONE, 0, 0});
+  mIndex.emplace(id, key);
+  place(key);
+}
+
+auto TimerWheel::remove(TimePoint, size_t id) -> std::coroutine_handle<>
+{
+  auto it = mIndex.find(id);
+  if (it == mIndex.end()) {
+    return nullptr;
+  }
+  auto key = it->second;
+  mIndex.erase(it);
+  unlink(key);
+  auto node = mNodes.tryRemove(key);
+  assert(node.has_value());
+  return node->handle;
+}
+
+auto TimerWheel::place(size_t key) -> void
+{
+  auto tick = deadlineTick(mNodes[key].when);
+  if (tick <= mElapsed) {
+    link(key, EXPIRED_LEVEL, 0);
+    return;
+  }
+  if (tick - mElapsed > MAX_TICK) {
+    tick = mElapsed + MAX_TICK; // revisited by the top level until the real deadline is reached
+  }
+  // the highest bit that differs from `mElapsed` decides the level
+  auto masked = std::min((mElapsed ^ tick) | (SLOTS - 1), MAX_TICK);
+  auto significant = 63u - static_cast<uint32_t>(std::countl_zero(masked));
+  auto level = significant / LEVEL_BITS;
+  auto slot = static_cast<uint32_t>((tick >> (level * LEVEL_BITS)) & (SLOTS - 1));
+  link(key, level, slot);
+}
+
+auto TimerWheel::link(size_t key, uint32_t level, uint32_t slot) -> void
+{
+  auto& node = mNodes[key];
+  auto& head = headOf(level, slot);
+  node.level = level;
+  node.slot = slot;
+  node.prev = NONE;
+  node.next = head;
+  if (head != NONE) {
+    mNodes[head].prev = key;
+  }
+  head = key;
+  if (level < LEVELS) {
+    mOccupied[level] |= uint64_t {1} << slot;
+  }
+}
+
+auto TimerWheel::unlink(size_t key) -> void
+{
+  auto& node = mNodes[key];
+  if (node.prev != NONE) {
+    mNodes[node.prev].next = node.next;
+  } else {
+    headOf(node.level, node.slot) = node.next;
+  }
+  if (node.next != NONE) {
+    mNodes[node.next].prev = node.prev;
+  }
+  if (node.level < LEVELS && headOf(node.level, node.slot) == NONE) {
+    mOccupied[node.level] &= ~(uint64_t {1} << node.slot);
+  }
+}
+
+auto TimerWheel::nextExpiration() const -> std::optional<Expiration>
+{
+  // a lower level always expires before a higher one
+  for (auto level = 0u; level < LEVELS; ++level) {
+    if (mOccupied[level] == 0) {
+      continue;
+    }
+    auto shift = level * LEVEL_BITS;
+    auto slotRange = uint64_t {1} << shift;
+    auto levelRange = slotRange << LEVEL_BITS;
+    auto nowSlot = static_cast<uint32_t>((mElapsed >> shift) & (SLOTS - 1));
+    auto zeros = static_cast<uint32_t>(std::countr_zero(std::rotr(mOccupied[level], static_cast<int>(nowSlot))));
+    auto slot = (zeros + nowSlot) % SLOTS;
+    auto levelStart = mElapsed & ~(levelRange - 1);
+    auto deadline = levelStart + slot * slotRange;
+    if (deadline <= mElapsed) {
+      // only the top level wraps around
+      deadline += levelRange;
+    }
+    return Expiration {level, slot, deadline};
+  }
+  return std::nullopt;
+}
+
+auto TimerWheel::popExpired(TimePoint now, std::vector<std::coroutine_handle<>>& out) -> size_t
+{
+  auto count = size_t {0};
+  auto fire = [&](size_t key) {
+    auto node = mNodes.tryRemove(key);
+    assert(node.has_value());
+    mIndex.erase(node->id);
+    out.push_back(node->handle);
+    count += 1;
+  };
+
+  for (auto key = std::exchange(headOf(EXPIRED_LEVEL, 0), NONE); key != NONE;) {
+    auto next = mNodes[key].next;
+    fire(key);
+    key = next;
+  }
+
+  auto tick = nowTick(now);
+  while (auto expiration = nextExpiration()) {
+    if (expiration->deadline > tick) {
+      break;
+    }
+    mElapsed = expiration->deadline;
+    auto key = std::exchange(headOf(expiration->level, expiration->slot), NONE);
+    mOccupied[expiration->level] &= ~(uint64_t {1} << expiration->slot);
+    while (key != NONE) {
+      auto next = mNodes[key].next;
+      if (deadlineTick(mNodes[key].when) <= mElapsed) {
+        fire(key);
+      } else {
+        place(key); // cascade to a lower level
+      }
+      key = next;
+    }
+  }
+  mElapsed = std::max(mElapsed, tick);
+  return count;
+}
+
+auto TimerWheel::nextDeadline() const -> std::optional<TimePoint>
+{
+  if (mSlots[EXPIRED_LEVEL * SLOTS] != NONE) {
+    return mStart + mResolution * static_cast<int64_t>(mElapsed);
+  }
+  if (auto expiration = nextExpiration()) {
+    return mStart + mResolution * static_cast<int64_t>(expiration->deadline);
+  }
+  return std::nullopt;
+}
+} // namespace async
@@ -0,0 +1,63 @@
+#include "Async/sys/Topology.hpp"
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+namespace async {
+auto Topology::DistanceOf(CpuInfo const& a, CpuInfo const& b) -> Distance
+{
+  if (a.cpu == b.cpu) {
+    return SAME_CPU;
+  }
+  if (a.core == b.core) {
+    return SMT_SIBLING;
+  }
+  if (a.cache == b.cache) {
+    return SAME_CACHE;
+  }
+  if (a.node == b.node) {
+    return SAME_NODE;
+  }
+  return a.package == b.package ? SAME_PACKAGE : REMOTE;
+}
+
+auto Topology::place(size_t workers) const -> std::vector<CpuInfo>
+{
+  if (mCpus.empty()) {
+    return {};
+  }
+  // rank of every cpu among its SMT siblings, the first thread of each core comes before any second one
+  auto rank = std::map<uint32_t, uint32_t> {};
+  auto order = std::vector<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>> {};
+  order.reserve(mCpus.size());
+  auto sorted = mCpus;
+  std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.cpu < b.cpu; });
+  for (size_t i = 0; i < sorted.size(); ++i) {
+    auto const& cpu = sorted[i];
+    order.emplace_back(rank[cpu.core]++, cpu.node, cpu.cache, cpu.core, static_cast<uint32_t>(i));
+  }
+  std::sort(order.begin(), order.end());
+  auto placement = std::vector<CpuInfo> {};
+  placement.reserve(workers);
+  for (size_t i = 0; i < workers; ++i) {
+    placement.push_back(sorted[std::get<4>(order[i % order.size()])]);
+  }
+  return placement;
+}
+
+auto Topology::StealOrder(std::vector<CpuInfo> const& placement) -> std::vector<std::vector<uint32_t>>
+{
+  auto n = placement.size();
+  auto orders = std::vector<std::vector<uint32_t>>(n);
+  for (size_t id = 0; id < n; ++id) {
+    auto& victims = orders[id];
+    for (size_t j = 1; j < n; ++j) {
+      victims.push_back(static_cast<uint32_t>((id + j) % n));
+    }
+    std::stable_sort(victims.begin(), victims.end(), [&](uint32_t a, uint32_t b) {
+      return DistanceOf(placement[id], placement[a]) < DistanceOf(placement[id], placement[b]);
+    });
+  }
+  return orders;
+}
+} // namespace async
@@ -4,9 +4,24 @@
   #include <sys/epoll.h>
   #include <sys/eventfd.h>
   #include <sys/fcntl.h>
+  #include <sys/syscall.h>
   #include <sys/timerfd.h>
   #include <unistd.h>
 namespace async::impl {
+// keeps the library building against headers older than the syscall
+static auto EpollPwait2(int epfd, epoll_event* events, int maxEvents, timespec const* timeout) -> StdResult<int>
+{
+  #ifdef SYS_epoll_pwait2
+  auto r = ::syscall(SYS_epoll_pwait2, epfd, events, maxEvents, timeout, nullptr, 0);
+  if (r == -1) {
+    return make_unexpected(std::errc(errno));
+  }
+  return static_cast<int>(r);
+  #else
+  return make_unexpected(std::errc::function_not_supported);
+  #endif
+}
+
 constexpr auto ReadFlags() -> uint32_t { return EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR | EPOLLPRI; }
 constexpr auto WriteFlags() -> uint32_t { return EPOLLOUT | EPOLLHUP | EPOLLERR; }
 
@@ -40,11 +55,18 @@ auto Poller::Create() -> StdResult<Poller>
   r = (SysCall(::eventfd, 0, EFD_CLOEXEC | EFD_NONBLOCK));
   RE(r);
   poller.mEventFd = r.value();
-  r = (SysCall(::timerfd_create, CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK));
-  RE(r);
-  poller.mTimerFd = r.value();
-  RE(poller.add(poller.mTimerFd, Event::None(async::NOTIFY_KEY), PollMode::Oneshot));
-  RE(poller.add(poller.mEventFd, Event::Readable(async::NOTIFY_KEY), PollMode::Oneshot));
+  // level triggered, stays registered for good and is only read after it fired
+  RE(poller.add(poller.mEventFd, Event::Readable(async::NOTIFY_KEY), PollMode::Level));
+
+  auto probe = epoll_event {};
+  auto zero = timespec {0, 0};
+  // kernels before 5.11 (or a filter refusing it) fall back to epoll_wait and a timerfd for the deadline
+  if (!EpollPwait2(poller.mEpollFd, &probe, 1, &zero)) {
+    r = (SysCall(::timerfd_create, CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK));
+    RE(r);
+    poller.mTimerFd = r.value();
+    RE(poller.add(poller.mTimerFd, Event::Readable(async::TIMER_KEY), PollMode::Level));
+  }
   return poller;
 }
 
@@ -100,51 +122,68 @@ auto Poller::del(int fd) -> StdResult<void>
   return {};
 }
 
-static timespec ns_to_timespec(std::optional<std::chrono::nanoseconds>& ns)
+static auto ToTimespec(std::chrono::nanoseconds ns) -> timespec
 {
-  using namespace std::chrono_literals;
-  timespec ts;
-  if (ns.has_value() && ns.value().count() > 0) {
-    ts.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(ns.value()).count();
-    ts.tv_nsec = (ns.value() - (ts.tv_sec * (1s))).count();
-  } else {
-    ts.tv_sec = 0;
-    ts.tv_nsec = 0;
-  }
-  return ts;
+  auto seconds = std::chrono::duration_cast<std::chrono::seconds>(ns);
+  return timespec {
+      .tv_sec = static_cast<time_t>(seconds.count()),
+      .tv_nsec = static_cast<long>((ns - seconds).count()),
+  };
 }
 
-auto Poller::wait(Events& events, std::optional<std::chrono::nanoseconds> timeout) -> StdResult<void>
+auto Poller::armTimer(std::chrono::nanoseconds timeout) -> StdResult<void>
 {
+  auto now = std::chrono::steady_clock::now();
+  auto deadline = now + timeout;
+  if (mArmed > now && mArmed <= deadline) {
+    return {}; // fires early at worst, the caller just waits again
+  }
+  auto value = itimerspec {
+      .it_interval = {.tv_sec = 0, .tv_nsec = 0},
+      .it_value = ToTimespec(deadline.time_since_epoch()),
+  };
+  RE(SysCall(::timerfd_settime, mTimerFd, TFD_TIMER_ABSTIME, &value, nullptr));
+  mArmed = deadline;
+  return {};
+}
 
-  if (mTimerFd != -1) {
-    auto newVal = itimerspec {
-        .it_interval = {.tv_sec = 0, .tv_nsec = 0},
-        .it_value = ns_to_timespec(timeout),
-    };
-    RE(SysCall(::timerfd_settime, mTimerFd, 0, &newVal, nullptr));
-    RE(mod(mTimerFd, Event::Readable(async::NOTIFY_KEY), PollMode::Oneshot));
+auto Poller::drain(Events& events) -> void
+{
+  auto buf = uint64_t {0};
+  for (size_t i = 0; i < events.len; ++i) {
+    auto key = events.data[i].data.u64;
+    if (key == async::NOTIFY_KEY) {
+      (void)SysCall(::read, mEventFd, &buf, sizeof(buf));
+    } else if (key == async::TIMER_KEY) {
+      (void)SysCall(::read, mTimerFd, &buf, sizeof(buf));
+      mArmed = {};
+    }
   }
+}
 
-  int timeoutMs = -1;
-  if (timeout) {
-    if (mTimerFd == -1) {
-      timeoutMs = std::chrono::duration_cast<std::chrono::milliseconds>(timeout.value()).count();
-    } else {
-      if (timeout->count() == 0) {
-        timeoutMs = 0;
-      }
+auto Poller::wait(Events& events, std::optional<std::chrono::nanoseconds> timeout) -> StdResult<void>
+{
+  using namespace std::chrono_literals;
+  auto maxEvents = static_cast<int>(events.capacity);
+  auto r = StdResult<int> {};
+  if (mTimerFd == -1) {
+    auto ts = timeout ? ToTimespec(std::max(timeout.value(), 0ns)) : timespec {};
+    r = EpollPwait2(mEpollFd, events.data.get(), maxEvents, timeout ? &ts : nullptr);
+  } else {
+    auto timeoutMs = -1;
+    if (timeout && timeout->count() <= 0) {
+      timeoutMs = 0;
+    } else if (timeout) {
+      RE(armTimer(timeout.value()));
     }
+    r = SysCall(::epoll_wait, mEpollFd, events.data.get(), maxEvents, timeoutMs);
   }
-  auto r = SysCall(::epoll_wait, mEpollFd, events.data.get(), Events::MAX_EVENTS, timeoutMs);
   if (!r) {
+    events.len = 0;
     return make_unexpected(r.error());
   }
   events.len = r.value();
-
-  auto buf = uint64_t {0};
-  (SysCall(::read, mEventFd, &buf, sizeof(buf))); // ignore error
-  RE(mod(mEventFd, Event::Readable(async::NOTIFY_KEY), PollMode::Oneshot));
+  drain(events);
   return {};
 }
 
@@ -173,6 +212,7 @@ Poller::Poller(Poller&& other)
   mEpollFd = other.mEpollFd;
   mEventFd = other.mEventFd;
   mTimerFd = other.mTimerFd;
+  mArmed = other.mArmed;
   other.mEpollFd = -1;
   other.mEventFd = -1;
   other.mTimerFd = -1;
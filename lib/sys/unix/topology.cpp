@@ -0,0 +1,87 @@
+#include "Async/sys/Topology.hpp"
+#ifdef __linux__
+  #include <cerrno>
+  #include <cstdlib>
+  #include <filesystem>
+  #include <fstream>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <string>
+namespace async {
+namespace {
+// first cpu of a sysfs cpu list like "0-3,8-11", `fallback` when the file is missing
+auto FirstCpuOf(std::filesystem::path const& path, uint32_t fallback) -> uint32_t
+{
+  auto file = std::ifstream(path);
+  auto text = std::string {};
+  if (!std::getline(file, text) || text.empty()) {
+    return fallback;
+  }
+  return static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 10));
+}
+auto ReadId(std::filesystem::path const& path, uint32_t fallback) -> uint32_t
+{
+  auto file = std::ifstream(path);
+  auto id = long {-1};
+  if (!(file >> id) || id < 0) {
+    return fallback;
+  }
+  return static_cast<uint32_t>(id);
+}
+auto NodeOf(std::filesystem::path const& cpuDir) -> uint32_t
+{
+  auto ec = std::error_code {};
+  for (auto const& entry : std::filesystem::directory_iterator(cpuDir, ec)) {
+    auto name = entry.path().filename().string();
+    if (name.size() > 4 && name.starts_with("node")) {
+      return static_cast<uint32_t>(std::strtoul(name.c_str() + 4, nullptr, 10));
+    }
+  }
+  return 0;
+}
+} // namespace
+
+auto Topology::Detect() -> Topology
+{
+  auto allowed = cpu_set_t {};
+  CPU_ZERO(&allowed);
+  if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return Topology {{}};
+  }
+  auto cpus = std::vector<uint32_t> {};
+  for (uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      cpus.push_back(cpu);
+    }
+  }
+  return Parse("/sys/devices/system/cpu", cpus);
+}
+
+auto Topology::Parse(std::string const& root, std::vector<uint32_t> const& cpus) -> Topology
+{
+  auto infos = std::vector<CpuInfo> {};
+  infos.reserve(cpus.size());
+  for (auto cpu : cpus) {
+    auto dir = std::filesystem::path(root) / ("cpu" + std::to_string(cpu));
+    auto package = ReadId(dir / "topology/physical_package_id", 0);
+    auto node = NodeOf(dir);
+    auto core = FirstCpuOf(dir / "topology/thread_siblings_list", cpu);
+    // without an L3 entry the package is the closest shared cache we know of
+    auto cache = FirstCpuOf(dir / "cache/index3/shared_cpu_list", FirstCpuOf(dir / "topology/core_siblings_list", cpu));
+    infos.push_back(CpuInfo {cpu, core, cache, node, package});
+  }
+  return Topology {std::move(infos)};
+}
+
+auto Topology::Pin(uint32_t cpu) -> StdResult<void>
+{
+  auto set = cpu_set_t {};
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (auto r = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set); r != 0) {
+    return make_unexpected(std::errc(r));
+  }
+  return {};
+}
+} // namespace async
+#endif
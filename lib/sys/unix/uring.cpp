@@ -0,0 +1,275 @@
+#include "Async/sys/unix/uring.hpp"
+#ifdef __linux__
+  #include <algorithm>
+  #include <atomic>
+  #include <cstring>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  #include <utility>
+namespace async::impl {
+  #define RE(r)                                                                                                        \
+    if (!r) {                                                                                                          \
+      return make_unexpected(r.error());                                                                               \
+    }
+
+static auto Setup(unsigned entries, io_uring_params* params) -> int
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+static auto Enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) -> int
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+static auto Offset(void* base, uint32_t offset) -> unsigned*
+{
+  return reinterpret_cast<unsigned*>(static_cast<char*>(base) + offset);
+}
+static auto LoadAcquire(unsigned* ptr) -> unsigned
+{
+  return std::atomic_ref<unsigned>(*ptr).load(std::memory_order_acquire);
+}
+static auto StoreRelease(unsigned* ptr, unsigned value) -> void
+{
+  std::atomic_ref<unsigned>(*ptr).store(value, std::memory_order_release);
+}
+
+auto Uring::Create(unsigned entries) -> StdResult<Uring>
+{
+  auto ring = Uring {};
+  auto params = io_uring_params {};
+  std::memset(&params, 0, sizeof(params));
+  auto fd = SysCall(Setup, entries, &params);
+  RE(fd);
+  ring.mRingFd = fd.value();
+
+  ring.mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring.mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  auto singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (singleMmap) {
+    ring.mSqRingSize = ring.mCqRingSize = std::max(ring.mSqRingSize, ring.mCqRingSize);
+  }
+
+  ring.mSqRing =
+      ::mmap(nullptr, ring.mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.mRingFd, IORING_OFF_SQ_RING);
+  if (ring.mSqRing == MAP_FAILED) {
+    ring.mSqRing = nullptr;
+    return make_unexpected(std::errc(errno));
+  }
+  if (singleMmap) {
+    ring.mCqRing = ring.mSqRing;
+  } else {
+    ring.mCqRing = ::mmap(nullptr, ring.mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.mRingFd,
+                          IORING_OFF_CQ_RING);
+    if (ring.mCqRing == MAP_FAILED) {
+      ring.mCqRing = nullptr;
+      return make_unexpected(std::errc(errno));
+    }
+  }
+  ring.mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  auto sqes =
+      ::mmap(nullptr, ring.mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.mRingFd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return make_unexpected(std::errc(errno));
+  }
+  ring.mSqes = static_cast<io_uring_sqe*>(sqes);
+
+  ring.mSqHead = Offset(ring.mSqRing, params.sq_off.head);
+  ring.mSqTail = Offset(ring.mSqRing, params.sq_off.tail);
+  ring.mSqMask = Offset(ring.mSqRing, params.sq_off.ring_mask);
+  ring.mSqArray = Offset(ring.mSqRing, params.sq_off.array);
+  ring.mSqEntries = params.sq_entries;
+
+  ring.mCqHead = Offset(ring.mCqRing, params.cq_off.head);
+  ring.mCqTail = Offset(ring.mCqRing, params.cq_off.tail);
+  ring.mCqMask = Offset(ring.mCqRing, params.cq_off.ring_mask);
+  ring.mCqes = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(ring.mCqRing) + params.cq_off.cqes);
+  return ring;
+}
+
+auto Uring::getSqe() -> io_uring_sqe*
+{
+  auto head = LoadAcquire(mSqHead);
+  auto tail = *mSqTail;
+  if (tail - head >= mSqEntries) {
+    return nullptr;
+  }
+  auto index = tail & *mSqMask;
+  auto sqe = &mSqes[index];
+  std::memset(sqe, 0, sizeof(io_uring_sqe));
+  mSqArray[index] = index;
+  return sqe;
+}
+
+auto Uring::pushSqe() -> void
+{
+  StoreRelease(mSqTail, *mSqTail + 1);
+  mPending += 1;
+}
+
+auto Uring::read(int fd, std::span<std::byte> buf, uint64_t offset, uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf.data());
+  sqe->len = static_cast<uint32_t>(buf.size());
+  sqe->off = offset;
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+auto Uring::write(int fd, std::span<std::byte const> buf, uint64_t offset, uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_WRITE;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buf.data());
+  sqe->len = static_cast<uint32_t>(buf.size());
+  sqe->off = offset;
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+auto Uring::accept(int fd, sockaddr* addr, socklen_t* len, int flags, uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->addr2 = reinterpret_cast<uint64_t>(len);
+  sqe->accept_flags = static_cast<uint32_t>(flags);
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+auto Uring::connect(int fd, sockaddr const* addr, socklen_t len, uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_CONNECT;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->off = len;
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+auto Uring::recv(int fd, uint16_t group, int flags, uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = fd;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = group;
+  sqe->msg_flags = static_cast<uint32_t>(flags);
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+auto Uring::provideBuffers(void* addr, uint32_t len, uint32_t count, uint16_t group, uint16_t bid,
+                           uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = static_cast<int32_t>(count);
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->len = len;
+  sqe->off = bid;
+  sqe->buf_group = group;
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+auto Uring::removeBuffers(uint32_t count, uint16_t group, uint64_t userData) -> StdResult<void>
+{
+  auto sqe = getSqe();
+  if (sqe == nullptr) {
+    return make_unexpected(std::errc::resource_unavailable_try_again);
+  }
+  sqe->opcode = IORING_OP_REMOVE_BUFFERS;
+  sqe->fd = static_cast<int32_t>(count);
+  sqe->buf_group = group;
+  sqe->user_data = userData;
+  pushSqe();
+  return {};
+}
+
+auto Uring::submit() -> StdResult<size_t>
+{
+  if (mPending == 0) {
+    return {0};
+  }
+  auto r = SysCall(Enter, mRingFd, mPending, 0u, 0u);
+  RE(r);
+  mPending -= static_cast<unsigned>(r.value());
+  return {static_cast<size_t>(r.value())};
+}
+
+auto Uring::reap(std::vector<Completion>& out) -> size_t
+{
+  auto head = *mCqHead;
+  auto tail = LoadAcquire(mCqTail);
+  auto count = size_t {0};
+  for (; head != tail; ++head, ++count) {
+    auto const& cqe = mCqes[head & *mCqMask];
+    out.push_back(Completion {cqe.user_data, cqe.res, cqe.flags});
+  }
+  StoreRelease(mCqHead, head);
+  return count;
+}
+
+Uring::~Uring()
+{
+  if (mSqes != nullptr) {
+    ::munmap(mSqes, mSqesSize);
+  }
+  if (mCqRing != nullptr && mCqRing != mSqRing) {
+    ::munmap(mCqRing, mCqRingSize);
+  }
+  if (mSqRing != nullptr) {
+    ::munmap(mSqRing, mSqRingSize);
+  }
+  if (mRingFd != -1) {
+    ::close(mRingFd);
+  }
+}
+
+Uring::Uring(Uring&& other)
+    : mRingFd(std::exchange(other.mRingFd, -1)), mPending(std::exchange(other.mPending, 0)),
+      mSqRing(std::exchange(other.mSqRing, nullptr)), mSqRingSize(other.mSqRingSize),
+      mCqRing(std::exchange(other.mCqRing, nullptr)), mCqRingSize(other.mCqRingSize),
+      mSqes(std::exchange(other.mSqes, nullptr)), mSqesSize(other.mSqesSize), mSqHead(other.mSqHead),
+      mSqTail(other.mSqTail), mSqMask(other.mSqMask), mSqArray(other.mSqArray), mSqEntries(other.mSqEntries),
+      mCqHead(other.mCqHead), mCqTail(other.mCqTail), mCqMask(other.mCqMask), mCqes(other.mCqes)
+{
+}
+
+auto Uring::operator=(Uring&& other) -> Uring&
+{
+  if (this != &other) {
+    this->~Uring();
+    new (this) Uring(std::move(other));
+  }
+  return *this;
+}
+  #undef RE
+} // namespace async::impl
+#endif
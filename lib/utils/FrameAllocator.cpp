@@ -0,0 +1,64 @@
+#include "Async/utils/FrameAllocator.hpp"
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace async {
+namespace {
+struct Registry {
+  std::mutex mutex;
+  std::vector<void const*> caches;
+  FrameStats retired; // counters of exited threads
+};
+auto GetRegistry() -> Registry&
+{
+  // never destroyed, threads may exit after static destruction started
+  static auto registry = new Registry();
+  return *registry;
+}
+} // namespace
+
+FrameAllocator::ThreadCache::ThreadCache()
+{
+  auto& registry = GetRegistry();
+  auto lock = std::lock_guard(registry.mutex);
+  registry.caches.push_back(this);
+}
+
+FrameAllocator::ThreadCache::~ThreadCache()
+{
+  tDead = true;
+  for (auto& list : lists) {
+    while (list.head != nullptr) {
+      ::operator delete(std::exchange(list.head, list.head->next));
+    }
+  }
+  auto& registry = GetRegistry();
+  auto lock = std::lock_guard(registry.mutex);
+  collect(registry.retired);
+  std::erase(registry.caches, this);
+}
+
+auto FrameAllocator::ThreadCache::collect(FrameStats& out) const -> void
+{
+  for (auto i = std::size_t {0}; i < sizes.size(); ++i) {
+    out.sizes[i] += sizes[i].load(std::memory_order_relaxed);
+  }
+  out.allocations += allocations.load(std::memory_order_relaxed);
+  out.reused += reused.load(std::memory_order_relaxed);
+  out.oversized += oversized.load(std::memory_order_relaxed);
+  out.largest = std::max(out.largest, largest.load(std::memory_order_relaxed));
+}
+
+auto FrameAllocator::stats() -> FrameStats
+{
+  auto& registry = GetRegistry();
+  auto lock = std::lock_guard(registry.mutex);
+  auto out = registry.retired;
+  for (auto cache : registry.caches) {
+    static_cast<ThreadCache const*>(cache)->collect(out);
+  }
+  return out;
+}
+} // namespace async
@@ -0,0 +1,113 @@
+#include "Async/utils/Metrics.hpp"
+#include <mutex>
+
+namespace async {
+#ifdef ASYNC_METRICS
+namespace {
+struct Registry {
+  std::mutex mutex;
+  std::vector<void const*> blocks;
+  std::size_t next = 0;
+  ThreadMetrics retired; // counters of exited threads
+};
+auto GetRegistry() -> Registry&
+{
+  // never destroyed, threads may exit after static destruction started
+  static auto registry = new Registry();
+  return *registry;
+}
+} // namespace
+
+Metrics::ThreadBlock::ThreadBlock()
+{
+  auto& registry = GetRegistry();
+  auto lock = std::lock_guard(registry.mutex);
+  thread = registry.next++;
+  registry.blocks.push_back(this);
+}
+
+Metrics::ThreadBlock::~ThreadBlock()
+{
+  auto& registry = GetRegistry();
+  auto lock = std::lock_guard(registry.mutex);
+  auto metrics = ThreadMetrics {};
+  collect(metrics);
+  registry.retired.merge(metrics);
+  std::erase(registry.blocks, this);
+}
+
+auto Metrics::LiveHistogram::collect(HistogramSnapshot& out) const -> void
+{
+  for (std::size_t i = 0; i < HistogramSnapshot::BUCKETS; ++i) {
+    out.counts[i] += counts[i].load(std::memory_order_relaxed);
+  }
+  out.count += count.load(std::memory_order_relaxed);
+  out.sum += sum.load(std::memory_order_relaxed);
+  out.max = std::max(out.max, max.load(std::memory_order_relaxed));
+}
+
+auto Metrics::ThreadBlock::collect(ThreadMetrics& out) const -> void
+{
+  out.thread = thread;
+  if (auto id = worker.load(std::memory_order_relaxed); id >= 0) {
+    out.worker = static_cast<std::size_t>(id);
+  }
+  for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+    out.counters[i] += counters[i].load(std::memory_order_relaxed);
+  }
+  for (std::size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+    histograms[i].collect(out.histograms[i]);
+  }
+}
+
+auto Metrics::snapshot() -> MetricsSnapshot
+{
+  auto& registry = GetRegistry();
+  auto lock = std::lock_guard(registry.mutex);
+  auto out = MetricsSnapshot {};
+  out.total = registry.retired;
+  out.threads.reserve(registry.blocks.size());
+  for (auto block : registry.blocks) {
+    auto& metrics = out.threads.emplace_back();
+    static_cast<ThreadBlock const*>(block)->collect(metrics);
+    out.total.merge(metrics);
+  }
+  return out;
+}
+#else
+auto Metrics::snapshot() -> MetricsSnapshot { return {}; }
+#endif
+
+auto MetricsSnapshot::toPrometheus(std::string_view prefix) const -> std::string
+{
+  auto out = std::string {};
+  auto line = [&](std::string_view name, std::string_view suffix, std::string const& labels, auto value) {
+    out.append(prefix).append(name).append(suffix);
+    if (!labels.empty()) {
+      out.append("{").append(labels).append("}");
+    }
+    out.append(" ").append(std::to_string(value)).append("\n");
+  };
+  for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+    auto name = COUNTER_NAMES[i];
+    out.append("# TYPE ").append(prefix).append(name).append("_total counter\n");
+    line(name, "_total", "", total.counters[i]);
+    for (auto const& thread : threads) {
+      if (thread.worker && thread.counters[i] != 0) {
+        line(name, "_total", "worker=\"" + std::to_string(*thread.worker) + "\"", thread.counters[i]);
+      }
+    }
+  }
+  for (std::size_t i = 0; i < HISTOGRAM_COUNT; ++i) {
+    auto name = HISTOGRAM_NAMES[i];
+    auto const& histogram = total.histograms[i];
+    out.append("# TYPE ").append(prefix).append(name).append(" summary\n");
+    for (auto q : {"0.5", "0.9", "0.99", "0.999"}) {
+      line(name, "", std::string("quantile=\"") + q + "\"", histogram.percentile(std::stod(q)));
+    }
+    line(name, "_sum", "", histogram.sum);
+    line(name, "_count", "", histogram.count);
+  }
+  return out;
+}
+} // namespace async
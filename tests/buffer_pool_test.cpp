@@ -0,0 +1,135 @@
+#include <Async/BufferPool.hpp>
+#include <Async/Executor.hpp>
+#include <Async/Net.hpp>
+#include <Async/Runtime.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <netinet/in.h>
+#include <string_view>
+#include <vector>
+
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+TEST(BufferPoolTest, HandsOutWarmBuffersUntilExhausted)
+{
+  auto pool = async::BufferPool(100, 70);
+  ASSERT_EQ(pool.bufferSize(), 128);
+  ASSERT_EQ(pool.maxBuffers(), 2 * async::BufferPool::CHUNK_BUFFERS);
+  ASSERT_EQ(pool.reserved(), 0);
+
+  auto taken = std::vector<async::PooledBuffer> {};
+  for (size_t i = 0; i < pool.maxBuffers(); ++i) {
+    taken.push_back(pool.tryAcquire());
+    ASSERT_TRUE(taken.back());
+    ASSERT_EQ(taken.back().size(), 0);
+    ASSERT_EQ(taken.back().capacity(), 128);
+  }
+  ASSERT_EQ(pool.inUse(), pool.maxBuffers());
+  ASSERT_EQ(pool.reserved(), pool.maxBuffers() * 128);
+  ASSERT_FALSE(pool.tryAcquire());
+
+  auto data = taken[3].data();
+  taken[3].release();
+  ASSERT_FALSE(taken[3]);
+  auto again = pool.tryAcquire();
+  ASSERT_EQ(again.data(), data);
+  again = std::move(taken[5]);
+  ASSERT_EQ(pool.inUse(), pool.maxBuffers() - 1);
+  taken.clear();
+  again.release();
+  ASSERT_EQ(pool.inUse(), 0);
+}
+
+TEST(BufferPoolTest, AcquireWaitsForARelease)
+{
+  auto rt = Runtime(2);
+  auto pool = async::BufferPool(64, 1);
+  auto held = std::vector<async::PooledBuffer> {};
+  while (auto buf = pool.tryAcquire()) {
+    held.push_back(std::move(buf));
+  }
+  auto waiter = [](async::BufferPool& pool, int n) -> async::Task<int> {
+    for (int i = 0; i < n; ++i) {
+      auto buf = co_await pool.acquire();
+      buf.setSize(1);
+    }
+    co_return n;
+  };
+  auto a = async::JoinHandle(waiter(pool, 100));
+  auto b = async::JoinHandle(waiter(pool, 100));
+  rt.spawn(a);
+  rt.spawn(b);
+  held.clear();
+  ASSERT_EQ(rt.block([](auto& a, auto& b) -> async::Task<int> { co_return co_await a.join() + co_await b.join(); }(a, b)),
+            200);
+  ASSERT_EQ(pool.inUse(), 0);
+}
+
+static auto Exchange(Runtime& rt, async::BufferPool& pool, size_t idle) -> void
+{
+  rt.block([](Runtime& rt, async::BufferPool& pool, size_t idle) -> async::Task<> {
+    auto listener = async::TcpListener::Bind(rt.reactor(), async::SocketAddr::V4(INADDR_LOOPBACK, 0)).value();
+    auto addr = listener.localAddr().value();
+    auto clients = std::vector<async::TcpStream> {};
+    auto servers = std::vector<async::TcpStream> {};
+    for (size_t i = 0; i <= idle; ++i) {
+      clients.push_back((co_await async::TcpStream::Connect(rt.reactor(), addr)).value());
+      servers.push_back((co_await listener.accept()).value());
+    }
+    auto reader = [](async::TcpStream& stream, async::BufferPool& pool) -> async::Task<std::string> {
+      auto out = std::string {};
+      while (true) {
+        auto buf = co_await stream.read(pool);
+        EXPECT_TRUE(buf);
+        if (!buf || !buf.value()) {
+          co_return out;
+        }
+        out.append(reinterpret_cast<char const*>(buf->data()), buf->size());
+      }
+    };
+    auto readers = std::vector<std::unique_ptr<async::JoinHandle<std::string>>> {};
+    for (auto& server : servers) {
+      readers.push_back(std::make_unique<async::JoinHandle<std::string>>(reader(server, pool)));
+      rt.spawn(*readers.back());
+    }
+    // every reader is parked on a connection without data
+    co_await rt.reactor().sleep(std::chrono::milliseconds(20));
+    EXPECT_EQ(pool.inUse(), 0);
+
+    auto message = std::string_view {"hello from a mostly idle connection"};
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(co_await clients.back().writeAll(std::as_bytes(std::span(message))));
+      co_await rt.reactor().sleep(std::chrono::milliseconds(5));
+    }
+    for (auto& client : clients) {
+      EXPECT_TRUE(client.shutdown());
+    }
+    for (size_t i = 0; i < readers.size(); ++i) {
+      auto got = co_await readers[i]->join();
+      EXPECT_EQ(got, i == idle ? std::string(message) + std::string(message) + std::string(message) : "");
+    }
+    EXPECT_EQ(pool.inUse(), 0);
+  }(rt, pool, idle));
+}
+
+TEST(BufferPoolTest, ReadinessThenBorrow)
+{
+  auto rt = Runtime(2);
+  auto pool = async::BufferPool(16, 64);
+  Exchange(rt, pool, 200);
+  // one chunk for 201 connections
+  ASSERT_EQ(pool.reserved(), async::BufferPool::CHUNK_BUFFERS * 64);
+}
+
+TEST(BufferPoolTest, ProvidedBuffers)
+{
+  auto rt = Runtime(2);
+  auto pool = async::BufferPool(16, 128);
+  if (auto r = rt.block(pool.provide(rt.reactor(), 8)); !r) {
+    GTEST_SKIP() << "no provided buffers: " << std::make_error_code(r.error()).message();
+  }
+  ASSERT_TRUE(pool.providedGroup(rt.reactor()));
+  ASSERT_EQ(pool.inUse(), 0);
+  // more connections than provided buffers, the ones finding none read from the free list
+  Exchange(rt, pool, 200);
+}
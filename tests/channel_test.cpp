@@ -0,0 +1,181 @@
+#include <Async/Channel.hpp>
+#include <Async/Executor.hpp>
+#include <Async/Runtime.hpp>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+TEST(ChannelTest, TrySendAndRecv)
+{
+  auto channel = async::Channel<std::string>(3);
+  ASSERT_EQ(channel.capacity(), 4);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(channel.try_send(std::to_string(i)));
+  }
+  auto extra = std::string {"extra"};
+  ASSERT_FALSE(channel.try_send(std::move(extra)));
+  ASSERT_EQ(extra, "extra"); // left untouched
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(channel.try_recv(), std::to_string(i));
+  }
+  ASSERT_FALSE(channel.try_recv());
+}
+
+TEST(ChannelTest, CloseDrainsTheBuffer)
+{
+  auto rt = Runtime(2);
+  rt.block([]() -> async::Task<> {
+    auto channel = async::Channel<int>(4);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_TRUE(co_await channel.send(i));
+    }
+    channel.close();
+    EXPECT_TRUE(channel.isClosed());
+    EXPECT_FALSE(channel.try_send(7));
+    EXPECT_FALSE(co_await channel.send(7));
+    // what was buffered before the close still comes out, in order
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(co_await channel.recv(), i);
+    }
+    EXPECT_EQ(co_await channel.recv(), std::nullopt);
+    auto out = std::vector<int> {};
+    EXPECT_EQ(co_await channel.recv_many(out, 8), 0);
+  }());
+}
+
+TEST(ChannelTest, FullBufferSuspendsSenders)
+{
+  auto rt = Runtime(2);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto channel = async::Channel<int>(2);
+    auto sent = std::atomic_int {0};
+    auto sender = async::JoinHandle([](async::Channel<int>& channel, std::atomic_int& sent) -> async::Task<> {
+      for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(co_await channel.send(i));
+        sent.fetch_add(1);
+      }
+    }(channel, sent));
+    rt.spawn(sender);
+    co_await rt.reactor().sleep(20ms);
+    // the third send waits for room
+    EXPECT_EQ(sent.load(), 2);
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(co_await channel.recv(), i);
+    }
+    co_await sender.join();
+    EXPECT_EQ(sent.load(), 5);
+  }(rt));
+}
+
+TEST(ChannelTest, EmptyBufferSuspendsReceivers)
+{
+  auto rt = Runtime(2);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto channel = async::Channel<int>(4);
+    auto received = std::atomic_bool {false};
+    auto receiver = async::JoinHandle([](async::Channel<int>& channel, std::atomic_bool& received) -> async::Task<int> {
+      auto value = co_await channel.recv();
+      received.store(true);
+      co_return value.value_or(-1);
+    }(channel, received));
+    rt.spawn(receiver);
+    co_await rt.reactor().sleep(20ms);
+    EXPECT_FALSE(received.load());
+    EXPECT_TRUE(co_await channel.send(42));
+    EXPECT_EQ(co_await receiver.join(), 42);
+  }(rt));
+}
+
+TEST(ChannelTest, CloseWakesParkedSides)
+{
+  auto rt = Runtime(2);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto empty = async::Channel<int>(2);
+    auto receiver = async::JoinHandle(
+        [](async::Channel<int>& channel) -> async::Task<std::optional<int>> { co_return co_await channel.recv(); }(
+            empty));
+    auto full = async::Channel<int>(2);
+    EXPECT_TRUE(full.try_send(1));
+    EXPECT_TRUE(full.try_send(2));
+    auto sender = async::JoinHandle(
+        [](async::Channel<int>& channel) -> async::Task<bool> { co_return co_await channel.send(3); }(full));
+    rt.spawn(receiver);
+    rt.spawn(sender);
+    co_await rt.reactor().sleep(20ms);
+    empty.close();
+    full.close();
+    EXPECT_EQ(co_await receiver.join(), std::nullopt);
+    EXPECT_FALSE(co_await sender.join());
+    EXPECT_EQ(full.try_recv(), 1);
+    EXPECT_EQ(full.try_recv(), 2);
+    EXPECT_EQ(full.try_recv(), std::nullopt);
+  }(rt));
+}
+
+template <async::ChannelMode Mode>
+static auto SumThrough(Runtime& rt, size_t capacity, int producers, int consumers, int64_t perProducer) -> int64_t
+{
+  return rt.block([](Runtime& rt, size_t capacity, int producers, int consumers,
+                     int64_t perProducer) -> async::Task<int64_t> {
+    auto channel = async::Channel<int64_t, Mode>(capacity);
+    auto produce = [](async::Channel<int64_t, Mode>& channel, int64_t from, int64_t count) -> async::Task<> {
+      for (auto i = from; i < from + count; ++i) {
+        EXPECT_TRUE(co_await channel.send(i));
+      }
+    };
+    auto consume = [](async::Channel<int64_t, Mode>& channel) -> async::Task<int64_t> {
+      auto sum = int64_t {0};
+      auto last = int64_t {-1};
+      auto batch = std::vector<int64_t> {};
+      while (co_await channel.recv_many(batch, 16) > 0) {
+        for (auto value : batch) {
+          if constexpr (Mode == async::ChannelMode::Spsc) {
+            EXPECT_EQ(value, last + 1);
+          }
+          last = value;
+          sum += value;
+        }
+        batch.clear();
+      }
+      co_return sum;
+    };
+    auto senders = std::vector<std::unique_ptr<async::JoinHandle<void>>> {};
+    auto receivers = std::vector<std::unique_ptr<async::JoinHandle<int64_t>>> {};
+    for (int i = 0; i < consumers; ++i) {
+      receivers.push_back(std::make_unique<async::JoinHandle<int64_t>>(consume(channel)));
+      rt.spawn(*receivers.back());
+    }
+    for (int i = 0; i < producers; ++i) {
+      senders.push_back(std::make_unique<async::JoinHandle<void>>(produce(channel, i * perProducer, perProducer)));
+      rt.spawn(*senders.back());
+    }
+    for (auto& sender : senders) {
+      co_await sender->join();
+    }
+    channel.close();
+    auto total = int64_t {0};
+    for (auto& receiver : receivers) {
+      total += co_await receiver->join();
+    }
+    co_return total;
+  }(rt, capacity, producers, consumers, perProducer));
+}
+
+TEST(ChannelTest, MpmcSum)
+{
+  auto rt = Runtime(4);
+  auto n = int64_t {4 * 20000};
+  ASSERT_EQ(SumThrough<async::ChannelMode::Mpmc>(rt, 8, 4, 4, n / 4), n * (n - 1) / 2);
+}
+
+TEST(ChannelTest, SpscInOrder)
+{
+  auto rt = Runtime(2);
+  auto n = int64_t {50000};
+  ASSERT_EQ(SumThrough<async::ChannelMode::Spsc>(rt, 4, 1, 1, n), n * (n - 1) / 2);
+}
@@ -0,0 +1,91 @@
+#include <Async/Executor.hpp>
+#include <Async/File.hpp>
+#include <Async/Runtime.hpp>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+static auto TempPath() -> std::string
+{
+  auto path = std::string {"/tmp/async_file_test_XXXXXX"};
+  auto fd = ::mkstemp(path.data());
+  ::close(fd);
+  return path;
+}
+
+static auto Bytes(std::string_view s) -> std::span<std::byte const> { return std::as_bytes(std::span(s)); }
+
+TEST(FileTest, ReadWriteAtOffset)
+{
+  auto rt = Runtime(1);
+  auto path = TempPath();
+  rt.block([](Runtime& rt, std::string const& path) -> async::Task<> {
+    auto file = async::File::Open(rt.reactor(), path, O_RDWR | O_TRUNC).value();
+    EXPECT_EQ(co_await file.writeAt(Bytes("world"), 6), 5u);
+    EXPECT_EQ(co_await file.writeAt(Bytes("hello "), 0), 6u);
+    EXPECT_EQ(file.size(), 11u);
+
+    // positional io leaves the cursor alone
+    auto buf = std::array<std::byte, 16> {};
+    EXPECT_EQ(co_await file.readAt(std::span(buf).first(5), 6), 5u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 5), "world");
+    EXPECT_EQ(co_await file.read(buf), 11u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 11), "hello world");
+    // at the end
+    EXPECT_EQ(co_await file.read(buf), 0u);
+    EXPECT_EQ(co_await file.readAt(buf, 100), 0u);
+  }(rt, path));
+  ::unlink(path.c_str());
+}
+
+TEST(FileTest, SequentialCursor)
+{
+  auto rt = Runtime(1);
+  auto path = TempPath();
+  rt.block([](Runtime& rt, std::string const& path) -> async::Task<> {
+    auto file = async::File::Open(rt.reactor(), path, O_RDWR | O_TRUNC).value();
+    auto cursor = uint64_t {0};
+    for (auto part : {"ab", "cde", "f"}) {
+      EXPECT_TRUE(co_await file.writeAt(Bytes(part), cursor, &cursor));
+    }
+    EXPECT_EQ(cursor, 6);
+    EXPECT_EQ(co_await file.write(Bytes("xy")), 2u);
+
+    file.seek(4);
+    auto buf = std::array<std::byte, 8> {};
+    EXPECT_EQ(co_await file.read(buf), 2u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 2), "ef");
+    file.seek(0);
+    EXPECT_EQ(co_await file.read(std::span(buf).first(2)), 2u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 2), "xy");
+  }(rt, path));
+  ::unlink(path.c_str());
+}
+
+TEST(FileTest, OpenMissing)
+{
+  auto rt = Runtime(1);
+  auto file = async::File::Open(rt.reactor(), "/tmp/async_file_test_missing/none");
+  ASSERT_FALSE(file);
+  ASSERT_EQ(file.error(), std::errc::no_such_file_or_directory);
+}
+
+TEST(FileTest, BlockingPoolFallback)
+{
+  auto rt = Runtime(1);
+  auto path = TempPath();
+  rt.block([](Runtime& rt, std::string const& path) -> async::Task<> {
+    auto file = async::File::Open(rt.reactor(), path, O_RDWR | O_TRUNC).value();
+    // only taken without a completion poller
+    file.setBlockingPool(&rt.executor().blockingPool());
+    EXPECT_EQ(co_await file.write(Bytes("hello")), size_t {5});
+    auto buf = std::array<std::byte, 16> {};
+    EXPECT_EQ(co_await file.readAt(buf, 0), size_t {5});
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 5), "hello");
+  }(rt, path));
+  ::unlink(path.c_str());
+}
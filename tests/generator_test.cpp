@@ -0,0 +1,196 @@
+#include <Async/Executor.hpp>
+#include <Async/Generator.hpp>
+#include <Async/Runtime.hpp>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+using namespace std::chrono_literals;
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+// can't be copied, counts how often it was moved
+struct MoveOnly {
+  int value;
+  int* moves;
+
+  MoveOnly(int value, int* moves) : value(value), moves(moves) {}
+  MoveOnly(MoveOnly const&) = delete;
+  MoveOnly(MoveOnly&& other) noexcept : value(std::exchange(other.value, -1)), moves(other.moves) { *moves += 1; }
+  MoveOnly& operator=(MoveOnly const&) = delete;
+  MoveOnly& operator=(MoveOnly&&) = delete;
+};
+
+// sets `flag` once the frame it lives in is destroyed
+struct SetOnExit {
+  std::atomic_bool& flag;
+  ~SetOnExit() { flag.store(true); }
+};
+
+static auto Count(int n) -> async::Generator<int>
+{
+  for (int i = 0; i < n; ++i) {
+    co_yield i;
+  }
+}
+
+static auto CountAsync(async::Reactor& reactor, int n) -> async::AsyncGenerator<int>
+{
+  for (int i = 0; i < n; ++i) {
+    co_await reactor.sleep(1ms);
+    co_yield i;
+  }
+}
+
+// yields a temporary, then an lvalue that must be left moved from
+static auto Owned(int* moves, int& leftOver) -> async::Generator<MoveOnly>
+{
+  co_yield MoveOnly {1, moves};
+  auto kept = MoveOnly {2, moves};
+  co_yield kept;
+  leftOver = kept.value;
+}
+
+static auto OwnedAsync(async::Reactor& reactor, int* moves, int& leftOver) -> async::AsyncGenerator<MoveOnly>
+{
+  co_await reactor.sleep(1ms);
+  co_yield MoveOnly {1, moves};
+  auto kept = MoveOnly {2, moves};
+  co_await reactor.sleep(1ms);
+  co_yield kept;
+  leftOver = kept.value;
+}
+
+static auto ThrowsAfter(int n) -> async::Generator<int>
+{
+  for (int i = 0; i < n; ++i) {
+    co_yield i;
+  }
+  throw std::runtime_error("boom");
+}
+
+static auto ThrowsAfterAsync(async::Reactor& reactor, int n) -> async::AsyncGenerator<int>
+{
+  for (int i = 0; i < n; ++i) {
+    co_await reactor.sleep(1ms);
+    co_yield i;
+  }
+  throw std::runtime_error("boom");
+}
+
+TEST(GeneratorTest, RangeFor)
+{
+  auto seen = std::vector<int> {};
+  for (auto value : Count(5)) {
+    seen.push_back(value);
+  }
+  EXPECT_EQ(seen, (std::vector<int> {0, 1, 2, 3, 4}));
+  for ([[maybe_unused]] auto value : Count(0)) {
+    ADD_FAILURE();
+  }
+}
+
+TEST(GeneratorTest, MovedOutWithoutCopies)
+{
+  auto moves = 0;
+  auto leftOver = 0;
+  auto taken = std::vector<int> {};
+  for (auto& value : Owned(&moves, leftOver)) {
+    auto mine = std::move(value);
+    taken.push_back(mine.value);
+  }
+  EXPECT_EQ(taken, (std::vector<int> {1, 2}));
+  EXPECT_EQ(moves, 2); // once out of each yielded object, never into the promise
+  EXPECT_EQ(leftOver, -1);
+}
+
+TEST(GeneratorTest, ExceptionsReachTheCaller)
+{
+  auto empty = ThrowsAfter(0);
+  EXPECT_THROW(empty.begin(), std::runtime_error);
+
+  auto gen = ThrowsAfter(2);
+  auto it = gen.begin();
+  EXPECT_EQ(*it, 0);
+  ++it;
+  EXPECT_EQ(*it, 1);
+  EXPECT_THROW(++it, std::runtime_error);
+  EXPECT_TRUE(it == gen.end());
+}
+
+TEST(AsyncGeneratorTest, RangeFor)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto seen = std::vector<int> {};
+    auto gen = CountAsync(reactor, 5);
+    for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+      seen.push_back(*it);
+    }
+    EXPECT_EQ(seen, (std::vector<int> {0, 1, 2, 3, 4}));
+    auto none = CountAsync(reactor, 0);
+    EXPECT_EQ(co_await none.next(), nullptr);
+  }(rt.reactor()));
+}
+
+TEST(AsyncGeneratorTest, MovedOutWithoutCopies)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto moves = 0;
+    auto leftOver = 0;
+    auto taken = std::vector<int> {};
+    auto gen = OwnedAsync(reactor, &moves, leftOver);
+    while (auto value = co_await gen.next()) {
+      auto mine = std::move(*value);
+      taken.push_back(mine.value);
+    }
+    EXPECT_EQ(taken, (std::vector<int> {1, 2}));
+    EXPECT_EQ(moves, 2);
+    EXPECT_EQ(leftOver, -1);
+  }(rt.reactor()));
+}
+
+TEST(AsyncGeneratorTest, ExceptionsReachTheConsumer)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto gen = ThrowsAfterAsync(reactor, 1);
+    auto first = co_await gen.next();
+    EXPECT_NE(first, nullptr);
+    EXPECT_THROW(co_await gen.next(), std::runtime_error);
+    EXPECT_EQ(co_await gen.next(), nullptr);
+
+    auto other = ThrowsAfterAsync(reactor, 1);
+    auto it = co_await other.begin();
+    EXPECT_EQ(*it, 0);
+    EXPECT_THROW(co_await ++it, std::runtime_error);
+    EXPECT_TRUE(it == other.end());
+  }(rt.reactor()));
+}
+
+TEST(AsyncGeneratorTest, DroppedEarly)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto unwound = std::atomic_bool {false};
+    auto endless = [](async::Reactor& reactor, std::atomic_bool& unwound) -> async::AsyncGenerator<int> {
+      auto guard = SetOnExit {unwound};
+      for (int i = 0;; ++i) {
+        co_await reactor.sleep(1ms);
+        co_yield i;
+      }
+    };
+    {
+      auto gen = endless(reactor, unwound);
+      for (int i = 0; i < 3; ++i) {
+        auto value = co_await gen.next();
+        EXPECT_EQ(*value, i);
+      }
+      EXPECT_FALSE(unwound.load());
+    } // resumed by the reactor each time, dropped at its `co_yield`
+    EXPECT_TRUE(unwound.load());
+    EXPECT_EQ(reactor.pendingTimers(), 0);
+  }(rt.reactor()));
+}
@@ -0,0 +1,74 @@
+#include <Async/ThreadPool.hpp>
+#include <Async/utils/Metrics.hpp>
+#include <gtest/gtest.h>
+
+using async::HistogramSnapshot;
+
+TEST(MetricsTest, BucketsAreExactBelowSubAndBoundedAbove)
+{
+  for (uint64_t v = 0; v < HistogramSnapshot::SUB; ++v) {
+    ASSERT_EQ(HistogramSnapshot::BucketOf(v), v);
+    ASSERT_EQ(HistogramSnapshot::LowerBound(v), v);
+  }
+  for (uint64_t v : {8ull, 9ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, (1ull << 39) + 5}) {
+    auto bucket = HistogramSnapshot::BucketOf(v);
+    auto lower = HistogramSnapshot::LowerBound(bucket);
+    auto upper = HistogramSnapshot::LowerBound(bucket + 1);
+    ASSERT_LE(lower, v);
+    ASSERT_LT(v, upper);
+    ASSERT_LE(upper - lower, lower / HistogramSnapshot::SUB + 1);
+  }
+  ASSERT_EQ(HistogramSnapshot::BucketOf(uint64_t(1) << 50), HistogramSnapshot::BUCKETS - 1);
+}
+
+TEST(MetricsTest, Percentiles)
+{
+  auto histogram = HistogramSnapshot {};
+  ASSERT_EQ(histogram.percentile(0.99), 0);
+  for (uint64_t v = 1; v <= 1000; ++v) {
+    histogram.counts[HistogramSnapshot::BucketOf(v)] += 1;
+    histogram.count += 1;
+    histogram.sum += v;
+    histogram.max = std::max(histogram.max, v);
+  }
+  ASSERT_DOUBLE_EQ(histogram.mean(), 500.5);
+  auto p50 = histogram.percentile(0.5);
+  ASSERT_GE(p50, 500);
+  ASSERT_LE(p50, 500 + 500 / HistogramSnapshot::SUB);
+  ASSERT_EQ(histogram.percentile(1.0), 1000);
+
+  auto merged = histogram;
+  merged.merge(histogram);
+  ASSERT_EQ(merged.count, 2000);
+  ASSERT_EQ(merged.percentile(0.5), p50);
+}
+
+TEST(MetricsTest, PoolCountsTasks)
+{
+  auto before = async::Metrics::snapshot().total;
+  auto done = std::atomic_int {0};
+  auto tasks = std::vector<async::Task<>> {};
+  {
+    auto pool = async::StealingThreadPool(2);
+    auto task = [](std::atomic_int& done) -> async::Task<> {
+      done.fetch_add(1);
+      co_return;
+    };
+    for (int i = 0; i < 100; ++i) {
+      tasks.push_back(task(done));
+      pool.execute(tasks.back().handle());
+    }
+    while (done.load() < 100) {
+      std::this_thread::yield();
+    }
+  }
+  auto snapshot = async::Metrics::snapshot();
+  if constexpr (async::Metrics::ENABLED) {
+    ASSERT_EQ(snapshot.total[async::Counter::Tasks] - before[async::Counter::Tasks], 100);
+    ASSERT_EQ(snapshot.total[async::Counter::Injected] - before[async::Counter::Injected], 100);
+  } else {
+    ASSERT_TRUE(snapshot.threads.empty());
+    ASSERT_EQ(snapshot.total[async::Counter::Tasks], 0);
+  }
+  ASSERT_NE(snapshot.toPrometheus().find("async_tasks_total"), std::string::npos);
+}
@@ -0,0 +1,281 @@
+#include <Async/Executor.hpp>
+#include <Async/Net.hpp>
+#include <Async/Runtime.hpp>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+using namespace std::chrono_literals;
+
+static auto Loopback() -> async::SocketAddr { return async::SocketAddr::V4(INADDR_LOOPBACK, 0); }
+
+static auto Bytes(std::string_view s) -> std::span<std::byte const> { return std::as_bytes(std::span(s)); }
+
+// everything `stream` receives until the peer shuts down
+static auto ReadToEnd(async::TcpStream& stream) -> async::Task<std::string>
+{
+  auto out = std::string {};
+  auto buf = std::array<std::byte, 4096> {};
+  while (true) {
+    auto n = co_await stream.read(buf);
+    EXPECT_TRUE(n);
+    if (!n || n.value() == 0) {
+      co_return out;
+    }
+    out.append(reinterpret_cast<char const*>(buf.data()), n.value());
+  }
+}
+
+static auto Pattern(size_t n) -> std::string
+{
+  auto out = std::string(n, '\0');
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = static_cast<char>(i * 131 % 251 + (i >> 13));
+  }
+  return out;
+}
+
+// what the peer of a fresh loopback connection receives while `send` writes to it
+template <typename Send>
+static auto Transfer(Runtime& rt, Send send) -> std::string
+{
+  return rt.block([](Runtime& rt, Send send) -> async::Task<std::string> {
+    auto listener = async::TcpListener::Bind(rt.reactor(), Loopback()).value();
+    auto connected = co_await async::TcpStream::Connect(rt.reactor(), listener.localAddr().value());
+    auto accepted = co_await listener.accept();
+    auto client = std::move(connected).value();
+    auto server = std::move(accepted).value();
+    auto reader = async::JoinHandle(ReadToEnd(server));
+    rt.spawn(reader);
+    co_await send(client);
+    EXPECT_TRUE(client.shutdown());
+    co_return co_await reader.join();
+  }(rt, std::move(send)));
+}
+
+// a temp file holding `data`, removed with the fd
+struct TempFile {
+  int fd = -1;
+  explicit TempFile(std::string_view data)
+  {
+    char path[] = "/tmp/async_net_test_XXXXXX";
+    fd = ::mkstemp(path);
+    ::unlink(path);
+    EXPECT_EQ(::write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+  }
+  ~TempFile() { ::close(fd); }
+};
+
+TEST(NetTest, AcceptAndConnect)
+{
+  auto rt = Runtime(2);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto listener = async::TcpListener::Bind(rt.reactor(), Loopback()).value();
+    auto addr = listener.localAddr().value();
+    EXPECT_NE(addr.port(), 0);
+    // nobody connects yet, the accept parks on the listener
+    auto accepted = async::JoinHandle([](async::TcpListener& listener) -> async::Task<StdResult<async::TcpStream>> {
+      co_return co_await listener.accept();
+    }(listener));
+    rt.spawn(accepted);
+    co_await rt.reactor().sleep(std::chrono::milliseconds(10));
+    auto client = co_await async::TcpStream::Connect(rt.reactor(), addr);
+    EXPECT_TRUE(client);
+    auto server = co_await accepted.join();
+    EXPECT_TRUE(server);
+    EXPECT_EQ(client->localAddr()->port(), server->peerAddr()->port());
+    EXPECT_EQ(client->peerAddr()->port(), addr.port());
+  }(rt));
+}
+
+TEST(NetTest, ConnectRefused)
+{
+  auto rt = Runtime(1);
+  auto addr = [&] {
+    // a port that was just free
+    auto listener = async::TcpListener::Bind(rt.reactor(), Loopback()).value();
+    return listener.localAddr().value();
+  }();
+  auto client = rt.block(async::TcpStream::Connect(rt.reactor(), addr));
+  ASSERT_FALSE(client);
+  ASSERT_EQ(client.error(), std::errc::connection_refused);
+}
+
+TEST(NetTest, ReadWriteAllAndEof)
+{
+  auto rt = Runtime(2);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto listener = async::TcpListener::Bind(rt.reactor(), Loopback()).value();
+    auto client = (co_await async::TcpStream::Connect(rt.reactor(), listener.localAddr().value())).value();
+    auto server = (co_await listener.accept()).value();
+    auto reader = async::JoinHandle(ReadToEnd(server));
+    rt.spawn(reader);
+    // larger than the socket buffers, the writer has to wait for the reader
+    auto message = std::string(4 << 20, '\0');
+    for (size_t i = 0; i < message.size(); ++i) {
+      message[i] = static_cast<char>(i * 131 % 251);
+    }
+    EXPECT_TRUE(co_await client.writeAll(Bytes(message)));
+    EXPECT_TRUE(client.shutdown());
+    EXPECT_TRUE(co_await reader.join() == message);
+
+    // both directions closed, reads keep reporting the end
+    auto buf = std::array<std::byte, 16> {};
+    EXPECT_EQ(co_await server.read(buf), 0u);
+    EXPECT_TRUE(server.shutdown());
+    EXPECT_EQ(co_await client.read(buf), 0u);
+  }(rt));
+}
+
+TEST(NetTest, UdpRoundTrip)
+{
+  auto rt = Runtime(2);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto a = async::UdpSocket::Bind(rt.reactor(), Loopback()).value();
+    auto b = async::UdpSocket::Bind(rt.reactor(), Loopback()).value();
+    auto aAddr = a.localAddr().value();
+    auto bAddr = b.localAddr().value();
+    // b waits before anything is sent
+    auto echo = async::JoinHandle([](async::UdpSocket& b) -> async::Task<StdResult<size_t>> {
+      auto buf = std::array<std::byte, 64> {};
+      auto from = async::SocketAddr {};
+      auto n = co_await b.recvFrom(buf, from);
+      if (!n) {
+        co_return n;
+      }
+      co_return co_await b.sendTo(std::span(buf).first(n.value()), from);
+    }(b));
+    rt.spawn(echo);
+    co_await rt.reactor().sleep(std::chrono::milliseconds(10));
+    EXPECT_EQ(co_await a.sendTo(Bytes("ping"), bAddr), 4u);
+    EXPECT_EQ(co_await echo.join(), 4u);
+
+    auto buf = std::array<std::byte, 64> {};
+    auto from = async::SocketAddr {};
+    EXPECT_EQ(co_await a.recvFrom(buf, from), 4u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 4), "ping");
+    EXPECT_EQ(from.port(), bAddr.port());
+
+    // connected sockets use the default peer
+    EXPECT_TRUE(a.connect(bAddr));
+    EXPECT_TRUE(b.connect(aAddr));
+    EXPECT_EQ(co_await b.send(Bytes("pong!")), 5u);
+    EXPECT_EQ(co_await a.recv(buf), 5u);
+    EXPECT_EQ(std::string_view(reinterpret_cast<char const*>(buf.data()), 5), "pong!");
+  }(rt));
+}
+
+TEST(NetTest, WritevAll)
+{
+  auto rt = Runtime(2);
+  auto data = Pattern(1 << 20);
+  auto got = Transfer(rt, [&data](async::TcpStream& stream) -> async::Task<> {
+    // nothing to send, returns without a syscall that could fail
+    EXPECT_TRUE(co_await stream.writevAll({}));
+    auto base = data.data();
+    auto bufs = std::vector<iovec> {{nullptr, 0}, {base, 1000}, {nullptr, 0}, {base + 1000, 200000}};
+    // more than one sendmsg takes, split into batches of IOV_MAX
+    for (size_t at = 201000; at + 100 <= data.size() && bufs.size() < IOV_MAX + 500; at += 100) {
+      bufs.push_back({base + at, 100});
+    }
+    bufs.push_back({nullptr, 0});
+    EXPECT_GT(bufs.size(), IOV_MAX);
+    EXPECT_TRUE(co_await stream.writevAll(bufs));
+  });
+  ASSERT_EQ(got.size(), 201000 + (IOV_MAX + 500 - 4) * 100);
+  ASSERT_TRUE(got == data.substr(0, got.size()));
+}
+
+TEST(NetTest, SendFileAll)
+{
+  auto rt = Runtime(2);
+  auto data = Pattern(3 << 20);
+  auto file = TempFile(data);
+  // a part from the middle, then a range running past the end, which stops at the end
+  auto got = Transfer(rt, [&](async::TcpStream& stream) -> async::Task<> {
+    EXPECT_EQ(co_await stream.sendFileAll(file.fd, 100, 2 << 20), size_t {2} << 20);
+    EXPECT_EQ(co_await stream.sendFileAll(file.fd, data.size() - 10, 1000), 10u);
+  });
+  ASSERT_TRUE(got == data.substr(100, 2 << 20) + data.substr(data.size() - 10));
+}
+
+TEST(NetTest, SpliceFrom)
+{
+  auto rt = Runtime(2);
+  auto data = Pattern(3 << 20);
+  auto file = TempFile(data);
+  auto got = Transfer(rt, [&](async::TcpStream& stream) -> async::Task<> {
+    EXPECT_EQ(co_await stream.spliceFrom(file.fd, 7, 2 << 20), size_t {2} << 20);
+    EXPECT_EQ(co_await stream.spliceFrom(file.fd, data.size() - 5, 1000), 5u);
+  });
+  ASSERT_TRUE(got == data.substr(7, 2 << 20) + data.substr(data.size() - 5));
+}
+
+TEST(NetTest, SendZeroCopy)
+{
+  auto rt = Runtime(2);
+  auto data = Pattern(4 << 20);
+  auto result = StdResult<void> {};
+  auto got = Transfer(rt, [&](async::TcpStream& stream) -> async::Task<> {
+    result = co_await stream.sendZeroCopy(Bytes(data));
+    // a second send reuses the socket option and the notification count
+    if (result) {
+      result = co_await stream.sendZeroCopy(Bytes(data).first(1000));
+    }
+  });
+  if (!result && result.error() == std::errc::operation_not_supported) {
+    GTEST_SKIP() << "no MSG_ZEROCOPY";
+  }
+  ASSERT_TRUE(result);
+  ASSERT_TRUE(got == data + data.substr(0, 1000));
+}
+
+TEST(NetTest, StaleEdgeWaitsAgain)
+{
+  auto rt = Runtime(2);
+  int fds[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds), 0);
+  auto peer = fds[1];
+  rt.block([](Runtime& rt, int fd, int peer) -> async::Task<> {
+    auto io = async::IoHandle::Create(rt.reactor(), fd).value();
+    auto calls = std::atomic_int {0};
+    auto resumed = std::atomic_bool {false};
+    auto reader = [](async::IoHandle& io, std::atomic_int& calls, std::atomic_bool& resumed) -> async::Task<char> {
+      auto c = char {};
+      auto n = co_await io.io(async::Interest::Read, [&]() -> StdResult<size_t> {
+        if (calls.fetch_add(1) == 1) {
+          // somebody else drains the byte before the retry, the edge turns out stale
+          auto stolen = char {};
+          EXPECT_EQ(::recv(io.fd(), &stolen, 1, 0), 1);
+        }
+        return SysCall(::recv, io.fd(), &c, 1, 0).map([](auto n) { return static_cast<size_t>(n); });
+      });
+      resumed = true;
+      EXPECT_EQ(n, size_t {1});
+      co_return c;
+    };
+    auto handle = async::JoinHandle(reader(io, calls, resumed));
+    rt.spawn(handle);
+    while (calls < 1) {
+      co_await rt.reactor().sleep(1ms);
+    }
+    EXPECT_EQ(::write(peer, "a", 1), 1);
+    while (calls < 2) {
+      co_await rt.reactor().sleep(1ms);
+    }
+    co_await rt.reactor().sleep(10ms);
+    EXPECT_FALSE(resumed);
+    EXPECT_EQ(::write(peer, "b", 1), 1);
+    EXPECT_EQ(co_await handle.join(), 'b');
+    EXPECT_EQ(calls, 3);
+  }(rt, fds[0], peer));
+  ::close(peer);
+}
@@ -0,0 +1,446 @@
+#include <Async/Executor.hpp>
+#include <Async/Primitives.hpp>
+#include <Async/Runtime.hpp>
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <gtest/gtest.h>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+// Runs `task` on the calling thread until it first suspends. Outside an executor `ExecutorRef::Current()` is empty,
+// so whoever wakes it resumes it inline: the tests below are deterministic.
+template <typename T>
+static auto Start(async::Task<T>& task) -> void
+{
+  task.handle().resume();
+}
+
+static auto Locker(async::Mutex& mutex, std::vector<int>& order, int id) -> async::Task<>
+{
+  auto locked = co_await mutex.lock();
+  EXPECT_TRUE(locked);
+  order.push_back(id);
+  mutex.unlock();
+}
+
+TEST(MutexTest, FifoHandoff)
+{
+  auto mutex = async::Mutex {};
+  auto order = std::vector<int> {};
+  ASSERT_TRUE(mutex.try_lock());
+  auto tasks = std::vector<async::Task<>> {};
+  for (int i = 0; i < 50; ++i) {
+    tasks.push_back(Locker(mutex, order, i));
+    Start(tasks.back());
+  }
+  EXPECT_TRUE(order.empty());
+  // each holder passes the lock on to the oldest waiter
+  mutex.unlock();
+  ASSERT_EQ(order.size(), 50u);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(order[i], i);
+  }
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST(MutexTest, ExclusiveUnderContention)
+{
+  auto rt = Runtime(4);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto mutex = async::Mutex {};
+    auto inside = std::atomic_int {0};
+    auto count = 0;
+    auto worker = [](async::Mutex& mutex, std::atomic_int& inside, int& count) -> async::Task<> {
+      for (int i = 0; i < 2000; ++i) {
+        co_await mutex.lock();
+        EXPECT_EQ(inside.fetch_add(1), 0);
+        count += 1;
+        inside.fetch_sub(1);
+        mutex.unlock();
+      }
+    };
+    auto handles = std::vector<std::unique_ptr<async::JoinHandle<void>>> {};
+    for (int i = 0; i < 8; ++i) {
+      handles.push_back(std::make_unique<async::JoinHandle<void>>(worker(mutex, inside, count)));
+      rt.spawn(*handles.back());
+    }
+    for (auto& handle : handles) {
+      co_await handle->join();
+    }
+    EXPECT_EQ(count, 8 * 2000);
+  }(rt));
+}
+
+static auto CancellableLocker(async::Mutex& mutex, int& result) -> async::Task<>
+{
+  auto locked = co_await mutex.lock();
+  result = locked ? 1 : 0;
+  if (locked) {
+    mutex.unlock();
+  } else {
+    EXPECT_EQ(locked.error(), std::errc::operation_canceled);
+  }
+}
+
+TEST(MutexTest, CancelQueuedLock)
+{
+  auto mutex = async::Mutex {};
+  ASSERT_TRUE(mutex.try_lock());
+  auto stop = std::stop_source {};
+  auto result = -1;
+  auto task = async::withStop(CancellableLocker(mutex, result), stop.get_token());
+  Start(task);
+  EXPECT_EQ(result, -1);
+  // published: the stop request resumes it without the lock
+  stop.request_stop();
+  EXPECT_TRUE(task.done());
+  EXPECT_EQ(result, 0);
+  // the holder skips the cancelled node
+  mutex.unlock();
+  EXPECT_TRUE(mutex.try_lock());
+  mutex.unlock();
+}
+
+TEST(MutexTest, CancelRacesPublishing)
+{
+  auto mutex = async::Mutex {};
+  auto results = std::array<int, 2> {};
+  for (int round = 0; round < 2000; ++round) {
+    ASSERT_TRUE(mutex.try_lock());
+    auto stop = std::stop_source {};
+    auto result = -1;
+    auto task = async::withStop(CancellableLocker(mutex, result), stop.get_token());
+    // the stop request lands before, while or after the node is published
+    auto waiter = std::thread([&]() { Start(task); });
+    auto canceller = std::thread([&]() { stop.request_stop(); });
+    waiter.join();
+    canceller.join();
+    mutex.unlock();
+    ASSERT_TRUE(task.done());
+    ASSERT_NE(result, -1);
+    results[result] += 1;
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.unlock();
+  }
+  EXPECT_GT(results[0], 0);
+}
+
+static auto Waiting(async::CondVar& condVar, std::vector<int>& order, int id) -> async::Task<>
+{
+  co_await condVar.wait();
+  order.push_back(id);
+}
+
+TEST(CondVarTest, NotifyOneInOrder)
+{
+  auto condVar = async::CondVar {};
+  EXPECT_FALSE(condVar.notify_one());
+  condVar.notify_all();
+  auto order = std::vector<int> {};
+  auto tasks = std::vector<async::Task<>> {};
+  for (int i = 0; i < 3; ++i) {
+    tasks.push_back(Waiting(condVar, order, i));
+    Start(tasks.back());
+  }
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(condVar.notify_one());
+    ASSERT_EQ(order.size(), static_cast<size_t>(i + 1));
+    EXPECT_EQ(order.back(), i);
+  }
+  EXPECT_FALSE(condVar.notify_one());
+}
+
+TEST(CondVarTest, NotifyAllWakesEveryone)
+{
+  auto condVar = async::CondVar {};
+  auto order = std::vector<int> {};
+  auto tasks = std::vector<async::Task<>> {};
+  for (int i = 0; i < 2; ++i) {
+    tasks.push_back(Waiting(condVar, order, i));
+    Start(tasks.back());
+  }
+  // one already drained by notify_one, one still on the pushed stack
+  EXPECT_TRUE(condVar.notify_one());
+  for (int i = 2; i < 4; ++i) {
+    tasks.push_back(Waiting(condVar, order, i));
+    Start(tasks.back());
+  }
+  condVar.notify_all();
+  EXPECT_EQ(order, (std::vector<int> {0, 1, 2, 3}));
+  EXPECT_FALSE(condVar.notify_one());
+}
+
+// every notifier starts only after its waiter is queued, so each one must find somebody to wake, also while
+// another notifier is draining the stack
+TEST(CondVarTest, NotifyFindsQueuedWaiters)
+{
+  for (int round = 0; round < 2000; ++round) {
+    auto condVar = async::CondVar {};
+    auto woken = std::atomic_int {0};
+    auto waiter = [](async::CondVar& condVar, std::atomic_int& woken) -> async::Task<> {
+      co_await condVar.wait();
+      woken.fetch_add(1);
+    };
+    auto tasks = std::array<async::Task<>, 2> {waiter(condVar, woken), waiter(condVar, woken)};
+    auto queued = std::array<std::atomic_bool, 2> {};
+    auto notified = std::array<bool, 2> {};
+    auto threads = std::vector<std::thread> {};
+    for (int i = 0; i < 2; ++i) {
+      threads.emplace_back([&, i]() {
+        Start(tasks[i]);
+        queued[i].store(true, std::memory_order_release);
+      });
+      threads.emplace_back([&, i]() {
+        while (!queued[i].load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+        notified[i] = condVar.notify_one();
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ASSERT_TRUE(notified[0] && notified[1]) << round;
+    ASSERT_EQ(woken.load(), 2);
+  }
+}
+
+// stands in for an executor, queues what it is given
+struct QueueingExecutor {
+  std::vector<std::coroutine_handle<>> queued;
+  auto execute(std::coroutine_handle<> handle) -> void { queued.push_back(handle); }
+};
+
+static auto Handoff(async::Mutex& mutex, std::vector<int>& order) -> async::Task<>
+{
+  co_await mutex.lock();
+  order.push_back(0);
+  co_await std::suspend_always {}; // the test queues a waiter here
+  co_await mutex.handoff();
+  order.push_back(2);
+}
+
+TEST(MutexTest, HandoffLeavesOtherExecutorsWaiter)
+{
+  auto mutex = async::Mutex {};
+  auto order = std::vector<int> {};
+  auto theirs = QueueingExecutor {};
+  auto ours = QueueingExecutor {};
+  auto holder = Handoff(mutex, order);
+  auto waiter = Locker(mutex, order, 1);
+  auto previous = async::ExecutorRef::SetCurrent(ours);
+  Start(holder);
+  async::ExecutorRef::SetCurrent(theirs);
+  Start(waiter);
+  async::ExecutorRef::SetCurrent(ours);
+  holder.handle().resume(); // hands the lock off
+  async::ExecutorRef::SetCurrent(previous);
+  // queued on its own executor, the holder went on without switching
+  EXPECT_TRUE(holder.done());
+  EXPECT_TRUE(ours.queued.empty());
+  ASSERT_EQ(theirs.queued.size(), 1u);
+  EXPECT_EQ(theirs.queued[0], waiter.handle());
+  theirs.queued[0].resume();
+  EXPECT_EQ(order, (std::vector<int> {0, 2, 1}));
+}
+
+TEST(MutexTest, HandoffSwitchesToSameExecutorsWaiter)
+{
+  auto mutex = async::Mutex {};
+  auto order = std::vector<int> {};
+  auto ours = QueueingExecutor {};
+  auto holder = Handoff(mutex, order);
+  auto waiter = Locker(mutex, order, 1);
+  auto previous = async::ExecutorRef::SetCurrent(ours);
+  Start(holder);
+  Start(waiter);
+  holder.handle().resume();
+  // the waiter ran right away by symmetric transfer, the holder is queued behind it
+  EXPECT_EQ(order, (std::vector<int> {0, 1}));
+  ASSERT_EQ(ours.queued.size(), 1u);
+  EXPECT_EQ(ours.queued[0], holder.handle());
+  ours.queued[0].resume();
+  async::ExecutorRef::SetCurrent(previous);
+  EXPECT_TRUE(holder.done());
+  EXPECT_EQ(order, (std::vector<int> {0, 1, 2}));
+}
+
+static auto Reader(async::RwLock& rw, std::vector<int>& order, int id) -> async::Task<>
+{
+  co_await rw.lock_shared();
+  order.push_back(id);
+}
+
+static auto Writer(async::RwLock& rw, std::vector<int>& order, int id) -> async::Task<>
+{
+  co_await rw.lock();
+  order.push_back(id);
+}
+
+TEST(RwLockTest, WritersFirstThenReadersInOneBatch)
+{
+  auto rw = async::RwLock {};
+  auto order = std::vector<int> {};
+  ASSERT_TRUE(rw.try_lock_shared());
+  auto first = Writer(rw, order, 1);
+  Start(first);
+  // a waiting writer keeps new readers out although only readers hold the lock
+  EXPECT_FALSE(rw.try_lock_shared());
+  auto readers = std::vector<async::Task<>> {};
+  readers.push_back(Reader(rw, order, 10));
+  Start(readers.back());
+  auto second = Writer(rw, order, 2);
+  Start(second);
+  readers.push_back(Reader(rw, order, 11));
+  Start(readers.back());
+  EXPECT_TRUE(order.empty());
+
+  rw.unlock_shared(); // the last reader out hands over to the oldest writer
+  EXPECT_EQ(order, (std::vector<int> {1}));
+  rw.unlock(); // to the next writer, the readers still wait
+  EXPECT_EQ(order, (std::vector<int> {1, 2}));
+  rw.unlock(); // the last writer leaves, every queued reader is in
+  EXPECT_EQ(order, (std::vector<int> {1, 2, 10, 11}));
+  EXPECT_FALSE(rw.try_lock());
+  EXPECT_TRUE(rw.try_lock_shared());
+  for (int i = 0; i < 3; ++i) {
+    rw.unlock_shared();
+  }
+  EXPECT_TRUE(rw.try_lock());
+  rw.unlock();
+}
+
+static auto Acquirer(async::Semaphore& sem, std::vector<int>& order, int id) -> async::Task<>
+{
+  co_await sem.acquire();
+  order.push_back(id);
+}
+
+TEST(SemaphoreTest, FifoPermits)
+{
+  auto sem = async::Semaphore(1);
+  auto order = std::vector<int> {};
+  auto tasks = std::vector<async::Task<>> {};
+  for (int i = 0; i < 4; ++i) {
+    tasks.push_back(Acquirer(sem, order, i));
+    Start(tasks.back());
+  }
+  EXPECT_EQ(order, (std::vector<int> {0}));
+  EXPECT_EQ(sem.available(), 0);
+  sem.release(2);
+  EXPECT_EQ(order, (std::vector<int> {0, 1, 2}));
+  EXPECT_EQ(sem.available(), 0);
+  sem.release(3);
+  EXPECT_EQ(order, (std::vector<int> {0, 1, 2, 3}));
+  EXPECT_EQ(sem.available(), 2);
+}
+
+constexpr int PERMITS = 3;
+
+TEST(SemaphoreTest, PermitsUnderContention)
+{
+  auto rt = Runtime(4);
+  rt.block([](Runtime& rt) -> async::Task<> {
+    auto sem = async::Semaphore(PERMITS);
+    auto inside = std::atomic_int {0};
+    auto peak = std::atomic_int {0};
+    auto worker = [](async::Semaphore& sem, std::atomic_int& inside, std::atomic_int& peak) -> async::Task<> {
+      for (int i = 0; i < 2000; ++i) {
+        co_await sem.acquire();
+        auto now = inside.fetch_add(1) + 1;
+        EXPECT_LE(now, PERMITS);
+        auto seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        inside.fetch_sub(1);
+        sem.release();
+      }
+    };
+    auto handles = std::vector<std::unique_ptr<async::JoinHandle<void>>> {};
+    for (int i = 0; i < 8; ++i) {
+      handles.push_back(std::make_unique<async::JoinHandle<void>>(worker(sem, inside, peak)));
+      rt.spawn(*handles.back());
+    }
+    for (auto& handle : handles) {
+      co_await handle->join();
+    }
+    EXPECT_EQ(sem.available(), PERMITS);
+    EXPECT_LE(peak.load(), PERMITS);
+  }(rt));
+}
+
+static auto LatchWaiter(async::Latch& latch, int& woken) -> async::Task<>
+{
+  co_await latch.wait();
+  woken += 1;
+}
+
+TEST(LatchTest, ReleasesOnceCountedDown)
+{
+  auto latch = async::Latch(3);
+  auto woken = 0;
+  auto a = LatchWaiter(latch, woken);
+  auto b = LatchWaiter(latch, woken);
+  Start(a);
+  Start(b);
+  latch.count_down(2);
+  EXPECT_EQ(woken, 0);
+  EXPECT_FALSE(latch.try_wait());
+  latch.count_down();
+  EXPECT_EQ(woken, 2);
+  EXPECT_TRUE(latch.try_wait());
+  // released for good, later waiters go straight through
+  auto late = LatchWaiter(latch, woken);
+  Start(late);
+  EXPECT_TRUE(late.done());
+  EXPECT_EQ(woken, 3);
+}
+
+// arrives `phases` times, logging (id, phase) before each arrival
+static auto Participant(async::Barrier& barrier, std::vector<std::pair<int, int>>& log, int id, int phases)
+    -> async::Task<>
+{
+  for (int phase = 0; phase < phases; ++phase) {
+    log.emplace_back(id, phase);
+    co_await barrier.arrive_and_wait();
+  }
+}
+
+TEST(BarrierTest, PhasesAreReused)
+{
+  auto barrier = async::Barrier(3);
+  auto log = std::vector<std::pair<int, int>> {};
+  auto tasks = std::vector<async::Task<>> {};
+  for (int id = 0; id < 3; ++id) {
+    tasks.push_back(Participant(barrier, log, id, 4));
+    Start(tasks.back());
+  }
+  for (auto& task : tasks) {
+    EXPECT_TRUE(task.done());
+  }
+  // nobody starts a phase before everyone arrived at the previous one
+  ASSERT_EQ(log.size(), 12u);
+  for (size_t i = 0; i < log.size(); ++i) {
+    EXPECT_EQ(log[i].second, static_cast<int>(i / 3)) << i;
+  }
+}
+
+TEST(BarrierTest, ArriveAndDrop)
+{
+  auto barrier = async::Barrier(3);
+  auto log = std::vector<std::pair<int, int>> {};
+  auto a = Participant(barrier, log, 0, 2);
+  auto b = Participant(barrier, log, 1, 2);
+  Start(a);
+  barrier.arrive_and_drop(); // counts for this phase
+  EXPECT_FALSE(a.done());
+  Start(b); // completes the first phase, the second one only expects two
+  EXPECT_TRUE(a.done());
+  EXPECT_TRUE(b.done());
+  EXPECT_EQ(log, (std::vector<std::pair<int, int>> {{0, 0}, {1, 0}, {0, 1}, {1, 1}}));
+}
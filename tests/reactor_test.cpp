@@ -0,0 +1,63 @@
+#include <Async/Reactor.hpp>
+#include <coroutine>
+#include <cstddef>
+#include <gtest/gtest.h>
+#include <vector>
+
+// never resumed, aligned like a real frame so the low bits stay free for the tags
+static auto Handle(size_t id) -> std::coroutine_handle<>
+{
+  return std::coroutine_handle<>::from_address(reinterpret_cast<void*>((id + 1) * alignof(std::max_align_t)));
+}
+
+// what the reactor does with one readiness event
+static auto Deliver(async::SourceRegistry& sources, uint64_t key) -> std::vector<std::coroutine_handle<>>
+{
+  auto handles = std::vector<std::coroutine_handle<>> {};
+  if (auto source = sources.find(key)) {
+    source->wake(true, true, handles);
+  }
+  return handles;
+}
+
+TEST(SourceRegistryTest, FindsLiveSources)
+{
+  auto sources = async::SourceRegistry {};
+  auto a = sources.insert(3, async::PollMode::Level);
+  auto b = sources.insert(4, async::PollMode::Level);
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_NE(a->key, b->key);
+  EXPECT_EQ(sources.find(a->key), a);
+  EXPECT_EQ(sources.find(b->key), b);
+  EXPECT_EQ(a->fd, 3);
+  EXPECT_EQ(b->fd, 4);
+}
+
+TEST(SourceRegistryTest, StaleKeyIsDropped)
+{
+  auto sources = async::SourceRegistry {};
+  auto old = sources.insert(3, async::PollMode::Edge);
+  ASSERT_NE(old, nullptr);
+  auto oldKey = old->key;
+  sources.remove(*old);
+  EXPECT_EQ(sources.find(oldKey), nullptr);
+
+  // the slot is reused under a new generation
+  auto reused = sources.insert(5, async::PollMode::Edge);
+  ASSERT_EQ(reused, old);
+  EXPECT_NE(reused->key, oldKey);
+  EXPECT_EQ(sources.find(oldKey), nullptr);
+  EXPECT_EQ(sources.find(reused->key), reused);
+
+  ASSERT_EQ(reused->setReadable(Handle(1)), true);
+  EXPECT_TRUE(Deliver(sources, oldKey).empty());
+  EXPECT_EQ(reused->takeReadable(), Handle(1)); // still waiting, the late event didn't wake it
+
+  // nor did it leave a cached edge behind for the next waiter
+  EXPECT_TRUE(Deliver(sources, oldKey).empty());
+  EXPECT_EQ(reused->setReadable(Handle(2)), true);
+  auto woken = Deliver(sources, reused->key);
+  ASSERT_EQ(woken.size(), 1u);
+  EXPECT_EQ(woken[0], Handle(2));
+}
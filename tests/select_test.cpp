@@ -0,0 +1,293 @@
+#include <Async/Executor.hpp>
+#include <Async/Runtime.hpp>
+#include <Async/Select.hpp>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+using Runtime = async::RuntimeInstance<async::MultiThreadExecutor>;
+
+// sleeps far past any deadline in these tests, `finished` is set once it unwound
+static auto Sleeper(async::Reactor& reactor, std::atomic_bool& finished) -> async::Task<int>
+{
+  auto r = co_await reactor.sleep(10s);
+  finished.store(true);
+  co_return r ? 1 : -1;
+}
+
+static auto WaitFor(async::Reactor& reactor, std::atomic_bool& flag) -> async::Task<bool>
+{
+  for (int i = 0; i < 1000 && !flag.load(); ++i) {
+    co_await reactor.sleep(1ms);
+  }
+  co_return flag.load();
+}
+
+TEST(SelectTest, TimeoutStopsTheTask)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto finished = std::atomic_bool {false};
+    auto start = async::TimePoint::clock::now();
+    auto r = co_await async::timeout(reactor, 10ms, Sleeper(reactor, finished));
+    EXPECT_FALSE(r);
+    EXPECT_EQ(r.error(), std::errc::timed_out);
+    EXPECT_LT(async::TimePoint::clock::now() - start, 5s);
+    // the branch gave its ten second timer back instead of holding it
+    EXPECT_TRUE(co_await WaitFor(reactor, finished));
+    EXPECT_EQ(reactor.pendingTimers(), 0);
+  }(rt.reactor()));
+}
+
+TEST(SelectTest, TimeoutFinishesFirst)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto quick = [](async::Reactor& reactor) -> async::Task<int> {
+      co_await reactor.sleep(1ms);
+      co_return 7;
+    };
+    EXPECT_EQ(co_await async::timeout(reactor, 10s, quick(reactor)), 7);
+    EXPECT_EQ(reactor.pendingTimers(), 0);
+  }(rt.reactor()));
+}
+
+TEST(SelectTest, WinnerStopsTheLosers)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto first = std::atomic_bool {false};
+    auto second = std::atomic_bool {false};
+    auto quick = [](async::Reactor& reactor) -> async::Task<> { co_await reactor.sleep(5ms); };
+    auto r = co_await async::select(Sleeper(reactor, first), quick(reactor), Sleeper(reactor, second));
+    EXPECT_EQ(r.index(), 1);
+    EXPECT_TRUE(co_await WaitFor(reactor, first));
+    EXPECT_TRUE(co_await WaitFor(reactor, second));
+    EXPECT_EQ(reactor.pendingTimers(), 0);
+  }(rt.reactor()));
+}
+
+TEST(SelectTest, ParentStopReachesTheBranches)
+{
+  auto rt = Runtime(2);
+  auto stop = std::stop_source {};
+  auto finished = std::atomic_bool {false};
+  auto parent = [](async::Reactor& reactor, std::atomic_bool& finished) -> async::Task<int> {
+    auto r = co_await async::timeout(reactor, 10s, Sleeper(reactor, finished));
+    co_return r ? r.value() : 0;
+  };
+  auto handle = async::JoinHandle(async::withStop(parent(rt.reactor(), finished), stop.get_token()));
+  rt.spawn(handle);
+  rt.block([](async::Reactor& reactor, std::stop_source& stop, auto& handle) -> async::Task<> {
+    co_await reactor.sleep(10ms);
+    stop.request_stop();
+    // the sleep saw the stop and the task finished before the deadline
+    EXPECT_EQ(co_await handle.join(), -1);
+  }(rt.reactor(), stop, handle));
+  ASSERT_TRUE(finished.load());
+  ASSERT_EQ(rt.reactor().pendingTimers(), 0);
+}
+
+// records what its sleep resumed with
+static auto Recorder(async::Reactor& reactor, std::atomic<std::errc>& seen, std::atomic_bool& finished)
+    -> async::Task<int>
+{
+  auto r = co_await reactor.sleep(10s);
+  seen.store(r ? std::errc {} : r.error());
+  finished.store(true);
+  co_return 0;
+}
+
+TEST(SelectTest, LosersSeeCanceled)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto quick = [](async::Reactor& reactor) -> async::Task<int> {
+      co_await reactor.sleep(5ms);
+      co_return 1;
+    };
+    {
+      auto seen = std::atomic<std::errc> {};
+      auto finished = std::atomic_bool {false};
+      auto r = co_await async::timeout(reactor, 5ms, Recorder(reactor, seen, finished));
+      EXPECT_EQ(r.error(), std::errc::timed_out);
+      EXPECT_TRUE(co_await WaitFor(reactor, finished));
+      EXPECT_EQ(seen.load(), std::errc::operation_canceled);
+    }
+    {
+      auto seen = std::atomic<std::errc> {};
+      auto finished = std::atomic_bool {false};
+      auto r = co_await async::select(quick(reactor), Recorder(reactor, seen, finished));
+      EXPECT_EQ(r.index(), 0);
+      EXPECT_TRUE(co_await WaitFor(reactor, finished));
+      EXPECT_EQ(seen.load(), std::errc::operation_canceled);
+    }
+    {
+      auto seen = std::array<std::atomic<std::errc>, 3> {};
+      auto finished = std::array<std::atomic_bool, 3> {};
+      auto tasks = std::vector<async::Task<int>> {};
+      tasks.push_back(Recorder(reactor, seen[0], finished[0]));
+      tasks.push_back(quick(reactor));
+      tasks.push_back(Recorder(reactor, seen[2], finished[2]));
+      auto [index, value] = co_await async::when_any(std::move(tasks));
+      EXPECT_EQ(index, 1);
+      EXPECT_EQ(value, 1);
+      for (auto i : {0, 2}) {
+        EXPECT_TRUE(co_await WaitFor(reactor, finished[i]));
+        EXPECT_EQ(seen[i].load(), std::errc::operation_canceled);
+      }
+    }
+    EXPECT_EQ(reactor.pendingTimers(), 0);
+  }(rt.reactor()));
+}
+
+TEST(SelectTest, OwnTokenStillStopsABranch)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto own = std::stop_source {};
+    auto seen = std::atomic<std::errc> {};
+    auto finished = std::atomic_bool {false};
+    // the branch token replaces the one the task came with, stopping that one must still reach it
+    auto guarded = [](async::Reactor& reactor, std::stop_token token, std::atomic<std::errc>& seen,
+                      std::atomic_bool& finished) -> async::Task<bool> {
+      auto r = co_await async::timeout(reactor, 10s, async::withStop(Recorder(reactor, seen, finished), token));
+      co_return r.has_value();
+    };
+    auto stopper = [](async::Reactor& reactor, std::stop_source& own) -> async::Task<> {
+      co_await reactor.sleep(5ms);
+      own.request_stop();
+    };
+    auto start = async::TimePoint::clock::now();
+    auto [done, _] = co_await async::when_all(guarded(reactor, own.get_token(), seen, finished), stopper(reactor, own));
+    EXPECT_TRUE(done);
+    EXPECT_LT(async::TimePoint::clock::now() - start, 5s);
+    EXPECT_EQ(seen.load(), std::errc::operation_canceled);
+  }(rt.reactor()));
+}
+
+TEST(SelectTest, WinnerExceptionIsRethrown)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto finished = std::atomic_bool {false};
+    auto fail = []() -> async::Task<int> {
+      throw std::runtime_error("boom");
+      co_return 0;
+    };
+    EXPECT_THROW(co_await async::select(Sleeper(reactor, finished), fail()), std::runtime_error);
+    EXPECT_THROW(co_await async::timeout(reactor, 10s, fail()), std::runtime_error);
+    EXPECT_TRUE(co_await WaitFor(reactor, finished));
+  }(rt.reactor()));
+}
+
+TEST(SelectTest, UnawaitedFreesTheTasks)
+{
+  auto rt = Runtime(1);
+  auto tracker = std::make_shared<int>(0);
+  auto hold = [](std::shared_ptr<int>) -> async::Task<int> { co_return 1; };
+  {
+    auto a = async::timeout(rt.reactor(), 1s, hold(tracker));
+    auto b = async::select(hold(tracker), hold(tracker));
+    auto moved = std::move(b);
+    auto tasks = std::vector<async::Task<int>> {};
+    tasks.push_back(hold(tracker));
+    tasks.push_back(hold(tracker));
+    auto c = async::when_any(std::move(tasks));
+    auto movedAny = std::move(c);
+    EXPECT_EQ(tracker.use_count(), 6);
+  }
+  EXPECT_EQ(tracker.use_count(), 1);
+}
+
+static auto Value(async::Reactor& reactor, int value, std::chrono::milliseconds delay) -> async::Task<int>
+{
+  co_await reactor.sleep(delay);
+  co_return value;
+}
+
+static auto Fail(async::Reactor& reactor, std::chrono::milliseconds delay, std::atomic_int& finished)
+    -> async::Task<int>
+{
+  co_await reactor.sleep(delay);
+  finished.fetch_add(1);
+  throw std::runtime_error("boom");
+  co_return 0;
+}
+
+TEST(WhenAllTest, TupleInOrder)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto name = [](async::Reactor& reactor) -> async::Task<std::string> {
+      co_await reactor.sleep(1ms);
+      co_return "two";
+    };
+    auto [a, b, c] = co_await async::when_all(Value(reactor, 1, 5ms), name(reactor), Value(reactor, 3, 0ms));
+    EXPECT_EQ(a, 1);
+    EXPECT_EQ(b, "two");
+    EXPECT_EQ(c, 3);
+  }(rt.reactor()));
+}
+
+TEST(WhenAllTest, VectorInOrder)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto tasks = std::vector<async::Task<int>> {};
+    for (int i = 0; i < 16; ++i) {
+      tasks.push_back(Value(reactor, i, std::chrono::milliseconds {(16 - i) % 4}));
+    }
+    auto results = co_await async::when_all(std::move(tasks));
+    EXPECT_EQ(results.size(), 16u);
+    for (size_t i = 0; i < results.size(); ++i) {
+      EXPECT_EQ(results[i], static_cast<int>(i));
+    }
+    EXPECT_TRUE((co_await async::when_all(std::vector<async::Task<int>> {})).empty());
+  }(rt.reactor()));
+}
+
+TEST(WhenAllTest, ExceptionAfterEveryoneFinished)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto finished = std::atomic_int {0};
+    auto slow = [](async::Reactor& reactor, std::atomic_int& finished) -> async::Task<int> {
+      co_await reactor.sleep(20ms);
+      finished.fetch_add(1);
+      co_return 1;
+    };
+    EXPECT_THROW(co_await async::when_all(Fail(reactor, 0ms, finished), slow(reactor, finished)), std::runtime_error);
+    EXPECT_EQ(finished.load(), 2);
+    auto tasks = std::vector<async::Task<int>> {};
+    tasks.push_back(slow(reactor, finished));
+    tasks.push_back(Fail(reactor, 1ms, finished));
+    tasks.push_back(Fail(reactor, 0ms, finished));
+    EXPECT_THROW(co_await async::when_all(std::move(tasks)), std::runtime_error);
+    EXPECT_EQ(finished.load(), 5);
+  }(rt.reactor()));
+}
+
+TEST(WhenAllTest, VoidTasks)
+{
+  auto rt = Runtime(2);
+  rt.block([](async::Reactor& reactor) -> async::Task<> {
+    auto count = std::atomic_int {0};
+    auto bump = [](async::Reactor& reactor, std::atomic_int& count) -> async::Task<> {
+      co_await reactor.sleep(1ms);
+      count.fetch_add(1);
+    };
+    co_await async::when_all(bump(reactor, count), bump(reactor, count));
+    EXPECT_EQ(count.load(), 2);
+    auto tasks = std::vector<async::Task<>> {};
+    for (int i = 0; i < 8; ++i) {
+      tasks.push_back(bump(reactor, count));
+    }
+    co_await async::when_all(std::move(tasks));
+    EXPECT_EQ(count.load(), 10);
+  }(rt.reactor()));
+}
@@ -1,4 +1,5 @@
 #include <Async/Slab.hpp>
+#include <algorithm>
 #include <gtest/gtest.h>
 
 TEST(SlabTest, InsertGetRemoveOne)
@@ -81,4 +82,85 @@ TEST(SlabTest, InsertRemoveEntry)
   auto idx = slab.insert(123);
   auto v = slab.tryRemove(idx);
   ASSERT_EQ(v.value(), 123);
-}
\ No newline at end of file
+}
+TEST(ChunkedSlabTest, InsertGetRemoveOne)
+{
+  auto slab = ChunkedSlab<int> {};
+  ASSERT_TRUE(slab.isEmpty());
+  auto key = slab.insert(123);
+  ASSERT_EQ(slab[key], 123);
+  ASSERT_TRUE(slab.contains(key));
+
+  auto v = slab.tryRemove(key);
+  ASSERT_EQ(v.value(), 123);
+  ASSERT_FALSE(slab.contains(key));
+  ASSERT_TRUE(slab.get(key) == nullptr);
+  ASSERT_FALSE(slab.tryRemove(key).has_value());
+  ASSERT_TRUE(slab.get(1 << 20) == nullptr);
+}
+
+TEST(ChunkedSlabTest, AddressesSurviveGrowth)
+{
+  auto slab = ChunkedSlab<int, 64> {};
+  auto first = slab.insert(7);
+  auto address = slab.get(first);
+  for (int i = 0; i < 1000; i++) {
+    slab.insert(i);
+  }
+  ASSERT_GE(slab.capacity(), 1001);
+  ASSERT_EQ(slab.get(first), address);
+  ASSERT_EQ(*address, 7);
+}
+
+TEST(ChunkedSlabTest, ReusesVacantKeys)
+{
+  auto slab = ChunkedSlab<int, 64> {};
+  auto keys = std::vector<size_t> {};
+  for (int i = 0; i < 100; i++) {
+    keys.push_back(slab.insert(i));
+  }
+  slab.tryRemove(keys[10]);
+  slab.tryRemove(keys[70]);
+  ASSERT_EQ(slab.insert(1), keys[70]);
+  ASSERT_EQ(slab.insert(2), keys[10]);
+  ASSERT_EQ(slab.insert(3), 100);
+  ASSERT_EQ(slab.len(), 101);
+  ASSERT_EQ(slab.capacity(), 128);
+}
+
+TEST(ChunkedSlabTest, ForEachVisitsOccupiedInOrder)
+{
+  auto slab = ChunkedSlab<int, 64> {};
+  for (int i = 0; i < 200; i++) {
+    slab.insert(i);
+  }
+  for (size_t key = 0; key < 200; key += 3) {
+    slab.tryRemove(key);
+  }
+  auto seen = std::vector<size_t> {};
+  slab.forEach([&](size_t key, int& value) {
+    ASSERT_EQ(static_cast<size_t>(value), key);
+    seen.push_back(key);
+    slab.tryRemove(key);
+  });
+  ASSERT_EQ(seen.size(), 133);
+  ASSERT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+  ASSERT_TRUE(slab.isEmpty());
+}
+
+TEST(ChunkedSlabTest, DestroysValues)
+{
+  auto counter = std::make_shared<int>(0);
+  {
+    auto slab = ChunkedSlab<std::shared_ptr<int>> {};
+    for (int i = 0; i < 300; i++) {
+      slab.insert(counter);
+    }
+    slab.tryRemove(5);
+    ASSERT_EQ(counter.use_count(), 300);
+    auto moved = std::move(slab);
+    ASSERT_TRUE(slab.isEmpty());
+    ASSERT_EQ(moved.len(), 299);
+  }
+  ASSERT_EQ(counter.use_count(), 1);
+}
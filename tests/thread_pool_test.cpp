@@ -0,0 +1,413 @@
+#include <Async/Executor.hpp>
+#include <Async/Task.hpp>
+#include <Async/ThreadPool.hpp>
+#include <Async/ThreadSafe.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+// polls `done` for up to five seconds
+template <typename Pred>
+static auto WaitUntil(Pred done) -> bool
+{
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(100us);
+  }
+  return true;
+}
+
+static auto Count(std::atomic_int& done) -> async::DetachTask<void>
+{
+  done.fetch_add(1);
+  co_return;
+}
+
+// queues `n` children from inside the pool
+static auto Fan(async::StealingThreadPool& pool, std::atomic_int& done, int n) -> async::DetachTask<void>
+{
+  for (int i = 0; i < n; ++i) {
+    pool.execute(Count(done).handle);
+  }
+  co_return;
+}
+
+// holds its worker until `gate` opens
+static auto Block(std::atomic_int& started, std::atomic_bool& gate) -> async::DetachTask<void>
+{
+  started.fetch_add(1);
+  while (!gate.load()) {
+    std::this_thread::sleep_for(100us);
+  }
+  co_return;
+}
+
+TEST(StealingThreadPoolTest, SpawnInsideAndOutside)
+{
+  auto pool = async::StealingThreadPool(4);
+  auto done = std::atomic_int {0};
+  auto outside = std::thread([&]() {
+    for (int i = 0; i < 2000; ++i) {
+      pool.execute(Count(done).handle);
+    }
+  });
+  for (int i = 0; i < 200; ++i) {
+    pool.execute(Fan(pool, done, 16).handle);
+  }
+  outside.join();
+  EXPECT_TRUE(WaitUntil([&]() { return done.load() == 2000 + 200 * 16; }));
+}
+
+TEST(StealingThreadPoolTest, StealsWhileAWorkerIsBlocked)
+{
+  auto pool = async::StealingThreadPool(2);
+  auto done = std::atomic_int {0};
+  auto stolen = std::atomic_bool {false};
+  auto blocker = [](async::StealingThreadPool& pool, std::atomic_int& done,
+                    std::atomic_bool& stolen) -> async::DetachTask<void> {
+    for (int i = 0; i < 100; ++i) {
+      pool.execute(Count(done).handle);
+    }
+    // all but the one in the LIFO slot sit in this worker's deque, only a thief can run them now
+    stolen = WaitUntil([&]() { return done.load() >= 99; });
+    co_return;
+  };
+  pool.execute(blocker(pool, done, stolen).handle);
+  EXPECT_TRUE(WaitUntil([&]() { return done.load() == 100; }));
+  EXPECT_TRUE(stolen.load());
+}
+
+TEST(StealingThreadPoolTest, InjectorSpills)
+{
+  auto pool = async::StealingThreadPool(2);
+  auto started = std::atomic_int {0};
+  auto gate = std::atomic_bool {false};
+  pool.execute(Block(started, gate).handle);
+  pool.execute(Block(started, gate).handle);
+  ASSERT_TRUE(WaitUntil([&]() { return started.load() == 2; }));
+  // nobody drains the injector, everything past its capacity goes to the overflow list
+  auto done = std::atomic_int {0};
+  auto total = static_cast<int>(async::StealingThreadPool::INJECTOR_CAPACITY * 3);
+  for (int i = 0; i < total; ++i) {
+    pool.execute(Count(done).handle);
+  }
+  EXPECT_EQ(done.load(), 0);
+  gate = true;
+  EXPECT_TRUE(WaitUntil([&]() { return done.load() == total; }));
+}
+
+TEST(DequeTest, EveryItemTakenOnce)
+{
+  constexpr int N = 200000;
+  auto deque = async::spmc::Deque<int>(4); // grows a few times on the way
+  auto taken = std::vector<std::atomic_int>(N);
+  auto stolen = std::atomic_int {0};
+  auto finished = std::atomic_bool {false};
+  auto thieves = std::vector<std::thread> {};
+  for (int t = 0; t < 3; ++t) {
+    thieves.emplace_back([&]() {
+      while (!finished.load()) {
+        if (auto v = deque.steal()) {
+          taken[*v].fetch_add(1);
+          stolen.fetch_add(1);
+        }
+      }
+    });
+  }
+  auto popped = 0;
+  for (int i = 0; i < N; ++i) {
+    deque.push(i);
+    if (i % 3 == 0) {
+      if (auto v = deque.pop()) {
+        taken[*v].fetch_add(1);
+        popped += 1;
+      }
+    }
+  }
+  while (auto v = deque.pop()) {
+    taken[*v].fetch_add(1);
+    popped += 1;
+  }
+  finished = true;
+  for (auto& thief : thieves) {
+    thief.join();
+  }
+  EXPECT_EQ(popped + stolen.load(), N);
+  for (int i = 0; i < N; ++i) {
+    ASSERT_EQ(taken[i].load(), 1) << i;
+  }
+}
+
+TEST(BoundedQueueTest, FullAndOrdered)
+{
+  auto queue = async::mpmc::BoundedQueue<int>(4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.tryPush(i));
+  }
+  EXPECT_FALSE(queue.tryPush(4));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(queue.pop(), i);
+  }
+  EXPECT_EQ(queue.pop(), std::nullopt);
+}
+
+TEST(BoundedQueueTest, ManyProducersAndConsumers)
+{
+  constexpr int PER_PRODUCER = 50000;
+  constexpr int PRODUCERS = 3;
+  auto queue = async::mpmc::BoundedQueue<int>(64);
+  auto taken = std::vector<std::atomic_int>(PER_PRODUCER * PRODUCERS);
+  auto consumed = std::atomic_int {0};
+  auto threads = std::vector<std::thread> {};
+  for (int p = 0; p < PRODUCERS; ++p) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < PER_PRODUCER; ++i) {
+        while (!queue.tryPush(p * PER_PRODUCER + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < 2; ++c) {
+    threads.emplace_back([&]() {
+      while (consumed.load() < PER_PRODUCER * PRODUCERS) {
+        if (auto v = queue.pop()) {
+          taken[*v].fetch_add(1);
+          consumed.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& n : taken) {
+    ASSERT_EQ(n.load(), 1);
+  }
+}
+
+// records the worker it ran on, -1 outside the pool
+static auto Where(async::StealingThreadPool& pool, std::atomic_int& worker) -> async::DetachTask<void>
+{
+  auto id = pool.currentWorker();
+  worker = id ? static_cast<int>(*id) : -1;
+  co_return;
+}
+
+TEST(StealingThreadPoolTest, WokenOnAWorkerRunsThere)
+{
+  auto pool = async::StealingThreadPool(4);
+  for (int round = 0; round < 100; ++round) {
+    auto parent = std::atomic_int {-2};
+    auto child = std::atomic_int {-2};
+    auto spawn = [](async::StealingThreadPool& pool, std::atomic_int& parent,
+                    std::atomic_int& child) -> async::DetachTask<void> {
+      parent = static_cast<int>(pool.currentWorker().value());
+      pool.execute(Where(pool, child).handle); // into the LIFO slot, nobody else can take it
+      co_return;
+    };
+    pool.execute(spawn(pool, parent, child).handle);
+    ASSERT_TRUE(WaitUntil([&]() { return child.load() != -2; }));
+    EXPECT_EQ(child.load(), parent.load());
+  }
+}
+
+TEST(StealingThreadPoolTest, DisplacedFromTheSlotIsStealable)
+{
+  auto pool = async::StealingThreadPool(2);
+  auto parent = std::atomic_int {-2};
+  auto displaced = std::atomic_int {-2};
+  auto slot = std::atomic_int {-2};
+  auto slotWhileBlocked = std::atomic_int {-2};
+  auto spawn = [](async::StealingThreadPool& pool, std::atomic_int& parent, std::atomic_int& displaced,
+                  std::atomic_int& slot, std::atomic_int& slotWhileBlocked) -> async::DetachTask<void> {
+    parent = static_cast<int>(pool.currentWorker().value());
+    pool.execute(Where(pool, displaced).handle);
+    pool.execute(Where(pool, slot).handle); // pushes the first one into the deque
+    // the other worker steals it while this one is busy
+    EXPECT_TRUE(WaitUntil([&]() { return displaced.load() != -2; }));
+    slotWhileBlocked = slot.load();
+    co_return;
+  };
+  pool.execute(spawn(pool, parent, displaced, slot, slotWhileBlocked).handle);
+  ASSERT_TRUE(WaitUntil([&]() { return slot.load() != -2; }));
+  EXPECT_NE(displaced.load(), parent.load());
+  EXPECT_EQ(slotWhileBlocked.load(), -2);
+  EXPECT_EQ(slot.load(), parent.load());
+}
+
+TEST(StealingThreadPoolTest, BurstAfterEveryoneParked)
+{
+  auto pool = async::StealingThreadPool(4);
+  auto parked = [&pool]() {
+    for (size_t id = 0; id < pool.size(); ++id) {
+      if (pool.unparked(id)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  auto done = std::atomic_int {0};
+  auto expected = 0;
+  for (int round = 0; round < 50; ++round) {
+    ASSERT_TRUE(WaitUntil(parked)) << round;
+    // a single handle must wake somebody just like a burst from several threads
+    auto burst = round % 2 == 0 ? 1 : 64;
+    auto threads = std::vector<std::thread> {};
+    for (int t = 0; t < 2; ++t) {
+      threads.emplace_back([&]() {
+        for (int i = 0; i < burst; ++i) {
+          pool.execute(Count(done).handle);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    expected += 2 * burst;
+    ASSERT_TRUE(WaitUntil([&]() { return done.load() == expected; })) << round;
+  }
+}
+
+// runs `fn` on the blocking pool and records it was resumed afterwards
+template <typename Fn>
+static auto Offload(async::BlockingThreadPool& pool, Fn fn, std::atomic_bool& resumed) -> async::DetachTask<void>
+{
+  co_await async::detail::BlockingAwaiter {pool, std::move(fn)};
+  resumed = true;
+}
+
+TEST(BlockingThreadPoolTest, FullQueueSuspendsTheCaller)
+{
+  auto pool = async::BlockingThreadPool({.maxThreads = 1, .queueCapacity = 1});
+  auto gate = std::atomic_bool {false};
+  auto order = std::vector<int> {}; // only touched by the single pool thread
+  auto running = std::atomic_bool {false};
+  auto job = [&](int id) {
+    return [&, id]() {
+      running = true;
+      while (!gate.load()) {
+        std::this_thread::sleep_for(100us);
+      }
+      order.push_back(id);
+    };
+  };
+  auto resumed = std::array<std::atomic_bool, 3> {};
+  Offload(pool, job(0), resumed[0]).handle.resume();
+  ASSERT_TRUE(WaitUntil([&]() { return running.load(); }));
+  Offload(pool, job(1), resumed[1]).handle.resume(); // takes the only queue spot
+  Offload(pool, job(2), resumed[2]).handle.resume(); // no room, returns here suspended
+  auto stats = pool.stats();
+  EXPECT_EQ(stats.queued, 1u);
+  EXPECT_EQ(stats.throttled, 1u);
+  EXPECT_EQ(stats.threads, 1u);
+  for (auto& flag : resumed) {
+    EXPECT_FALSE(flag.load());
+  }
+  gate = true;
+  EXPECT_TRUE(WaitUntil([&]() { return resumed[0] && resumed[1] && resumed[2]; }));
+  EXPECT_EQ(order, (std::vector<int> {0, 1, 2}));
+  stats = pool.stats();
+  EXPECT_EQ(stats.throttledTotal, 1u);
+  EXPECT_EQ(stats.completed, 3u);
+}
+
+TEST(BlockingThreadPoolTest, DestructorJoinsRunningWork)
+{
+  auto done = std::atomic_int {0};
+  auto started = std::atomic_int {0};
+  auto slow = [](std::atomic_int& started, std::atomic_int& done) -> async::DetachTask<void> {
+    started.fetch_add(1);
+    std::this_thread::sleep_for(20ms);
+    done.fetch_add(1);
+    co_return;
+  };
+  {
+    auto pool = async::BlockingThreadPool({.maxThreads = 2, .queueCapacity = 2});
+    for (int i = 0; i < 6; ++i) {
+      pool.execute(slow(started, done).handle);
+    }
+    ASSERT_TRUE(WaitUntil([&]() { return started.load() > 0; }));
+    EXPECT_LT(done.load(), 6);
+  } // running, admitted and throttled jobs all finish before the threads are joined
+  EXPECT_EQ(done.load(), 6);
+}
+
+static auto Record(std::vector<async::Priority>& ran, async::Priority lane, std::atomic_int& done)
+    -> async::DetachTask<void>
+{
+  ran.push_back(lane);
+  done.fetch_add(1);
+  co_return;
+}
+
+TEST(StealingThreadPoolTest, LanesOnOneWorker)
+{
+  using async::Priority;
+  using Pool = async::StealingThreadPool;
+  constexpr int HIGH = 300;
+  constexpr int NORMAL = 40;
+  constexpr int LOW = 6;
+  auto pool = Pool(1);
+  auto started = std::atomic_int {0};
+  auto gate = std::atomic_bool {false};
+  pool.execute(Block(started, gate).handle);
+  ASSERT_TRUE(WaitUntil([&]() { return started.load() == 1; }));
+  // only touched by the worker until `done` says it is through
+  auto ran = std::vector<Priority> {};
+  auto done = std::atomic_int {0};
+  for (int i = 0; i < LOW; ++i) {
+    pool.execute(Record(ran, Priority::Low, done).handle, Priority::Low);
+  }
+  for (int i = 0; i < NORMAL; ++i) {
+    pool.execute(Record(ran, Priority::Normal, done).handle, Priority::Normal);
+  }
+  for (int i = 0; i < HIGH; ++i) {
+    pool.execute(Record(ran, Priority::High, done).handle, Priority::High);
+  }
+  gate = true;
+  ASSERT_TRUE(WaitUntil([&]() { return done.load() == HIGH + NORMAL + LOW; }));
+
+  // the picks are consecutive from here on, only where the worker's pick counter stood is unknown
+  auto simulate = [](uint32_t pick) {
+    auto left = std::array<int, 3> {HIGH, NORMAL, LOW};
+    auto order = std::vector<Priority> {};
+    while (left[0] + left[1] + left[2] > 0) {
+      auto lanes = pick % Pool::LOW_TURN == 0      ? std::array<int, 3> {2, 0, 1}
+                   : pick % Pool::NORMAL_TURN == 0 ? std::array<int, 3> {1, 0, 2}
+                                                   : std::array<int, 3> {0, 1, 2};
+      for (auto lane : lanes) {
+        if (left[lane] > 0) {
+          left[lane] -= 1;
+          order.push_back(static_cast<Priority>(lane));
+          break;
+        }
+      }
+      pick += 1;
+    }
+    return order;
+  };
+  auto matched = false;
+  for (uint32_t phase = 0; phase < Pool::LOW_TURN && !matched; ++phase) {
+    matched = ran == simulate(phase);
+  }
+  EXPECT_TRUE(matched);
+
+  auto first = [&ran](Priority lane) { return std::find(ran.begin(), ran.end(), lane) - ran.begin(); };
+  EXPECT_LT(first(Priority::Normal), Pool::NORMAL_TURN);
+  EXPECT_LT(first(Priority::Low), Pool::LOW_TURN);
+  // High gets every pick but the turns of the others
+  auto high = std::count(ran.begin(), ran.begin() + 2 * Pool::LOW_TURN, Priority::High);
+  EXPECT_EQ(high, 2 * Pool::LOW_TURN - 2 * Pool::LOW_TURN / Pool::NORMAL_TURN);
+}
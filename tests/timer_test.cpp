@@ -0,0 +1,88 @@
+#include <Async/Timer.hpp>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace std::chrono_literals;
+using async::TimePoint;
+
+static auto Handle(size_t id) -> std::coroutine_handle<>
+{
+  return std::coroutine_handle<>::from_address(reinterpret_cast<void*>(id + 1));
+}
+
+TEST(TimerWheelTest, FireInOrder)
+{
+  auto start = TimePoint::clock::now();
+  auto wheel = async::TimerWheel {1ms, start};
+  wheel.insert(start + 5ms, 0, Handle(0));
+  wheel.insert(start + 3s, 1, Handle(1));
+  wheel.insert(start + 70ms, 2, Handle(2));
+  ASSERT_EQ(wheel.size(), 3);
+  ASSERT_EQ(wheel.nextDeadline(), start + 5ms);
+
+  auto out = std::vector<std::coroutine_handle<>> {};
+  ASSERT_EQ(wheel.popExpired(start + 4ms, out), 0);
+  ASSERT_EQ(wheel.popExpired(start + 5ms, out), 1);
+  ASSERT_EQ(out.back(), Handle(0));
+  ASSERT_EQ(wheel.popExpired(start + 100ms, out), 1);
+  ASSERT_EQ(out.back(), Handle(2));
+  ASSERT_LE(wheel.nextDeadline().value(), start + 3s);
+  ASSERT_EQ(wheel.popExpired(start + 3s, out), 1);
+  ASSERT_EQ(out.back(), Handle(1));
+  ASSERT_EQ(wheel.size(), 0);
+  ASSERT_FALSE(wheel.nextDeadline().has_value());
+}
+
+TEST(TimerWheelTest, RemoveAndPastDeadline)
+{
+  auto start = TimePoint::clock::now();
+  auto wheel = async::TimerWheel {1ms, start};
+  wheel.insert(start + 10ms, 0, Handle(0));
+  ASSERT_EQ(wheel.remove(start + 10ms, 0), Handle(0));
+  ASSERT_EQ(wheel.remove(start + 10ms, 0), nullptr);
+  ASSERT_FALSE(wheel.nextDeadline().has_value());
+
+  wheel.insert(start - 1s, 1, Handle(1));
+  ASSERT_LE(wheel.nextDeadline().value(), start);
+  auto out = std::vector<std::coroutine_handle<>> {};
+  ASSERT_EQ(wheel.popExpired(start, out), 1);
+}
+
+TEST(TimerWheelTest, MatchTimerMap)
+{
+  auto start = TimePoint::clock::now();
+  auto wheel = async::TimerWheel {1ms, start};
+  auto map = async::TimerMap {};
+  auto rng = std::mt19937_64 {42};
+  auto dist = std::uniform_int_distribution<int64_t> {0, 5'000'000};
+  auto whens = std::vector<TimePoint> {};
+
+  for (size_t id = 0; id < 20000; ++id) {
+    auto when = start + std::chrono::milliseconds(dist(rng)) + std::chrono::microseconds(dist(rng) % 1000);
+    whens.push_back(when);
+    wheel.insert(when, id, Handle(id));
+    map.insert(when, id, Handle(id));
+  }
+  for (size_t id = 0; id < 20000; id += 7) {
+    ASSERT_EQ(wheel.remove(whens[id], id), map.remove(whens[id], id));
+  }
+
+  auto now = start;
+  while (map.size() != 0) {
+    // never fire early, at most one tick late
+    auto next = wheel.nextDeadline();
+    ASSERT_TRUE(next.has_value());
+    ASSERT_LE(next.value(), map.nextDeadline().value() + 1ms);
+    now = std::max(now, next.value()) + std::chrono::milliseconds(dist(rng) % 3000);
+    auto a = std::vector<std::coroutine_handle<>> {};
+    auto b = std::vector<std::coroutine_handle<>> {};
+    wheel.popExpired(now, a);
+    map.popExpired(now, b);
+    auto cmp = [](auto x, auto y) { return x.address() < y.address(); };
+    std::sort(a.begin(), a.end(), cmp);
+    std::sort(b.begin(), b.end(), cmp);
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(wheel.size(), map.size());
+  }
+}
@@ -0,0 +1,88 @@
+#include <Async/sys/Topology.hpp>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// two packages with one NUMA node each, two cores per package and two threads per core; only the first package
+// reports its L3, the second one falls back to the package siblings
+class FakeSysfs : public testing::Test {
+protected:
+  void SetUp() override
+  {
+    mRoot = fs::temp_directory_path() / ("async_topology_" + std::to_string(::getpid()));
+    fs::remove_all(mRoot);
+    for (uint32_t cpu = 0; cpu < 8; ++cpu) {
+      auto dir = mRoot / ("cpu" + std::to_string(cpu));
+      auto package = cpu / 4;
+      auto first = package * 4;
+      auto core = cpu & ~1u;
+      Write(dir / "topology/physical_package_id", std::to_string(package));
+      Write(dir / "topology/thread_siblings_list", std::to_string(core) + "-" + std::to_string(core + 1));
+      Write(dir / "topology/core_siblings_list", std::to_string(first) + "-" + std::to_string(first + 3));
+      if (package == 0) {
+        Write(dir / "cache/index3/shared_cpu_list", "0-3");
+      }
+      fs::create_directories(dir / ("node" + std::to_string(package)));
+    }
+  }
+  void TearDown() override { fs::remove_all(mRoot); }
+
+  static auto Write(fs::path const& path, std::string const& text) -> void
+  {
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << text << "\n";
+  }
+
+  fs::path mRoot;
+};
+
+TEST_F(FakeSysfs, Parse)
+{
+  auto topology = async::Topology::Parse(mRoot.string(), {0, 1, 2, 3, 4, 5, 6, 7});
+  auto const& cpus = topology.cpus();
+  ASSERT_EQ(cpus.size(), 8u);
+  for (auto const& info : cpus) {
+    EXPECT_EQ(info.core, info.cpu & ~1u) << info.cpu;
+    EXPECT_EQ(info.cache, info.cpu / 4 * 4) << info.cpu;
+    EXPECT_EQ(info.node, info.cpu / 4) << info.cpu;
+    EXPECT_EQ(info.package, info.cpu / 4) << info.cpu;
+  }
+  // a cpu missing from the tree is its own core, cache and node
+  auto lone = async::Topology::Parse(mRoot.string(), {9}).cpus().at(0);
+  EXPECT_EQ(lone.core, 9u);
+  EXPECT_EQ(lone.cache, 9u);
+  EXPECT_EQ(lone.node, 0u);
+}
+
+TEST_F(FakeSysfs, StealOrderGoesOutward)
+{
+  auto topology = async::Topology::Parse(mRoot.string(), {0, 1, 2, 3, 4, 5, 6, 7});
+  auto placement = topology.place(8);
+  auto placed = std::vector<uint32_t> {};
+  for (auto const& info : placement) {
+    placed.push_back(info.cpu);
+  }
+  // every core gets a worker before any SMT sibling does, node by node
+  EXPECT_EQ(placed, (std::vector<uint32_t> {0, 2, 4, 6, 1, 3, 5, 7}));
+
+  auto orders = async::Topology::StealOrder(placement);
+  ASSERT_EQ(orders.size(), 8u);
+  // worker 0 on cpu 0: its sibling on cpu 1, then cpus 2 and 3 behind the same L3, then the other node
+  EXPECT_EQ(orders[0], (std::vector<uint32_t> {4, 1, 5, 2, 3, 6, 7}));
+  // worker 3 on cpu 6: sibling cpu 7, then cpus 5 and 4 of its package, then the first node, all in ring order
+  EXPECT_EQ(orders[3], (std::vector<uint32_t> {7, 6, 2, 4, 5, 0, 1}));
+  for (size_t id = 0; id < orders.size(); ++id) {
+    auto const& self = placement[id];
+    auto previous = async::Topology::SAME_CPU;
+    for (auto victim : orders[id]) {
+      auto distance = async::Topology::DistanceOf(self, placement[victim]);
+      EXPECT_LE(previous, distance) << id;
+      previous = distance;
+    }
+  }
+}